@@ -0,0 +1,345 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ecsm.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+using namespace ecsm;
+
+struct BenchItem final
+{
+	uint64_t data[4] = {};
+	bool destroy() { return true; }
+};
+
+template<int I>
+struct BenchComponent final : public Component
+{
+	uint64_t data[4] = {};
+};
+
+template<int I>
+class BenchSystem final : public ComponentSystem<BenchComponent<I>, false>
+{
+	friend class ecsm::Manager;
+public:
+	const LinearPool<BenchComponent<I>, false>& getComponents() const noexcept { return this->components; }
+};
+
+struct BenchSoaComponent final : public Component { };
+
+class BenchSoaSystem final : public SoaComponentSystem<BenchSoaComponent, uint64_t, uint64_t, uint64_t, uint64_t>
+{
+	friend class ecsm::Manager;
+};
+
+struct BenchCounter final
+{
+	uint64_t value = 0;
+	void increment() { value++; }
+};
+
+constexpr int benchComponentCount = 8;
+static const char* benchFilter = nullptr;
+static uint32_t maxItemCount = 1000000;
+static volatile uint64_t benchSink = 0;
+
+//**********************************************************************************************************************
+static double getElapsedTime(chrono::high_resolution_clock::time_point start)
+{
+	auto elapsed = chrono::high_resolution_clock::now() - start;
+	return chrono::duration_cast<chrono::duration<double, nano>>(elapsed).count();
+}
+static void printResult(const char* name, uint32_t itemCount, double totalTime)
+{
+	printf("%-32s %10u items %14.0f ns %10.2f ns/item\n", name, itemCount, totalTime, totalTime / itemCount);
+}
+static void printBandwidth(const char* name, uint32_t itemCount, double totalTime, size_t itemSize)
+{
+	printf("%-32s %10u items %14.0f ns %10.2f ns/item %8.2f GB/s\n", name, itemCount,
+		totalTime, totalTime / itemCount, (double)itemCount * itemSize / totalTime);
+}
+static bool isBenchEnabled(const char* name)
+{
+	return !benchFilter || strstr(name, benchFilter);
+}
+
+template<int... I>
+static void createBenchSystems(Manager* manager, std::integer_sequence<int, I...>)
+{
+	(manager->createSystem<BenchSystem<I>>(), ...);
+}
+static Manager* createBenchManager()
+{
+	auto manager = new Manager();
+	createBenchSystems(manager, std::make_integer_sequence<int, benchComponentCount>());
+	manager->initialize();
+	return manager;
+}
+template<int... I>
+static void addBenchComponents(Manager* manager, ID<Entity> entity, std::integer_sequence<int, I...>)
+{
+	(manager->add<BenchComponent<I>>(entity), ...);
+}
+
+//**********************************************************************************************************************
+static void benchPoolGrowth(uint32_t itemCount)
+{
+	{
+		LinearPool<BenchItem> pool;
+		auto start = chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < itemCount; i++)
+			pool.create();
+		printResult("LinearPool::create()", itemCount, getElapsedTime(start));
+	}
+	{
+		ChunkedPool<BenchItem> pool;
+		auto start = chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < itemCount; i++)
+			pool.create();
+		printResult("ChunkedPool::create()", itemCount, getElapsedTime(start));
+	}
+}
+static void benchPoolDispose(uint32_t itemCount)
+{
+	LinearPool<BenchItem> pool;
+	vector<ID<BenchItem>> items(itemCount);
+
+	for (uint32_t i = 0; i < itemCount; i++)
+		items[i] = pool.create();
+	for (uint32_t i = 0; i < itemCount; i++)
+		pool.destroy(items[i]);
+
+	auto start = chrono::high_resolution_clock::now();
+	pool.dispose();
+	printResult("LinearPool::dispose()", itemCount, getElapsedTime(start));
+}
+
+//**********************************************************************************************************************
+static void benchEntities(uint32_t entityCount)
+{
+	auto manager = createBenchManager();
+	vector<ID<Entity>> entities(entityCount);
+
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < entityCount; i++)
+		entities[i] = manager->createEntity();
+	printResult("Manager::createEntity()", entityCount, getElapsedTime(start));
+
+	start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < entityCount; i++)
+		manager->destroy(entities[i]);
+	manager->update();
+	printResult("Manager::destroy()", entityCount, getElapsedTime(start));
+
+	start = chrono::high_resolution_clock::now();
+	manager->createEntities(entities.data(), entityCount);
+	printResult("Manager::createEntities()", entityCount, getElapsedTime(start));
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+template<int I>
+static void benchComponentAccess(Manager* manager, const vector<ID<Entity>>& entities, int componentCount)
+{
+	if constexpr (I < benchComponentCount)
+	{
+		if (I == componentCount - 1)
+		{
+			char name[64];
+			auto entityCount = (uint32_t)entities.size();
+
+			auto start = chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < entityCount; i++)
+				manager->add<BenchComponent<I>>(entities[i]);
+			snprintf(name, sizeof(name), "Manager::add() %d comps", componentCount);
+			printResult(name, entityCount, getElapsedTime(start));
+
+			uint64_t sum = 0;
+			start = chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < entityCount; i++)
+				sum += manager->get<BenchComponent<I>>(entities[i])->data[0];
+			snprintf(name, sizeof(name), "Manager::get() %d comps", componentCount);
+			printResult(name, entityCount, getElapsedTime(start));
+			benchSink = sum;
+
+			start = chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < entityCount; i++)
+				manager->remove<BenchComponent<I>>(entities[i]);
+			manager->update();
+			snprintf(name, sizeof(name), "Manager::remove() %d comps", componentCount);
+			printResult(name, entityCount, getElapsedTime(start));
+
+			for (uint32_t i = 0; i < entityCount; i++)
+				manager->add<BenchComponent<I>>(entities[i]);
+			return;
+		}
+
+		benchComponentAccess<I + 1>(manager, entities, componentCount);
+	}
+}
+static void benchComponents(uint32_t entityCount)
+{
+	auto manager = createBenchManager();
+	auto entities = manager->createEntities(entityCount);
+
+	for (int componentCount = 1; componentCount <= benchComponentCount; componentCount++)
+		benchComponentAccess<0>(manager, entities, componentCount);
+
+	delete manager;
+}
+static void benchDuplicate(uint32_t entityCount)
+{
+	auto manager = createBenchManager();
+	auto entity = manager->createEntity();
+	addBenchComponents(manager, entity, std::make_integer_sequence<int, benchComponentCount>());
+
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < entityCount; i++)
+		manager->duplicate(entity);
+	printResult("Manager::duplicate() 8 comps", entityCount, getElapsedTime(start));
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void benchSystems(uint32_t lookupCount)
+{
+	auto manager = createBenchManager();
+
+	uintptr_t sum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < lookupCount; i++)
+		sum += (uintptr_t)manager->get<BenchSystem<benchComponentCount - 1>>();
+	printResult("Manager::get<System>()", lookupCount, getElapsedTime(start));
+
+	start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < lookupCount; i++)
+		sum += (uintptr_t)manager->get(getTypeIndex<BenchSystem<benchComponentCount - 1>>());
+	printResult("Manager::get(TypeIndex)", lookupCount, getElapsedTime(start));
+	benchSink = sum;
+
+	delete manager;
+}
+static void benchEvents(uint32_t subscriberCount)
+{
+	auto manager = createBenchManager();
+	manager->registerEvent("Bench");
+
+	vector<BenchCounter> counters(subscriberCount);
+	for (auto& counter : counters)
+		manager->subscribeToEvent("Bench", Delegate::create<&BenchCounter::increment>(&counter));
+
+	const uint32_t runCount = 1000;
+	auto event = manager->getEventID("Bench");
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < runCount; i++)
+		manager->runEvent(event);
+	auto elapsedTime = getElapsedTime(start);
+
+	char name[64];
+	snprintf(name, sizeof(name), "Manager::runEvent() %u subs", subscriberCount);
+	printResult(name, runCount * subscriberCount, elapsedTime);
+	benchSink = counters[0].value;
+
+	delete manager;
+}
+static void benchIteration(uint32_t componentCount)
+{
+	auto manager = createBenchManager();
+	auto entities = manager->createEntities(componentCount);
+	manager->add<BenchComponent<0>>(entities);
+
+	const auto& components = manager->get<BenchSystem<0>>()->getComponents();
+	uint64_t sum = 0;
+	auto start = chrono::high_resolution_clock::now();
+	for (const auto& component : components)
+		sum += component.data[0] + component.data[3];
+	printBandwidth("ComponentSystem iteration", componentCount,
+		getElapsedTime(start), sizeof(BenchComponent<0>));
+
+	manager->createSystem<BenchSoaSystem>();
+	manager->add<BenchSoaComponent>(entities);
+	auto& fields = manager->get<BenchSoaSystem>()->getComponents();
+	start = chrono::high_resolution_clock::now();
+	fields.each([&sum](uint64_t& a, uint64_t&, uint64_t&, uint64_t& d) { sum += a + d; });
+	printBandwidth("SoaComponentSystem iteration", componentCount,
+		getElapsedTime(start), sizeof(uint64_t) * 2);
+	benchSink = sum;
+
+	delete manager;
+}
+
+static void benchSnapshot(uint32_t entityCount)
+{
+	auto manager = createBenchManager();
+	auto entities = manager->createEntities(entityCount);
+	manager->add<BenchComponent<0>>(entities);
+	manager->add<BenchComponent<1>>(entities);
+
+	SnapshotWriter writer;
+	auto start = chrono::high_resolution_clock::now();
+	manager->writeSnapshot(writer);
+	printResult("Manager::writeSnapshot() 2 comps", entityCount, getElapsedTime(start));
+
+	const auto& data = writer.getData();
+	SnapshotReader reader(data.data(), data.size());
+	start = chrono::high_resolution_clock::now();
+	manager->readSnapshot(reader);
+	printResult("Manager::readSnapshot() 2 comps", entityCount, getElapsedTime(start));
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && strcmp(argv[1], "all") != 0)
+		benchFilter = argv[1];
+	if (argc > 2)
+		maxItemCount = (uint32_t)strtoul(argv[2], nullptr, 10);
+
+	for (uint32_t itemCount = 1000; itemCount <= maxItemCount; itemCount *= 10)
+	{
+		if (isBenchEnabled("pool"))
+		{
+			benchPoolGrowth(itemCount);
+			benchPoolDispose(itemCount);
+		}
+		if (isBenchEnabled("entity"))
+			benchEntities(itemCount);
+		if (isBenchEnabled("component"))
+			benchComponents(itemCount);
+		if (isBenchEnabled("system"))
+			benchSystems(itemCount);
+		if (isBenchEnabled("duplicate"))
+			benchDuplicate(itemCount);
+		if (isBenchEnabled("iteration"))
+			benchIteration(itemCount);
+		if (isBenchEnabled("snapshot"))
+			benchSnapshot(itemCount);
+	}
+
+	if (isBenchEnabled("event"))
+	{
+		for (uint32_t subscriberCount = 1; subscriberCount <= 1000; subscriberCount *= 10)
+			benchEvents(subscriberCount);
+	}
+}
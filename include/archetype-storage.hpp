@@ -0,0 +1,336 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Archetype based component storage classes.
+ */
+
+#pragma once
+#include "linear-pool.hpp"
+#include "type-string.hpp"
+
+#include <map>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <unordered_map>
+
+namespace ecsm
+{
+
+class Entity;
+
+/***********************************************************************************************************************
+ * @brief Component storage grouping entities by their component set.
+ *
+ * @details
+ * Archetype is a unique set of component types. All entities with the same archetype component set are stored
+ * in one table, where each component type has its own contiguous memory column (SoA). Adding or removing
+ * archetype component moves entity row to the other archetype table. Systems reading several components of the
+ * same entity can stream through the archetype columns linearly instead of jumping between component pools.
+ *
+ * @warning Adding or removing components moves entity rows and invalidates all previous @ref View.
+ */
+class ArchetypeStorage final
+{
+public:
+	/**
+	 * @brief Type erased archetype component type functions.
+	 */
+	struct ColumnType final
+	{
+		size_t size = 0;
+		size_t alignment = 0;
+		void (*construct)(void* item) = nullptr;
+		void (*destruct)(void* item) noexcept = nullptr;
+		void (*relocate)(void* destination, void* source) noexcept = nullptr;
+	};
+	/**
+	 * @brief Archetype component column memory.
+	 */
+	struct Column final
+	{
+		uint8_t* data = nullptr;
+		uint32_t type = 0;
+	};
+
+	/**
+	 * @brief Table of entities with the same component set.
+	 */
+	class Archetype final
+	{
+		std::vector<uint32_t> types;
+		std::vector<Column> columns;
+		std::vector<ID<Entity>> entities;
+		std::unordered_map<uint32_t, Archetype*> addEdges;
+		std::unordered_map<uint32_t, Archetype*> removeEdges;
+		uint32_t capacity = 0;
+		friend class ArchetypeStorage;
+	public:
+		/**
+		 * @brief Returns archetype component types. (Sorted)
+		 */
+		const std::vector<uint32_t>& getTypes() const noexcept { return types; }
+		/**
+		 * @brief Returns archetype entity array. (Row to entity)
+		 */
+		const std::vector<ID<Entity>>& getEntities() const noexcept { return entities; }
+		/**
+		 * @brief Returns archetype entity count.
+		 */
+		uint32_t getCount() const noexcept { return (uint32_t)entities.size(); }
+
+		/**
+		 * @brief Returns archetype column index of the component type, or -1 if not found.
+		 * @param type target storage component type
+		 */
+		int32_t findColumn(uint32_t type) const noexcept
+		{
+			auto result = std::lower_bound(types.begin(), types.end(), type);
+			if (result == types.end() || *result != type)
+				return -1;
+			return (int32_t)(result - types.begin());
+		}
+		/**
+		 * @brief Returns archetype component column data, or nullptr if not found.
+		 * @param type target storage component type
+		 * @tparam T type of the component
+		 */
+		template<class T>
+		T* getColumn(uint32_t type) const noexcept
+		{
+			auto index = findColumn(type);
+			return index < 0 ? nullptr : (T*)columns[index].data;
+		}
+	};
+
+	using ColumnTypes = std::vector<ColumnType>;
+	using TypeIDs = std::unordered_map<TypeIndex, uint32_t>;
+	using Archetypes = std::map<std::vector<uint32_t>, Archetype*>;
+private:
+	struct Record final
+	{
+		Archetype* archetype = nullptr;
+		uint32_t row = 0;
+	};
+
+	ColumnTypes columnTypes;
+	TypeIDs typeIDs;
+	Archetypes archetypes;
+	std::vector<Record> records;
+
+	#ifndef NDEBUG
+	uint64_t version = 0;
+	bool isChanging = false;
+	#endif
+
+	Archetype* findArchetype(const std::vector<uint32_t>& types);
+	Archetype* getAddArchetype(Archetype* archetype, uint32_t type);
+	Archetype* getRemoveArchetype(Archetype* archetype, uint32_t type);
+	uint32_t addRow(Archetype* archetype, ID<Entity> entity);
+	void removeRow(Archetype* archetype, uint32_t row) noexcept;
+	void moveEntity(ID<Entity> entity, Archetype* newArchetype, uint32_t addedType, uint32_t removedType);
+	void* getItem(ID<Entity> entity, uint32_t type) const noexcept;
+
+	template<class T>
+	static void constructItem(void* item) { new (item) T(); }
+	template<class T>
+	static void destructItem(void* item) noexcept { ((T*)item)->~T(); }
+	template<class T>
+	static void relocateItem(void* destination, void* source) noexcept
+	{
+		new (destination) T(std::move(*((T*)source)));
+		((T*)source)->~T();
+	}
+
+	template<class... Components, size_t... I, class Function>
+	static void eachArchetype(const Archetype* archetype, const uint32_t* types,
+		std::index_sequence<I...>, Function& function)
+	{
+		auto columns = std::make_tuple(archetype->getColumn<Components>(types[I])...);
+		auto entities = archetype->entities.data();
+		auto count = (uint32_t)archetype->entities.size();
+
+		for (uint32_t row = 0; row < count; row++)
+			function(entities[row], std::get<I>(columns)[row]...);
+	}
+public:
+	/**
+	 * @brief Creates a new empty archetype storage.
+	 */
+	ArchetypeStorage() = default;
+	/**
+	 * @brief Destroys all archetype components and deallocates memory.
+	 */
+	~ArchetypeStorage();
+
+	ArchetypeStorage(const ArchetypeStorage&) = delete;
+	ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+	/*******************************************************************************************************************
+	 * @brief Registers a new archetype component type.
+	 * @details Returns existing storage component type if it is already registered.
+	 * @tparam T type of the component
+	 */
+	template<class T>
+	uint32_t registerType()
+	{
+		static_assert(std::is_default_constructible_v<T>, "Must be default constructible.");
+		static_assert(std::is_nothrow_move_constructible_v<T>, "Must be nothrow move constructible.");
+
+		auto result = typeIDs.emplace(getTypeIndex<T>(), (uint32_t)columnTypes.size());
+		if (!result.second)
+			return result.first->second;
+
+		ColumnType columnType;
+		columnType.size = sizeof(T);
+		columnType.alignment = alignof(T);
+		columnType.construct = constructItem<T>;
+		columnType.destruct = destructItem<T>;
+		columnType.relocate = relocateItem<T>;
+		columnTypes.push_back(columnType);
+		return result.first->second;
+	}
+	/**
+	 * @brief Returns archetype storage component type.
+	 * @tparam T type of the component
+	 * @throw EcsmError if component type is not registered.
+	 */
+	template<class T>
+	uint32_t getTypeID() const
+	{
+		auto result = typeIDs.find(getTypeIndex<T>());
+		if (result == typeIDs.end())
+			throw EcsmError("Archetype component is not registered. (type: " + typeToString(getTypeIndex<T>()) + ")");
+		return result->second;
+	}
+
+	/**
+	 * @brief Adds a new default constructed component to the entity.
+	 * @details Moves entity to the archetype containing target component type.
+	 *
+	 * @param entity target entity instance
+	 * @param type target storage component type
+	 * @return Pointer to the created component memory.
+	 *
+	 * @throw EcsmError if component is already added.
+	 */
+	void* add(ID<Entity> entity, uint32_t type);
+	/**
+	 * @brief Removes and destructs entity component.
+	 * @details Moves entity to the archetype without target component type.
+	 *
+	 * @param entity target entity instance
+	 * @param type target storage component type
+	 *
+	 * @throw EcsmError if component is not added.
+	 */
+	void remove(ID<Entity> entity, uint32_t type);
+
+	/*******************************************************************************************************************
+	 * @brief Returns true if entity has target component.
+	 * @param entity target entity instance
+	 * @param type target storage component type
+	 */
+	bool has(ID<Entity> entity, uint32_t type) const noexcept { return getItem(entity, type); }
+	/**
+	 * @brief Returns entity component @ref View, or null if component is not added.
+	 * @warning Do not store views, use them only in place. Because archetype rows can be moved later.
+	 *
+	 * @param entity target entity instance
+	 * @param type target storage component type
+	 * @tparam T type of the component
+	 */
+	template<class T>
+	View<T> get(ID<Entity> entity, uint32_t type) const noexcept
+	{
+		auto item = (T*)getItem(entity, type);
+		if (!item)
+			return {};
+		#ifndef NDEBUG
+		return View<T>(item, version);
+		#else
+		return View<T>(item);
+		#endif
+	}
+
+	/**
+	 * @brief Returns archetype of the entity, or nullptr if entity has no archetype components.
+	 * @param entity target entity instance
+	 */
+	const Archetype* getArchetype(ID<Entity> entity) const noexcept
+	{
+		assert(entity);
+		auto index = *entity - 1;
+		return index < records.size() ? records[index].archetype : nullptr;
+	}
+	/**
+	 * @brief Returns all storage archetypes.
+	 */
+	const Archetypes& getArchetypes() const noexcept { return archetypes; }
+	/**
+	 * @brief Returns all registered component types.
+	 */
+	const TypeIDs& getTypeIDs() const noexcept { return typeIDs; }
+
+	/*******************************************************************************************************************
+	 * @brief Calls function for each entity containing all target components.
+	 *
+	 * @details
+	 * Iterates over all archetypes containing target component types, streaming through their
+	 * component columns linearly. Function signature: void(ID<Entity>, Components&...)
+	 *
+	 * @warning Do not add or remove archetype components inside the function.
+	 * @param function target function to call
+	 * @tparam Components target archetype component types
+	 */
+	template<class... Components, class Function>
+	void each(Function&& function)
+	{
+		static_assert(sizeof...(Components) > 0, "Must have at least one component type.");
+		const uint32_t types[] = { getTypeID<Components>()... };
+
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Iteration of the archetypes inside other add/remove is not allowed.");
+		isChanging = true;
+		#endif
+
+		for (const auto& pair : archetypes)
+		{
+			auto archetype = pair.second;
+			if (archetype->entities.empty())
+				continue;
+
+			auto hasTypes = true;
+			for (auto type : types)
+			{
+				if (archetype->findColumn(type) >= 0)
+					continue;
+				hasTypes = false;
+				break;
+			}
+
+			if (hasTypes)
+				eachArchetype<Components...>(archetype, types, std::index_sequence_for<Components...>(), function);
+		}
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+};
+
+} // namespace ecsm
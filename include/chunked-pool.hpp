@@ -0,0 +1,1091 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ */
+
+#pragma once
+#include "linear-pool.hpp"
+
+namespace ecsm
+{
+
+/***********************************************************************************************************************
+ * @brief Item array with fixed size memory chunks.
+ *
+ * @details
+ * Chunked pool stores items in the fixed size memory chunks (pages) which are never relocated. Growing the pool
+ * costs only one chunk allocation, without moving previously created items, so item pointers and @ref View stay
+ * valid until the item is destroyed. Items inside one chunk are placed sequentially in memory, which keeps the
+ * cache locality of the @ref LinearPool while avoiding latency and memory spikes on the pool growth.
+ *
+ * @tparam T type of the item in the chunked pool
+ * @tparam DestroyItems chunked pool should call destroy() function of the items
+ * @tparam ChunkSize item count in one memory chunk (power of two)
+ */
+template<class T, bool DestroyItems /* = true */, uint32_t ChunkSize /* = 1024 */>
+class ChunkedPool final
+{
+	static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "Chunk size must be a power of two.");
+
+	std::pmr::memory_resource* memoryResource = nullptr;
+	std::pmr::vector<T*> chunks;
+	uint32_t occupancy = 0, reservedChunkCount = 0;
+	std::pmr::vector<ID<T>> freeItems;
+	std::pmr::vector<ID<T>> garbageItems;
+	std::pmr::vector<uint32_t> liveItems;
+	std::pmr::vector<uint32_t> livePositions;
+	std::pmr::vector<uint8_t> garbageFlags;
+	std::pmr::vector<uint32_t> generations;
+	std::pmr::vector<uint64_t> changeVersions;
+	std::pmr::vector<std::pair<uint64_t, uint32_t>> changedItems;
+	RefCounters refCounters;
+
+	#ifndef NDEBUG
+	uint64_t version = 0;
+	ChangeState isChanging;
+	#endif
+	uint64_t changeVersion = 1;
+	bool lowestFreeFirst = false;
+	bool trackChanges = false;
+
+	static bool isHigherItem(ID<T> a, ID<T> b) noexcept { return b < a; }
+
+	void pushFreeItem(ID<T> item)
+	{
+		freeItems.push_back(item);
+		if (lowestFreeFirst)
+			std::push_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+	}
+	ID<T> popFreeItem() noexcept
+	{
+		if (lowestFreeFirst)
+			std::pop_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+		auto freeItem = freeItems.back();
+		freeItems.pop_back();
+		return freeItem;
+	}
+
+	T& getItem(uint32_t index) const noexcept { return chunks[index / ChunkSize][index & (ChunkSize - 1)]; }
+
+	// Chunks memory is not initialized, only live and garbage item slots contain constructed items.
+	void allocateChunk()
+	{
+		chunks.push_back((T*)memoryResource->allocate(ChunkSize * sizeof(T), alignof(T)));
+	}
+	void deallocateChunk(T* chunk) noexcept
+	{
+		memoryResource->deallocate(chunk, ChunkSize * sizeof(T), alignof(T));
+	}
+	void destructItems() noexcept
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			for (auto index : liveItems)
+				getItem(index).~T();
+		}
+	}
+
+	ID<T> getSlotID(uint32_t index) const noexcept { return ID<T>(index + 1, generations[index]); }
+	void freeSlot(ID<T> item)
+	{
+		// Generation increment makes all previous identifiers of the slot stale.
+		pushFreeItem(ID<T>(*item, ++generations[*item - 1]));
+		refCounters.reset(*item - 1);
+	}
+
+	void addLiveItem(uint32_t index)
+	{
+		livePositions[index] = (uint32_t)liveItems.size();
+		liveItems.push_back(index);
+		if (trackChanges)
+			markSlotChanged(index);
+	}
+	void markSlotChanged(uint32_t index)
+	{
+		if (index >= (uint32_t)changeVersions.size())
+			changeVersions.resize(index + 1, 0);
+		if (changeVersions[index] == changeVersion) // Item is already in the changed item list.
+			return;
+		changeVersions[index] = changeVersion;
+		changedItems.emplace_back(changeVersion, index);
+	}
+	// Called only on dispose, so destroying items during the iteration does not reorder the live item array.
+	void removeLiveItem(uint32_t index) noexcept
+	{
+		auto position = livePositions[index];
+		auto lastItem = liveItems.back();
+		liveItems[position] = lastItem;
+		livePositions[lastItem] = position;
+		livePositions[index] = UINT32_MAX;
+		garbageFlags[index] = false;
+		liveItems.pop_back();
+	}
+public:
+	/**
+	 * @brief Creates a new empty chunked pool.
+	 * @details Chunks are allocated on the first item creation.
+	 * @param[in] memoryResource chunks and internal arrays memory resource
+	 */
+	explicit ChunkedPool(std::pmr::memory_resource* memoryResource) : memoryResource(memoryResource), 
+		chunks(memoryResource), freeItems(memoryResource), garbageItems(memoryResource),
+		liveItems(memoryResource), livePositions(memoryResource), garbageFlags(memoryResource),
+		generations(memoryResource), changeVersions(memoryResource), changedItems(memoryResource),
+		refCounters(memoryResource)
+	{
+		assert(memoryResource);
+	}
+	/**
+	 * @brief Creates a new empty chunked pool using default memory resource.
+	 * @details Chunks are allocated on the first item creation.
+	 */
+	ChunkedPool() : ChunkedPool(std::pmr::get_default_resource()) { }
+
+	/**
+	 * @brief Destroys chunked pool.
+	 * @details It destroys all items and deallocates chunks memory.
+	 */
+	~ChunkedPool()
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			abort(); // Destruction of the items inside other create/destroy is not allowed.
+		isChanging = true;
+		#endif
+
+		if constexpr (DestroyItems)
+		{
+			for (auto index : liveItems)
+				getItem(index).destroy();
+		}
+
+		destructItems();
+		for (auto chunk : chunks)
+			deallocateChunk(chunk);
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+
+	ChunkedPool(const ChunkedPool&) = delete;
+	ChunkedPool& operator=(const ChunkedPool&) = delete;
+
+	/**
+	 * @brief Creates a new item in the pool.
+	 * @details Allocates a new memory chunk or reuses free item slots.
+	 * @note This function does not relocate previously created items, so all @ref View stay valid.
+	 *
+	 * @param args additional item arguments or empty
+	 * @return A new item identifier in the chunked pool.
+	 */
+	template<typename... Args>
+	ID<T> create(Args&&... args)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Creation of the item inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		if (!freeItems.empty())
+		{
+			auto freeItem = popFreeItem();
+			new (&getItem(*freeItem - 1)) T(std::forward<Args>(args)...);
+			addLiveItem(*freeItem - 1);
+
+			#ifndef NDEBUG
+			isChanging = false;
+			#endif
+
+			return freeItem;
+		}
+
+		if (occupancy == (uint32_t)chunks.size() * ChunkSize)
+			allocateChunk();
+
+		new (&getItem(occupancy)) T(std::forward<Args>(args)...);
+		livePositions.push_back(UINT32_MAX);
+		garbageFlags.push_back(false);
+		addLiveItem(occupancy);
+		if (occupancy == (uint32_t)generations.size())
+			generations.push_back(0);
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+
+		return getSlotID(occupancy++);
+	}
+
+	/**
+	 * @brief Creates a new default constructed items in the pool.
+	 * @details Reuses free item slots first, then allocates all missing chunks at once for the remaining items.
+	 * @note Item memory is not relocated, previous views stay valid.
+	 *
+	 * @param[out] instances created item identifier array (count size)
+	 * @param count item count to create
+	 * @tparam U type of the identifier item (see the ID cast)
+	 */
+	template<class U = T>
+	void createMany(ID<U>* instances, uint32_t count)
+	{
+		assert(instances || count == 0);
+
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Creation of the item inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		auto instance = instances, end = instances + count;
+		while (instance != end && !freeItems.empty())
+		{
+			auto freeItem = popFreeItem();
+			new (&getItem(*freeItem - 1)) T();
+			addLiveItem(*freeItem - 1);
+			*instance++ = ID<U>(freeItem);
+		}
+
+		auto newOccupancy = occupancy + (uint32_t)(end - instance);
+		while (newOccupancy > (uint32_t)chunks.size() * ChunkSize)
+			allocateChunk();
+
+		livePositions.resize(newOccupancy, UINT32_MAX);
+		garbageFlags.resize(newOccupancy, false);
+		liveItems.reserve(liveItems.size() + (newOccupancy - occupancy));
+		if (newOccupancy > (uint32_t)generations.size())
+			generations.resize(newOccupancy, 0);
+
+		for (; occupancy < newOccupancy; occupancy++)
+		{
+			new (&getItem(occupancy)) T();
+			addLiveItem(occupancy);
+			*instance++ = ID<U>(getSlotID(occupancy));
+		}
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+
+	/**
+	 * @brief Destroys chunked pool item.
+	 *
+	 * @details
+	 * It puts items to the garbage array, and destroys them after @ref dispose() call. Destroyed item is excluded
+	 * from the iteration, repeated destruction or destruction using stale identifier is ignored. Items can be
+	 * destroyed during the pool iteration, live item array is compacted only by the @ref dispose().
+	 *
+	 * @param instance item identifier in the pool or null
+	 * @tparam T type of the item in the chunked pool
+	 */
+	void destroy(ID<T> instance)
+	{
+		if (!instance)
+			return;
+
+		assert(*instance - 1 < occupancy);
+		auto index = *instance - 1;
+		if (livePositions[index] == UINT32_MAX || garbageFlags[index] || generations[index] != instance.getGeneration())
+			return;
+
+		garbageFlags[index] = true;
+		garbageItems.push_back(instance);
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns @ref View of the item in the chunked pool.
+	 * @note Item memory is not relocated, view stays valid until the item is destroyed.
+	 *
+	 * @param instance item identifier in the pool
+	 * @tparam T type of the item in the chunked pool
+	 */
+	View<T> get(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
+		#ifndef NDEBUG
+		return View(&getItem(*instance - 1), version);
+		#else
+		return View(&getItem(*instance - 1));
+		#endif
+	}
+	/**
+	 * @brief Returns @ref View of the item in the chunked pool.
+	 * @note Item memory is not relocated, view stays valid until the item is destroyed.
+	 *
+	 * @param instance item identifier in the pool
+	 * @tparam T type of the item in the chunked pool
+	 */
+	View<T> get(const Ref<T>& instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
+		#ifndef NDEBUG
+		return View(&getItem(*instance - 1), version);
+		#else
+		return View(&getItem(*instance - 1));
+		#endif
+	}
+	/**
+	 * @brief Returns @ref View of the item in the chunked pool.
+	 * @note Item memory is not relocated, view stays valid until the item is destroyed.
+	 *
+	 * @param instance item identifier in the pool
+	 * @tparam T type of the item in the chunked pool
+	 * @tparam Atomic is reference counter atomic
+	 */
+	template<bool Atomic>
+	View<T> get(const PoolRef<T, Atomic>& instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
+		#ifndef NDEBUG
+		return View(&getItem(*instance - 1), version);
+		#else
+		return View(&getItem(*instance - 1));
+		#endif
+	}
+
+	/**
+	 * @brief Returns a new item reference with pool-backed usage counter. (Increments counter)
+	 * @details Counters are stored in the pool array indexed by the item identifier, see the @ref PoolRef.
+	 * @warning It can allocate counter memory, call it only outside the concurrent read phase, not from several
+	 *          threads at once. Reference copies and destruction are thread safe for atomic references.
+	 *
+	 * @param instance target item identifier in the pool
+	 * @tparam Atomic use atomic counter, which can be shared between threads
+	 * @return Item reference, or null reference if identifier is stale and ECSM_CHECK_GENERATIONS is defined.
+	 */
+	template<bool Atomic = true>
+	PoolRef<T, Atomic> getRef(ID<T> instance)
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == instance.getGeneration()); // Stale disposed item identifier.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != instance.getGeneration())
+			return {}; // Stale identifier should not share the reused slot counter.
+		#endif
+		return PoolRef<T, Atomic>(refCounters.get(*instance - 1), instance);
+	}
+	/**
+	 * @brief Returns current pool-backed item reference count. (Atomic and non-atomic references)
+	 * @details Returns 0 if item identifier is stale, reused slot counter belongs to the new item.
+	 * @param instance target item identifier in the pool
+	 */
+	int64_t getRefCount(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		if (generations[*instance - 1] != instance.getGeneration())
+			return 0;
+		return refCounters.getCount(*instance - 1);
+	}
+
+	/**
+	 * @brief Returns @ref ID of the item pointer.
+	 * @details It searches for the memory chunk containing item.
+	 * @warning Use with extreme caution!
+	 *
+	 * @param[in] instance pointer to the item data
+	 * @tparam T type of the item in the chunked pool
+	 */
+	ID<T> getID(const T* instance) const noexcept
+	{
+		auto chunkCount = (uint32_t)chunks.size();
+		for (uint32_t i = 0; i < chunkCount; i++)
+		{
+			auto chunk = chunks[i];
+			if (instance < chunk || instance >= chunk + ChunkSize)
+				continue;
+			return getSlotID(i * ChunkSize + (uint32_t)(instance - chunk));
+		}
+
+		assert(false); // Item is not from this pool.
+		return {};
+	}
+
+	/**
+	 * @brief Returns chunked pool memory chunk array.
+	 * @warning It contains destroyed items too. Use @ref isLive() or pool iterator to skip freed items.
+	 * @tparam T type of the item in the chunked pool
+	 */
+	const std::pmr::vector<T*>& getChunks() const noexcept { return chunks; }
+	/*******************************************************************************************************************
+	 * @brief Returns true if item change versions are tracked.
+	 * @details See the @ref setTrackingChanges().
+	 */
+	bool isTrackingChanges() const noexcept { return trackChanges; }
+	/**
+	 * @brief Enables or disables item change tracking.
+	 *
+	 * @details
+	 * Tracked pool stores the last change version of each item slot and the changed item list ordered by the version,
+	 * so changed items can be visited without iterating the whole pool. Items are marked as changed on creation and
+	 * by the @ref markChanged() call. Disabling tracking releases all recorded changes.
+	 *
+	 * @param isTracking track item change versions
+	 */
+	void setTrackingChanges(bool isTracking)
+	{
+		if (!isTracking)
+		{
+			changeVersions = {};
+			changedItems = {};
+		}
+		trackChanges = isTracking;
+	}
+	/**
+	 * @brief Returns current item change version.
+	 * @details This version is stored for the changed items. (For example manager frame index)
+	 */
+	uint64_t getChangeVersion() const noexcept { return changeVersion; }
+	/**
+	 * @brief Sets current item change version.
+	 * @param version target change version (should not decrease)
+	 */
+	void setChangeVersion(uint64_t version) noexcept
+	{
+		assert(version >= changeVersion);
+		changeVersion = version;
+	}
+	/**
+	 * @brief Returns last item change version, or 0 if it is not tracked.
+	 * @param instance item identifier in the pool
+	 */
+	uint64_t getChangeVersion(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		auto index = *instance - 1;
+		return index < (uint32_t)changeVersions.size() ? changeVersions[index] : 0;
+	}
+	/**
+	 * @brief Marks item as changed with the current change version.
+	 * @details Nothing is recorded if tracking is disabled. Destroyed or stale items are ignored.
+	 * @warning Do not call it inside the concurrent read phase, it changes pool state.
+	 * @param instance item identifier in the pool or null
+	 */
+	void markChanged(ID<T> instance)
+	{
+		if (!trackChanges || !instance)
+			return;
+
+		assert(*instance - 1 < occupancy);
+		auto index = *instance - 1;
+		if (livePositions[index] == UINT32_MAX || garbageFlags[index] || generations[index] != instance.getGeneration())
+			return;
+		markSlotChanged(index);
+	}
+	/**
+	 * @brief Calls function for each live item changed after the specified version.
+	 * @details Each changed item is visited once, cost depends only on the recorded change count.
+	 *
+	 * @param sinceVersion last already processed change version
+	 * @param function target function (ID<T> instance, T& item)
+	 */
+	template<class Function>
+	void eachChanged(uint64_t sinceVersion, Function&& function) const
+	{
+		auto begin = std::upper_bound(changedItems.begin(), changedItems.end(), sinceVersion,
+			[](uint64_t version, const std::pair<uint64_t, uint32_t>& item) { return version < item.first; });
+		for (auto i = begin; i != changedItems.end(); i++)
+		{
+			auto index = i->second;
+			if (index >= occupancy || changeVersions[index] != i->first || 
+				livePositions[index] == UINT32_MAX || garbageFlags[index])
+				continue; // Item is changed again later, or destroyed.
+			function(getSlotID(index), getItem(index));
+		}
+	}
+	/**
+	 * @brief Returns recorded item change count, including repeated changes of the same item.
+	 */
+	size_t getChangeCount() const noexcept { return changedItems.size(); }
+	/**
+	 * @brief Releases recorded changes with version less or equal to the specified one.
+	 * @details Call it when all change consumers processed this version.
+	 * @warning Version should be less than the current change version, otherwise new changes can be lost.
+	 * @param untilVersion last processed change version
+	 */
+	void clearChanges(uint64_t untilVersion)
+	{
+		auto end = std::upper_bound(changedItems.begin(), changedItems.end(), untilVersion,
+			[](uint64_t version, const std::pair<uint64_t, uint32_t>& item) { return version < item.first; });
+		changedItems.erase(changedItems.begin(), end);
+	}
+
+	/**
+	 * @brief Returns chunks and internal arrays memory resource.
+	 */
+	std::pmr::memory_resource* getMemoryResource() const noexcept { return memoryResource; }
+
+	/**
+	 * @brief Returns true if item is created and not destroyed.
+	 * @param instance item identifier in the pool
+	 */
+	bool isLive(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		auto index = *instance - 1;
+		return livePositions[index] != UINT32_MAX && !garbageFlags[index] && 
+			generations[index] == instance.getGeneration();
+	}
+	/**
+	 * @brief Returns true if item identifier is not null and not stale. (Item is not disposed)
+	 * @details Checks item slot generation, destroyed but not yet disposed items are still valid.
+	 * @param instance item identifier in the pool or null
+	 */
+	bool isValid(ID<T> instance) const noexcept
+	{
+		return instance && *instance - 1 < occupancy && generations[*instance - 1] == instance.getGeneration();
+	}
+	/**
+	 * @brief Returns @ref View of the item in the chunked pool, or null view if identifier is not valid.
+	 * @details See the @ref isValid().
+	 * 
+	 * @param instance item identifier in the pool or null
+	 * @tparam T type of the item in the chunked pool
+	 */
+	View<T> tryGet(ID<T> instance) const noexcept
+	{
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		if (!isValid(instance))
+			return {};
+		#ifndef NDEBUG
+		return View(&getItem(*instance - 1), version);
+		#else
+		return View(&getItem(*instance - 1));
+		#endif
+	}
+
+	/**
+	 * @brief Returns current created item count.
+	 * @note This is not an allocated item count.
+	 */
+	uint32_t getCount() const noexcept { return occupancy - (uint32_t)freeItems.size(); }
+	/**
+	 * @brief Returns current live item count. (Created and not destroyed)
+	 * @details This is a number of the items visited by the pool iterator.
+	 */
+	uint32_t getLiveCount() const noexcept { return (uint32_t)(liveItems.size() - garbageItems.size()); }
+	/**
+	 * @brief Returns live item array size, including destroyed and not yet disposed items.
+	 * @details Used to split the pool iteration into ranges, see the @ref eachInRange().
+	 */
+	uint32_t getLiveRangeSize() const noexcept { return (uint32_t)liveItems.size(); }
+	/**
+	 * @brief Calls function for each live item in the live item array range, skipping destroyed items.
+	 * @details Non-overlapping ranges can be processed concurrently. (See the @ref getLiveRangeSize())
+	 *
+	 * @param begin live item array range begin
+	 * @param end live item array range end (exclusive)
+	 * @param function target function (T& item)
+	 */
+	template<class Function>
+	void eachInRange(uint32_t begin, uint32_t end, Function&& function)
+	{
+		assert(begin <= end && end <= (uint32_t)liveItems.size());
+		for (uint32_t i = begin; i < end; i++)
+		{
+			auto index = liveItems[i];
+			if (!garbageFlags[index])
+				function(getItem(index));
+		}
+	}
+	/**
+	 * @brief Returns used item slots count.
+	 * @warning This number also contains destroyed items.
+	 */
+	uint32_t getOccupancy() const noexcept { return occupancy; }
+
+	/**
+	 * @brief Returns true if free item slots with the lowest index are reused first.
+	 * @details See the @ref setLowestFreeFirst().
+	 */
+	bool isLowestFreeFirst() const noexcept { return lowestFreeFirst; }
+	/**
+	 * @brief Sets free item slot reuse policy.
+	 *
+	 * @details
+	 * By default the last freed item slot is reused first (LIFO). Reusing the lowest index slot 
+	 * instead keeps live items packed near the front of the items memory, at the small cost of 
+	 * the free item heap maintenance on each item creation and disposal.
+	 *
+	 * @param lowestFirst reuse free item slots with the lowest index first
+	 */
+	void setLowestFreeFirst(bool lowestFirst)
+	{
+		if (lowestFirst && !lowestFreeFirst)
+			std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+		lowestFreeFirst = lowestFirst;
+	}
+
+	/**
+	 * @brief Returns allocated chunks item capacity.
+	 */
+	uint32_t getCapacity() const noexcept { return (uint32_t)chunks.size() * ChunkSize; }
+	/**
+	 * @brief Returns item capacity kept by the @ref clear().
+	 * @details See the @ref reserve().
+	 */
+	uint32_t getReservedCapacity() const noexcept { return reservedChunkCount * ChunkSize; }
+
+	/**
+	 * @brief Allocates memory chunks for the specified item count.
+	 * @details Reserved chunks are also kept by the @ref clear(), useful to presize pool before level loading.
+	 * @note Item memory is not relocated, previous views stay valid.
+	 * @param capacity target item capacity
+	 */
+	void reserve(uint32_t capacity)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Reserve of the items inside other create/dispose/clear is not allowed.");
+		#endif
+
+		reservedChunkCount = (capacity + (ChunkSize - 1)) / ChunkSize;
+		while ((uint32_t)chunks.size() < reservedChunkCount)
+			allocateChunk();
+	}
+	/**
+	 * @brief Releases unused memory chunks.
+	 * 
+	 * @details
+	 * Trims free item slots from the end of the pool and deallocates chunks without items.
+	 * Free slots in the middle are kept, so all item identifiers stay valid. Also resets reserved capacity.
+	 * Remaining free slot reuse order is reset to the item index order.
+	 */
+	void shrinkToFit()
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Shrink of the items inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		if (!freeItems.empty())
+		{
+			// Sorted free list has the trailing free slots at its end, no temporary allocation is needed.
+			std::sort(freeItems.begin(), freeItems.end(), [](ID<T> a, ID<T> b) { return *a < *b; });
+
+			auto newOccupancy = occupancy;
+			while (!freeItems.empty() && *freeItems.back() == newOccupancy)
+			{
+				freeItems.pop_back();
+				newOccupancy--;
+			}
+
+			if (lowestFreeFirst)
+				std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+
+			if (newOccupancy != occupancy)
+			{
+				occupancy = newOccupancy;
+				livePositions.resize(newOccupancy); // Generations are kept, trimmed slot identifiers stay stale.
+				garbageFlags.resize(newOccupancy);
+				if (changeVersions.size() > newOccupancy)
+					changeVersions.resize(newOccupancy);
+			}
+		}
+
+		reservedChunkCount = 0;
+		auto chunkCount = (occupancy + (ChunkSize - 1)) / ChunkSize;
+		for (auto i = chunkCount; i < (uint32_t)chunks.size(); i++)
+			deallocateChunk(chunks[i]);
+		chunks.resize(chunkCount);
+
+		chunks.shrink_to_fit();
+		freeItems.shrink_to_fit();
+		garbageItems.shrink_to_fit();
+		liveItems.shrink_to_fit();
+		livePositions.shrink_to_fit();
+		garbageFlags.shrink_to_fit();
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Destroys all items in the chunked pool.
+	 * @details Keeps reserved memory chunks, see the @ref reserve().
+	 * @warning This function can deallocate chunks memory and invalidates all previous @ref View.
+	 * @param destroyItems should call destroy() function of the items
+	 */
+	void clear(bool destroyItems = DestroyItems)
+	{
+		#ifndef NDEBUG
+		if (destroyItems && !DestroyItems)
+			throw EcsmError("Item does not have destroy function.");
+		if (isChanging)
+			throw EcsmError("Clear of the items inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		if (destroyItems)
+		{
+			if constexpr (DestroyItems)
+			{
+				for (auto index : liveItems)
+					getItem(index).destroy();
+			}
+		}
+		destructItems();
+
+		auto keptChunkCount = std::min(reservedChunkCount, (uint32_t)chunks.size());
+		for (auto i = keptChunkCount; i < (uint32_t)chunks.size(); i++)
+			deallocateChunk(chunks[i]);
+		chunks.resize(keptChunkCount);
+
+		for (uint32_t i = 0; i < occupancy; i++)
+			generations[i]++; // Generations are kept, cleared item identifiers stay stale.
+		refCounters.clear();
+		occupancy = 0;
+		freeItems = {};
+		garbageItems = {};
+		liveItems = {};
+		livePositions = {};
+		garbageFlags = {};
+		changeVersions = {};
+		changedItems = {};
+
+		#ifndef NDEBUG
+		version++;
+		isChanging = false;
+		#endif
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Actually destroys items.
+	 *
+	 * @details
+	 * See the @ref destroy(). It marks destroyed item memory as free, and can reuse it later.
+	 * Items which destroy() function returned false are kept in the garbage array until the next call.
+	 * Disposed items are removed from the live item array, so do not call it during the pool iteration.
+	 * 
+	 * @param maxCount maximum processed item count, rest of the garbage items are disposed on the next calls
+	 * @return Actually destroyed item count.
+	 */
+	uint32_t dispose(uint32_t maxCount = UINT32_MAX)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Destruction of the items inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		uint32_t disposedCount = 0;
+		if constexpr (DestroyItems)
+		{
+			// Compacts not yet destroyed items in one pass, they will be disposed on the next call.
+			auto garbageData = garbageItems.data();
+			auto garbageCount = garbageItems.size();
+			auto processCount = std::min(garbageCount, (size_t)maxCount);
+			size_t keptCount = 0;
+
+			for (size_t i = 0; i < processCount; i++)
+			{
+				auto item = garbageData[i];
+				auto& itemData = getItem(*item - 1);
+				if (!itemData.destroy())
+				{
+					garbageData[keptCount++] = item;
+					continue;
+				}
+
+				itemData.~T();
+				removeLiveItem(*item - 1);
+				freeSlot(item);
+				disposedCount++;
+			}
+
+			// Not yet processed items are moved before the kept ones, so the next call starts from them.
+			auto restCount = garbageCount - processCount;
+			if (restCount > 0)
+			{
+				std::copy(garbageData + processCount, garbageData + garbageCount, garbageData + keptCount);
+				std::rotate(garbageData, garbageData + keptCount, garbageData + keptCount + restCount);
+			}
+			garbageItems.resize(keptCount + restCount);
+		}
+		else
+		{
+			auto processCount = std::min(garbageItems.size(), (size_t)maxCount);
+			for (size_t i = 0; i < processCount; i++)
+			{
+				auto item = garbageItems[i];
+				getItem(*item - 1).~T();
+				removeLiveItem(*item - 1);
+				freeSlot(item);
+			}
+			garbageItems.erase(garbageItems.begin(), garbageItems.begin() + processCount);
+			disposedCount = (uint32_t)processCount;
+		}
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+		return disposedCount;
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Writes pool item slots and items to the binary snapshot.
+	 *
+	 * @details
+	 * Writes item size, occupancy, generations, free, garbage and live item arrays as contiguous blocks. Trivially
+	 * copyable items are written as a single memory block, other items should be written by the pool owner.
+	 * Snapshot layout is the same for the @ref LinearPool and @ref ChunkedPool.
+	 *
+	 * @param[out] writer target snapshot writer
+	 */
+	void writeSnapshot(SnapshotWriter& writer) const
+	{
+		writer.write((uint32_t)sizeof(T));
+		writer.write(occupancy);
+		writer.writeArray(generations);
+		writer.writeArray(freeItems);
+		writer.writeArray(garbageItems);
+
+		if (garbageItems.empty())
+		{
+			writer.writeArray(liveItems);
+		}
+		else
+		{
+			writer.write(getLiveCount()); // Garbage items are written only to the garbage array.
+			for (auto index : liveItems)
+			{
+				if (!garbageFlags[index])
+					writer.write(index);
+			}
+		}
+
+		if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			for (uint32_t i = 0; i < occupancy; i += ChunkSize)
+				writer.write(chunks[i / ChunkSize], (size_t)std::min(occupancy - i, ChunkSize) * sizeof(T));
+		}
+	}
+	/**
+	 * @brief Replaces pool item slots and items with the binary snapshot data.
+	 *
+	 * @details
+	 * Current items are destructed without the destroy() call, use @ref clear() before if it is required. Trivially
+	 * copyable items are copied from the snapshot with a single memcpy(), other live and garbage items are default
+	 * constructed and should be read by the pool owner. Item references are not stored in the snapshot.
+	 *
+	 * @warning This function invalidates all previous @ref View.
+	 * @param[in] reader source snapshot reader
+	 * @throw EcsmError if snapshot data is truncated or corrupted, pool is empty after it.
+	 */
+	void readSnapshot(SnapshotReader& reader)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Snapshot read of the items inside other create/dispose/clear is not allowed.");
+		#endif
+
+		if (reader.read<uint32_t>() != (uint32_t)sizeof(T))
+			throw EcsmError("Snapshot pool item size mismatch. (size: " + std::to_string(sizeof(T)) + ")");
+
+		#ifndef NDEBUG
+		isChanging = true;
+		#endif
+
+		destructItems();
+		refCounters.clear();
+		occupancy = 0;
+
+		try
+		{
+			auto newOccupancy = reader.read<uint32_t>();
+			reader.readArray(generations);
+			reader.readArray(freeItems);
+			reader.readArray(garbageItems);
+			reader.readArray(liveItems);
+
+			if (!SnapshotReader::isPoolValid(newOccupancy, generations, freeItems, garbageItems, liveItems))
+				throw EcsmError("Bad pool snapshot item slots.");
+
+			auto itemData = (const uint8_t*)nullptr;
+			if constexpr (std::is_trivially_copyable_v<T>)
+				itemData = (const uint8_t*)reader.read((size_t)newOccupancy * sizeof(T));
+
+			auto chunkCount = (newOccupancy + (ChunkSize - 1)) / ChunkSize;
+			while ((uint32_t)chunks.size() < chunkCount)
+				allocateChunk();
+
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				for (uint32_t i = 0; i < newOccupancy; i += ChunkSize)
+				{
+					memcpy((void*)chunks[i / ChunkSize], itemData + (size_t)i * sizeof(T),
+						(size_t)std::min(newOccupancy - i, ChunkSize) * sizeof(T));
+				}
+			}
+			occupancy = newOccupancy;
+		}
+		catch (...)
+		{
+			freeItems.clear();
+			garbageItems.clear();
+			liveItems.clear();
+			livePositions.clear();
+			garbageFlags.clear();
+			changeVersions.clear();
+			changedItems.clear();
+			#ifndef NDEBUG
+			version++;
+			isChanging = false;
+			#endif
+			throw;
+		}
+
+		if (trackChanges)
+		{
+			changeVersions.assign(occupancy, 0);
+			changedItems.clear();
+			for (auto index : liveItems)
+				markSlotChanged(index);
+		}
+
+		garbageFlags.assign(occupancy, false);
+		for (auto item : garbageItems)
+		{
+			liveItems.push_back(*item - 1);
+			garbageFlags[*item - 1] = true;
+		}
+
+		if constexpr (!std::is_trivially_copyable_v<T>)
+		{
+			for (auto index : liveItems)
+				new (&getItem(index)) T();
+		}
+
+		livePositions.assign(occupancy, UINT32_MAX);
+		for (uint32_t i = 0; i < (uint32_t)liveItems.size(); i++)
+			livePositions[liveItems[i]] = i;
+		if (lowestFreeFirst)
+			std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+
+		#ifndef NDEBUG
+		version++;
+		isChanging = false;
+		#endif
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Chunked pool live item iterator class.
+	 *
+	 * @details
+	 * Visits only created and not destroyed items in an unspecified order, skipping free and garbage item
+	 * slots. Iteration cost depends on the live item count instead of the pool occupancy.
+	 * Items can be destroyed during the iteration, do not create or dispose them.
+	 */
+	template<class V>
+	struct LiveIterator
+	{
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = V;
+		using difference_type = ptrdiff_t;
+		using pointer = value_type*;
+		using reference = value_type&;
+	private:
+		T* const* chunks = nullptr;
+		const uint32_t* index = nullptr;
+		const uint32_t* end = nullptr;
+		const uint8_t* garbageFlags = nullptr;
+
+		void skipGarbage() noexcept
+		{
+			while (index != end && garbageFlags[*index])
+				++index;
+		}
+	public:
+		LiveIterator(T* const* chunks, const uint32_t* index, 
+			const uint32_t* end, const uint8_t* garbageFlags) noexcept :
+			chunks(chunks), index(index), end(end), garbageFlags(garbageFlags) { skipGarbage(); }
+		LiveIterator& operator=(const LiveIterator& i) noexcept = default;
+
+		bool operator==(const LiveIterator& i) const noexcept { return index == i.index; }
+		bool operator!=(const LiveIterator& i) const noexcept { return index != i.index; }
+
+		LiveIterator& operator++() noexcept { ++index; skipGarbage(); return *this; }
+		LiveIterator operator++(int) noexcept { auto tmp = *this; ++index; skipGarbage(); return tmp; }
+
+		reference operator*() const noexcept { return chunks[*index / ChunkSize][*index & (ChunkSize - 1)]; }
+		pointer operator->() noexcept { return &chunks[*index / ChunkSize][*index & (ChunkSize - 1)]; }
+	};
+
+	using Iterator = LiveIterator<T>;
+	using ConstantIterator = LiveIterator<const T>;
+
+	/**
+	 * @brief Returns an iterator pointing to the first live item.
+	 */
+	Iterator begin() noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return Iterator(chunks.data(), liveItems.data(), end, garbageFlags.data());
+	}
+	/**
+	 * @brief Returns an iterator pointing to the past-the-end live item.
+	 */
+	Iterator end() noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return Iterator(chunks.data(), end, end, garbageFlags.data());
+	}
+
+	/**
+	 * @brief Returns a constant iterator pointing to the first live item.
+	 */
+	ConstantIterator begin() const noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return ConstantIterator(chunks.data(), liveItems.data(), end, garbageFlags.data());
+	}
+	/**
+	 * @brief Returns a constant iterator pointing to the past-the-end live item.
+	 */
+	ConstantIterator end() const noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return ConstantIterator(chunks.data(), end, end, garbageFlags.data());
+	}
+};
+
+} // namespace ecsm
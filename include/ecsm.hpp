@@ -20,10 +20,17 @@
 #pragma once
 #include "singleton.hpp"
 #include "linear-pool.hpp"
+#include "chunked-pool.hpp"
+#include "archetype-storage.hpp"
+#include "soa-storage.hpp"
+#include "thread-pool.hpp"
+#include "profiler.hpp"
 
-#include <set>
 #include <map>
+#include <memory_resource>
 #include <mutex>
+#include <thread>
+#include <cstring>
 #include <algorithm>
 #include <functional>
 #include <type_traits>
@@ -38,28 +45,37 @@ struct Component;
 class System;
 class Manager;
 class SystemExt;
+template<class T, bool DestroyComponents, class Pool>
+class ComponentSystem;
 
 /**
  * @brief Subscribes @ref System function to the event.
  */
 #define ECSM_SUBSCRIBE_TO_EVENT(name, func) \
-	ecsm::Manager::Instance::get()->subscribeToEvent(name, std::bind(&func, this))
+	ecsm::Manager::Instance::get()->subscribeToEvent(name, ecsm::Delegate::create<&func>(this))
 /**
  * @brief Unsubscribes @ref System function from the event.
  */
 #define ECSM_UNSUBSCRIBE_FROM_EVENT(name, func) \
-	ecsm::Manager::Instance::get()->unsubscribeFromEvent(name, std::bind(&func, this))
+	ecsm::Manager::Instance::get()->unsubscribeFromEvent(name, ecsm::Delegate::create<&func>(this))
+
+/**
+ * @brief Subscribes @ref System function to the event with declared component access.
+ */
+#define ECSM_SUBSCRIBE_TO_EVENT_ACCESS(name, func, access) \
+	ecsm::Manager::Instance::get()->subscribeToEvent(name, ecsm::Delegate::create<&func>(this), \
+		ecsm::ComponentAccess(access).setSystem(ecsm::getTypeIndex<std::remove_pointer_t<decltype(this)>>()))
 
 /**
  * @brief Subscribes @ref System function to the event if exist.
  */
 #define ECSM_TRY_SUBSCRIBE_TO_EVENT(name, func) \
-	ecsm::Manager::Instance::get()->trySubscribeToEvent(name, std::bind(&func, this))
+	ecsm::Manager::Instance::get()->trySubscribeToEvent(name, ecsm::Delegate::create<&func>(this))
 /**
  * @brief Unsubscribes @ref System function from the event if exist.
  */
 #define ECSM_TRY_UNSUBSCRIBE_FROM_EVENT(name, func) \
-	ecsm::Manager::Instance::get()->tryUnsubscribeFromEvent(name, std::bind(&func, this))
+	ecsm::Manager::Instance::get()->tryUnsubscribeFromEvent(name, ecsm::Delegate::create<&func>(this))
 
 /***********************************************************************************************************************
  * @brief Base component structure.
@@ -74,6 +90,11 @@ struct Component
 protected:
 	ID<Entity> entity = {};
 	friend class Manager;
+	friend class System;
+	template<class T, bool D, class P>
+	friend class ComponentSystem;
+	template<class T, class... F>
+	friend class SoaStorage;
 public:
 	/**
 	 * @brief Returns component entity instance.
@@ -91,6 +112,11 @@ public:
  */
 class System
 {
+	Manager* manager = nullptr;
+	uint32_t componentTypeID = UINT32_MAX;
+	uint32_t staticTypeID = UINT32_MAX;
+	bool isGarbageQueued = false;
+	bool bulkCopy = false;
 protected:
 	/**
 	 * @brief Destroys system instance.
@@ -105,6 +131,16 @@ protected:
 	 * @param entity target entity instance
 	 */
 	virtual ID<Component> createComponent(ID<Entity> entity);
+	/**
+	 * @brief Creates a new system component instances for the entities and sets their entity.
+	 * @details You should use @ref Manager to add components to the entities.
+	 * @note Override it to create components of the custom system at once.
+	 * 
+	 * @param[in] entities target entity instance array
+	 * @param count entity and component count
+	 * @param[out] instances created component instance array (count size)
+	 */
+	virtual void createComponents(const ID<Entity>* entities, uint32_t count, ID<Component>* instances);
 	/**
 	 * @brief Destroys system component instance.
 	 * @details You should use @ref Manager to remove components from the entity.
@@ -120,6 +156,34 @@ protected:
 	 * @param destination destination component view (to)
 	 */
 	virtual void copyComponent(View<Component> source, View<Component> destination);
+	/**
+	 * @brief Copies system component data from source to the just created destination components.
+	 * 
+	 * @details
+	 * You should use @ref Manager to instantiate prefabs. Destination component entity is preserved.
+	 * By default it calls @ref copyComponent() for each destination component.
+	 * 
+	 * @param source source component instance (from)
+	 * @param[in] destinations destination component instance array (to)
+	 * @param count destination component count
+	 */
+	virtual void copyComponents(ID<Component> source, const ID<Component>* destinations, uint32_t count);
+	/**
+	 * @brief Writes all system components to the binary snapshot.
+	 * @details You should use @ref Manager to write world snapshot.
+	 * @note Override it to define a custom component of the system.
+	 * @param[out] writer target snapshot writer
+	 * @throw EcsmError if system components can not be written to the snapshot.
+	 */
+	virtual void writeComponents(SnapshotWriter& writer) const;
+	/**
+	 * @brief Replaces all system components with the binary snapshot data.
+	 * @details You should use @ref Manager to read world snapshot.
+	 * @note Override it to define a custom component of the system.
+	 * @param[in] reader source snapshot reader
+	 * @throw EcsmError if system components can not be read from the snapshot.
+	 */
+	virtual void readComponents(SnapshotReader& reader);
 
 	friend class Entity;
 	friend class Manager;
@@ -131,21 +195,104 @@ public:
 	 */
 	virtual const std::string& getComponentName() const;
 	/**
-	 * @brief Returns specific component typeid() of the system.
+	 * @brief Returns specific component TypeIndex of the system.
 	 * @note Override it to define a custom component of the system.
 	 */
-	virtual std::type_index getComponentType() const;
+	virtual TypeIndex getComponentType() const;
+	/**
+	 * @brief Returns specific component static type identifier, or UINT32_MAX if unknown.
+	 * @details It is used by the @ref Manager templated functions to find component system without hashing.
+	 * @note Override it together with the @ref getComponentType(). (See the @ref getStaticTypeID())
+	 */
+	virtual uint32_t getComponentStaticTypeID() const;
+	/**
+	 * @brief Returns dense component type identifier assigned by the @ref Manager.
+	 * @details It is used to index entity components, UINT32_MAX if system has no components.
+	 */
+	uint32_t getComponentTypeID() const noexcept { return componentTypeID; }
+	/**
+	 * @brief Returns manager instance which owns the system.
+	 * @details It is set after the system construction, use @ref Manager::Instance inside the constructor.
+	 */
+	Manager* getManager() const noexcept { return manager; }
+	/**
+	 * @brief Returns true if system components can be copied at once, without @ref copyComponent() call.
+	 * @details It is set by the @ref Manager if system does not override @ref copyComponent().
+	 */
+	bool canBulkCopy() const noexcept { return bulkCopy; }
 	/**
 	 * @brief Returns specific system component @ref View.
 	 * @note Override it to define a custom component of the system.
 	 * @param instance target component instance
 	 */
 	virtual View<Component> getComponent(ID<Component> instance);
+	/**
+	 * @brief Returns system component count, or UINT32_MAX if unknown.
+	 * @details It is used by the @ref Manager queries to select the smallest component set.
+	 * @note Override it to define a custom component of the system.
+	 */
+	virtual uint32_t getComponentCount() const;
+	/**
+	 * @brief Appends entities of all system components to the array.
+	 * @details It is used by the @ref Manager queries to build initial matching entity list.
+	 * @note Override it to define a custom component of the system.
+	 * @param[out] entities target entity array
+	 */
+	virtual void getComponentEntities(std::vector<ID<Entity>>& entities) const;
 	/**
 	 * @brief Actually destroys system components.
-	 * @details Components are not destroyed immediately, only after the dispose call.
+	 * 
+	 * @details
+	 * Components are not destroyed immediately, only after the dispose call. It is called only for the systems
+	 * queued by the @ref Manager::addGarbageSystem(), manager queues system when it destroys its component.
+	 * 
+	 * @note Queue system again from this function if some garbage components are left until the next call.
+	 * @param maxCount maximum processed garbage component count
+	 * @return Actually destroyed component count.
+	 */
+	virtual uint32_t disposeComponents(uint32_t maxCount);
+	/**
+	 * @brief Reserves system component memory for the specified count.
+	 * @details It is a hint used to presize component storage, for example from the level metadata.
+	 * @note Override it to define a custom component of the system.
+	 * @param count target component capacity
+	 */
+	virtual void reserveComponents(uint32_t count);
+	/**
+	 * @brief Releases unused system component memory.
+	 * @note Override it to define a custom component of the system.
+	 */
+	virtual void shrinkComponents();
+	/**
+	 * @brief Returns allocated system component capacity.
+	 * @details It is used by the @ref Profiler to record component pool growth.
+	 * @note Override it to define a custom component of the system.
+	 */
+	virtual uint32_t getComponentCapacity() const;
+
+	/**
+	 * @brief Sets current component change version. (Manager frame index)
+	 * @details It is called by the @ref Manager after each update.
+	 * @note Override it to define a custom component of the system.
+	 * @param version target change version
 	 */
-	virtual void disposeComponents();
+	virtual void setComponentChangeVersion(uint64_t version);
+	/**
+	 * @brief Marks system component as changed with the current change version.
+	 * @details You should use @ref Manager to mark entity components as changed.
+	 * @note Override it to define a custom component of the system.
+	 * @param instance target component instance
+	 */
+	virtual void markComponentChanged(ID<Component> instance);
+	/**
+	 * @brief Appends entities of the system components changed after the specified version.
+	 * @details You should use @ref Manager to get changed entity components.
+	 * @note Override it to define a custom component of the system.
+	 *
+	 * @param sinceVersion last already processed change version
+	 * @param[out] entities target entity array
+	 */
+	virtual void getChangedEntities(uint64_t sinceVersion, std::vector<ID<Entity>>& entities) const;
 };
 
 /***********************************************************************************************************************
@@ -154,16 +301,66 @@ public:
  * @details
  * The entity is a general-purpose object. It doesn't have any inherent behavior 
  * or data by itself. Instead, it serves as a container for components.
+ * 
+ * Entity components are stored in the array sorted by the dense component type identifier. First 
+ * @ref inlineCapacity components are stored inside the entity itself without any heap allocation.
  */
 class Entity final
 {
 public:
-	using SystemComponent = std::pair<System*, ID<Component>>;
-	using Components = std::map<std::type_index, SystemComponent>;
+	/**
+	 * @brief Entity component data.
+	 * @details Garbage flag is set when component is removed, but not yet disposed.
+	 */
+	struct ComponentData final
+	{
+		System* system = nullptr;
+		ID<Component> instance = {};
+		uint32_t type : 31;
+		uint32_t isGarbage : 1;
+
+		ComponentData() noexcept : type(0), isGarbage(0) { }
+	};
+
+	/**
+	 * @brief Component count stored without heap allocation.
+	 */
+	static constexpr uint32_t inlineCapacity = 8;
 private:
-	Components components;
+	ComponentData* heapComponents = nullptr;
+	uint32_t count = 0, capacity = inlineCapacity;
+	ComponentData inlineComponents[inlineCapacity];
+
+	ComponentData* getData() noexcept { return heapComponents ? heapComponents : inlineComponents; }
+	const ComponentData* getData() const noexcept { return heapComponents ? heapComponents : inlineComponents; }
+	ComponentData* findComponentData(uint32_t type) noexcept { return (ComponentData*)findComponent(type); }
+
+	static void deallocateComponents(ComponentData* components, uint32_t capacity) noexcept;
+	void reallocateComponents(uint32_t capacity, std::pmr::memory_resource* memoryResource);
+	void reserveComponents(uint32_t capacity, std::pmr::memory_resource* memoryResource);
+	bool addComponent(uint32_t type, System* system, ID<Component> instance, 
+		std::pmr::memory_resource* memoryResource);
+	bool removeComponent(uint32_t type) noexcept;
 	friend class Manager;
 public:
+	/**
+	 * @brief Creates a new entity without components.
+	 */
+	Entity() = default;
+	/**
+	 * @brief Releases entity components memory.
+	 */
+	~Entity()
+	{
+		if (heapComponents)
+			deallocateComponents(heapComponents, capacity);
+	}
+
+	Entity(const Entity&) = delete;
+	Entity(Entity&& entity) noexcept;
+	Entity& operator=(const Entity&) = delete;
+	Entity& operator=(Entity&& entity) noexcept;
+
 	/**
 	 * @brief Destroys all entity components.
 	 * @note Components are not destroyed immediately, only after the dispose call.
@@ -171,12 +368,193 @@ public:
 	bool destroy();
 
 	/**
-	 * @brief Returns entity components map.
+	 * @brief Returns entity component array sorted by the type.
 	 * @details Use @ref Manager to add or remove components.
 	 */
-	const Components& getComponents() const noexcept { return components; }
+	const ComponentData* getComponents() const noexcept { return getData(); }
+	/**
+	 * @brief Returns entity component count.
+	 */
+	uint32_t getComponentCount() const noexcept { return count; }
+
+	/**
+	 * @brief Returns entity component data if added, otherwise nullptr.
+	 * @param type target dense component type identifier (@ref System::getComponentTypeID())
+	 */
+	const ComponentData* findComponent(uint32_t type) const noexcept
+	{
+		auto components = getData();
+		if (count <= inlineCapacity)
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				if (components[i].type == type)
+					return &components[i];
+			}
+			return nullptr;
+		}
+
+		auto end = components + count;
+		auto result = std::lower_bound(components, end, type,
+			[](const ComponentData& a, uint32_t b) noexcept { return a.type < b; });
+		return result != end && result->type == type ? result : nullptr;
+	}
+};
+
+/***********************************************************************************************************************
+ * @brief Event subscriber function delegate.
+ *
+ * @details
+ * Holds object pointer and a function which calls member function bound at compile time, so calling it is a single
+ * indirect call without heap allocation. Delegates are equal only if they call the same function of the same object,
+ * which allows to unsubscribe exact system instance from the event.
+ */
+class Delegate final
+{
+public:
+	/**
+	 * @brief Delegate call function. (instance)
+	 */
+	using Function = void(*)(void*);
+private:
+	void* instance = nullptr;
+	Function function = nullptr;
+
+	template<auto Method, class T>
+	static void callMethod(void* instance) { (static_cast<T*>(instance)->*Method)(); }
+	template<auto Callback>
+	static void callFunction(void*) { Callback(); }
+public:
+	/**
+	 * @brief Creates a new empty delegate.
+	 */
+	constexpr Delegate() noexcept = default;
+	/**
+	 * @brief Creates a new delegate from the instance and call function.
+	 * 
+	 * @param[in] instance target object instance or null
+	 * @param function target call function
+	 */
+	constexpr Delegate(void* instance, Function function) noexcept : instance(instance), function(function) { }
+
+	/**
+	 * @brief Creates a new member function delegate.
+	 * @param[in] instance target object instance
+	 * @tparam Method target member function pointer (void())
+	 */
+	template<auto Method, class T>
+	static Delegate create(T* instance) noexcept
+	{
+		assert(instance);
+		return Delegate(instance, &callMethod<Method, T>);
+	}
+	/**
+	 * @brief Creates a new free or static function delegate.
+	 * @tparam Callback target function pointer (void())
+	 */
+	template<auto Callback>
+	static Delegate create() noexcept { return Delegate(nullptr, &callFunction<Callback>); }
+
+	/**
+	 * @brief Returns delegate object instance.
+	 */
+	void* getInstance() const noexcept { return instance; }
+	/**
+	 * @brief Returns delegate call function.
+	 */
+	Function getFunction() const noexcept { return function; }
+
+	/**
+	 * @brief Calls delegate function.
+	 */
+	void operator()() const { function(instance); }
+	/**
+	 * @brief Returns true if delegate is not empty.
+	 */
+	explicit operator bool() const noexcept { return function; }
+
+	bool operator==(const Delegate& d) const noexcept { return instance == d.instance && function == d.function; }
+	bool operator!=(const Delegate& d) const noexcept { return instance != d.instance || function != d.function; }
+};
+
+/***********************************************************************************************************************
+ * @brief Event subscriber component access declaration.
+ *
+ * @details
+ * Subscribers of the same event with non-conflicting component accesses are executed in parallel when the
+ * @ref Manager has a @ref ThreadPool. Accesses are conflicting if one of them writes a component that the other one
+ * reads or writes. Subscriber without access declaration is exclusive and is always executed alone.
+ * Use read<>() without component types to declare subscriber which does not access any components.
+ * 
+ * Subscriber can be also ordered after all subscribers of the other systems, it is used by the 
+ * @ref Manager schedule to build dependency graph. (See the @ref Manager::runSchedule())
+ */
+struct ComponentAccess final
+{
+	std::vector<TypeIndex> readComponents;
+	std::vector<TypeIndex> writeComponents;
+	std::vector<TypeIndex> afterSystems;
+	TypeIndex system = getTypeIndex<System>();
+	bool isExclusive = true;
+
+	/**
+	 * @brief Declares read only access to the components.
+	 * @tparam Components target component types
+	 */
+	template<class... Components>
+	ComponentAccess& read()
+	{
+		(readComponents.push_back(getTypeIndex<Components>()), ...);
+		isExclusive = false;
+		return *this;
+	}
+	/**
+	 * @brief Declares read and write access to the components.
+	 * @tparam Components target component types
+	 */
+	template<class... Components>
+	ComponentAccess& write()
+	{
+		(writeComponents.push_back(getTypeIndex<Components>()), ...);
+		isExclusive = false;
+		return *this;
+	}
+
+	/**
+	 * @brief Declares that subscriber should be executed after all subscribers of the systems.
+	 * @tparam Systems target system types
+	 */
+	template<class... Systems>
+	ComponentAccess& after()
+	{
+		static_assert((std::is_base_of_v<System, Systems> && ...), "Must be derived from the System class.");
+		(afterSystems.push_back(getTypeIndex<Systems>()), ...);
+		return *this;
+	}
+	/**
+	 * @brief Sets system owning the subscriber.
+	 * @param system target system TypeIndex
+	 */
+	ComponentAccess& setSystem(TypeIndex system) noexcept
+	{
+		this->system = system;
+		return *this;
+	}
+
+	/**
+	 * @brief Returns true if accesses can not be executed in parallel.
+	 * @param other target component access to check
+	 */
+	bool isConflicting(const ComponentAccess& other) const noexcept;
 };
 
+/***********************************************************************************************************************
+ * @brief Component types excluded from the @ref Manager query.
+ * @tparam Components excluded component types
+ */
+template<class... Components>
+struct Exclude final { };
+
 /***********************************************************************************************************************
  * @brief Systems and entities coordinator.
  * 
@@ -196,6 +574,9 @@ public:
  *     used for tasks that must occur after all components and systems have been initialized. 
  *     It's particularly useful for setup steps that require all other components to 
  *     be in a ready state or for cross-component communications and linking.
+ * 
+ * Multiple independent managers (worlds) can be updated concurrently on separate threads. Create them without the
+ * singleton and with non-singleton systems, each manager is set as the thread current one during its events.
  */
 class Manager final : public Singleton<Manager, false>
 {
@@ -205,145 +586,720 @@ public:
 	 */
 	struct Event final
 	{
-		using Subscribers = std::vector<std::function<void()>>;
+		using Subscribers = std::vector<Delegate>;
+		using Accesses = std::vector<ComponentAccess>;
+		using Functions = std::vector<std::unique_ptr<std::function<void()>>>;
 
 		std::string name;
 		Subscribers subscribers;
+		Accesses accesses;   /**< Component accesses of the subscribers. (Same order) */
+		Functions functions; /**< Function objects of the std::function subscribers. (Convenience, not zero cost) */
+		ID<Event> id = {};  /**< Event handle to run it without name lookup. */
 		bool isOrdered = false;
 
-		Event(const std::string& name, bool isOrdered = true) : name(name), isOrdered(isOrdered) { }
+		Event(std::string_view name, bool isOrdered = true) : name(name), isOrdered(isOrdered) { }
 	};
 
-	using Systems = std::unordered_map<std::type_index, System*>;
-	using ComponentTypes = std::unordered_map<std::type_index, System*>;
-	using ComponentNames = std::map<std::string, System*>;
-	using Events = std::unordered_map<std::string, Event*>;
-	using OrderedEvents = std::vector<const Event*>;
-	using EntityPool = LinearPool<Entity>;
-	using GarbageComponent = std::pair<std::type_index, ID<Entity>>;
-	using GarbageComponents = std::set<GarbageComponent>;
-private:
-	Systems systems;
-	ComponentTypes componentTypes;
-	ComponentNames componentNames;
-	EntityPool entities;
-	Events events;
-	OrderedEvents orderedEvents;
-	GarbageComponents garbageComponents;
-	std::mutex locker;
-	bool initialized = false;
-
-	#ifndef NDEBUG
-	bool isChanging = false;
-	#endif
-
-	void addSystem(System* system, std::type_index type);
-public:
-	bool isRunning = false;
-
-	/**
-	 * @brief Creates a new manager instance.
-	 * @param setSingleton set manager singleton instance
-	 */
-	Manager(bool setSingleton = true);
 	/**
-	 * @brief Destroys manager and all components/entities/systems.
-	 */
-	~Manager();
-
-	/*******************************************************************************************************************
-	 * @brief Creates a new system instance.
-	 * 
+	 * @brief Cached entity query holder.
+	 *
 	 * @details
-	 * Instantiates a new system and registers it component, 
-	 * but initialization occurs only after the @ref initialize() call.
-	 * 
-	 * @tparam T target system type
-	 * @tparam Args additional argument types
-	 * @param args additional system creation arguments
-	 * 
-	 * @throw EcsmError if system is already created or component type registered.
+	 * Contains all entities which have every included component and none of the excluded ones. Matching
+	 * entity list is built once and then updated incrementally by the @ref Manager on component add/remove,
+	 * so iterating query each frame does not repeat the component set intersection.
 	 */
-	template<class T = System, typename... Args>
-	void createSystem(Args&&... args)
+	class Query final
 	{
-		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		#ifndef NDEBUG
-		if (isChanging)
-			throw EcsmError("Creation of the system inside other create/destroy is not allowed.");
-		isChanging = true;
-		#endif
-
-		auto system = new T(std::forward<Args>(args)...);
-		addSystem(system, typeid(T));
+		std::vector<uint32_t> includeTypes;
+		std::vector<uint32_t> excludeTypes;
+		std::vector<System*> includeSystems;
+		std::vector<System*> excludeSystems;
+		std::vector<ID<Entity>> entities;
+		std::vector<ID<Component>> components;
+		std::vector<uint32_t> positions;
 
 		#ifndef NDEBUG
-		isChanging = false;
+		bool isIterating = false;
 		#endif
-	}
 
-	/**
-	 * @brief Terminates and destroys system.
-	 * @param type target system typeid()
-	 * @throw EcsmError if system is not found.
-	 */
-	void destroySystem(std::type_index type);
-	/**
-	 * @brief Terminates and destroys system.
-	 * @tparam T target system type
-	 * @throw EcsmError if system is not found.
-	 */
-	template<class T = System>
-	void destroySystem()
-	{
-		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		destroySystem(typeid(T));
-	}
+		friend class Manager;
+	public:
+		/**
+		 * @brief Returns included dense component type identifiers.
+		 */
+		const std::vector<uint32_t>& getIncludeTypes() const noexcept { return includeTypes; }
+		/**
+		 * @brief Returns excluded dense component type identifiers.
+		 */
+		const std::vector<uint32_t>& getExcludeTypes() const noexcept { return excludeTypes; }
+		/**
+		 * @brief Returns systems of the included components.
+		 */
+		const std::vector<System*>& getSystems() const noexcept { return includeSystems; }
+		/**
+		 * @brief Returns matching entity array.
+		 * @warning Array order is changed when entities are added or removed.
+		 */
+		const std::vector<ID<Entity>>& getEntities() const noexcept { return entities; }
+		/**
+		 * @brief Returns included component instances of the matching entity.
+		 * @details Components are in the same order as included types.
+		 * @param index target matching entity index
+		 */
+		const ID<Component>* getComponents(uint32_t index) const noexcept
+		{
+			assert(index < entities.size());
+			return components.data() + (size_t)index * includeTypes.size();
+		}
+		/**
+		 * @brief Returns matching entity count.
+		 */
+		uint32_t getCount() const noexcept { return (uint32_t)entities.size(); }
+		/**
+		 * @brief Returns true if entity matches the query.
+		 * @param entity target entity instance
+		 */
+		bool isMatch(ID<Entity> entity) const noexcept
+		{
+			assert(entity);
+			auto index = *entity - 1;
+			return index < positions.size() && positions[index] != UINT32_MAX;
+		}
+	};
 
 	/**
-	 * @brief Terminates and destroys system if exist.
-	 * @param type target system typeid()
-	 * @return True if system is destroyed, otherwise false.
-	 */
-	bool tryDestroySystem(std::type_index type);
-	/**
-	 * @brief Terminates and destroys system if exist.
-	 * @tparam T target system type
-	 * @return True if system is destroyed, otherwise false.
+	 * @brief Precompiled entity component layout.
+	 *
+	 * @details
+	 * Created from the template entity by the @ref Manager::createPrefab(). Stores resolved systems and source
+	 * component instances, so instantiating prefab creates and copies components in bulk per system without
+	 * any component type lookups. Prefab still references template entity components, it becomes invalid 
+	 * after adding or removing template entity components.
 	 */
-	template<class T = System>
-	bool tryDestroySystem()
+	class Prefab final
 	{
-		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		return tryDestroySystem(typeid(T));
-	}
+		std::vector<Entity::ComponentData> components;
+		ID<Entity> entity = {};
+		friend class Manager;
+	public:
+		/**
+		 * @brief Returns prefab template entity.
+		 */
+		ID<Entity> getEntity() const noexcept { return entity; }
+		/**
+		 * @brief Returns prefab template entity components sorted by the type.
+		 */
+		const std::vector<Entity::ComponentData>& getComponents() const noexcept { return components; }
+	};
 
 	/*******************************************************************************************************************
-	 * @brief Returns true if system is created.
-	 * @param type target system typeid()
+	 * @brief Current manager instance accessor.
+	 *
+	 * @details
+	 * Returns the calling thread current manager if it is set, otherwise the manager singleton. Manager sets itself
+	 * as the thread current while running events, subscribers and system creation or destruction, so systems of the
+	 * multiple independent managers can use singletons and subscription macros on separate threads at the same time.
 	 */
-	bool has(std::type_index type) const noexcept
+	class Instance final
 	{
-		return systems.find(type) != systems.end();
-	}
+	public:
+		/**
+		 * @brief Returns true if thread current or singleton manager instance is exist.
+		 */
+		static bool has() noexcept { return getThreadCurrent() || singletonInstance; }
+		/**
+		 * @brief Returns thread current or singleton manager instance.
+		 * @throw EcsmError if manager instance is not set.
+		 */
+		static Manager* get()
+		{
+			if (auto manager = getThreadCurrent())
+				return manager;
+			return Singleton::get();
+		}
+		/**
+		 * @brief Returns thread current or singleton manager instance if exist.
+		 */
+		static Manager* tryGet() noexcept
+		{
+			auto manager = getThreadCurrent();
+			return manager ? manager : singletonInstance;
+		}
+	};
+
 	/**
-	 * @brief Returns true if system is created.
-	 * @tparam T target system type
+	 * @brief Calling thread current manager scope. (RAII)
+	 * @details Sets thread current manager on creation and restores the previous one on destruction.
 	 */
-	template<class T = System>
-	bool has() const noexcept
+	class CurrentScope final
 	{
-		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		return has(typeid(T));
-	}
+		Manager* previous = nullptr;
+	public:
+		/**
+		 * @brief Sets calling thread current manager instance.
+		 * @param[in] manager target manager instance
+		 */
+		explicit CurrentScope(Manager* manager) noexcept : previous(getThreadCurrent())
+		{
+			setThreadCurrent(manager);
+		}
+		/**
+		 * @brief Restores previous calling thread current manager instance.
+		 */
+		~CurrentScope() { setThreadCurrent(previous); }
 
-	/**
+		CurrentScope(const CurrentScope&) = delete;
+		CurrentScope& operator=(const CurrentScope&) = delete;
+	};
+
+	/*******************************************************************************************************************
+	 * @brief Concurrent read-only access phase scope. (RAII)
+	 * @details Calls @ref Manager::beginRead() on creation and @ref Manager::endRead() on destruction.
+	 */
+	class ReadScope final
+	{
+		Manager* manager = nullptr;
+	public:
+		/**
+		 * @brief Begins manager read-only access phase.
+		 * @param[in] manager target manager instance
+		 */
+		explicit ReadScope(Manager* manager) noexcept : manager(manager)
+		{
+			assert(manager);
+			manager->beginRead();
+		}
+		/**
+		 * @brief Ends manager read-only access phase.
+		 */
+		~ReadScope() { manager->endRead(); }
+
+		ReadScope(const ReadScope&) = delete;
+		ReadScope& operator=(const ReadScope&) = delete;
+	};
+
+	/*******************************************************************************************************************
+	 * @brief Recorder of the deferred entity and component changes. (Per thread)
+	 *
+	 * @details
+	 * Use @ref Manager::getCommandBuffer() to get calling thread buffer, commands are recorded without locking. 
+	 * Recorded commands are executed in bulk by the @ref Manager::executeCommands(), which is called inside the
+	 * @ref Manager::update() after events and before the garbage components dispose. Commands are executed in 
+	 * the sort key order, and in the record order for the same sort key. Use unique sort key per task (for example
+	 * parallel for batch index) to get the deterministic command execution order regardless of the thread timing.
+	 *
+	 * @warning Do not use command buffer of other thread, and do not record commands during the execution.
+	 */
+	class CommandBuffer final
+	{
+	public:
+		/**
+		 * @brief Recorded command target entity.
+		 * @details Existing entity instance or deferred entity created by the same command buffer.
+		 */
+		struct Target final
+		{
+			ID<Entity> entity;
+			uint32_t createdIndex; /**< Deferred entity index + 1 in the command buffer. */
+
+			/**
+			 * @brief Creates a new null command target.
+			 */
+			constexpr Target() noexcept : entity(), createdIndex(0) { }
+			/**
+			 * @brief Creates a new existing entity command target.
+			 * @param entity target entity instance
+			 */
+			constexpr Target(ID<Entity> entity) noexcept : entity(entity), createdIndex(0) { }
+
+			/**
+			 * @brief Returns true if command target is not null.
+			 */
+			constexpr explicit operator bool() const noexcept { return entity || createdIndex; }
+		};
+		/**
+		 * @brief Deferred component initializer function.
+		 */
+		using Initializer = std::function<void(View<Component>)>;
+	private:
+		enum class CommandType : uint8_t
+		{
+			CreateEntity, Destroy, Add, Remove, Copy
+		};
+		struct Command final
+		{
+			TypeIndex componentType = getTypeIndex<void>();
+			Target target, source;
+			uint32_t sortKey = 0;
+			uint32_t initializer = 0;
+			CommandType type = {};
+		};
+
+		// Note: command buffer is filled by other threads, so it can not use manager memory resource.
+		std::vector<Command> commands;
+		std::vector<Initializer> initializers;
+		std::vector<ID<Entity>> createdEntities;
+		std::thread::id threadID;
+		uint32_t createdCount = 0;
+		uint32_t sortKey = 0;
+
+		void addCommand(CommandType type, Target target, TypeIndex componentType, 
+			Target source, uint32_t initializer)
+		{
+			assert(target);
+			commands.push_back({ componentType, target, source, sortKey, initializer, type });
+		}
+		ID<Entity> getEntity(Target target) const noexcept
+		{
+			return target.entity ? target.entity : createdEntities[target.createdIndex - 1];
+		}
+		void clear() noexcept
+		{
+			commands.clear();
+			initializers.clear();
+			createdEntities.clear();
+			createdCount = 0;
+		}
+
+		CommandBuffer(std::thread::id threadID) noexcept : threadID(threadID) { }
+		friend class Manager;
+	public:
+		/**
+		 * @brief Returns current command sort key.
+		 */
+		uint32_t getSortKey() const noexcept { return sortKey; }
+		/**
+		 * @brief Sets sort key of the following recorded commands.
+		 * @details Commands are executed in the sort key order. (See the @ref CommandBuffer)
+		 * @param sortKey target command sort key value
+		 */
+		void setSortKey(uint32_t sortKey) noexcept { this->sortKey = sortKey; }
+
+		/**
+		 * @brief Returns recorded command count.
+		 */
+		uint32_t getCommandCount() const noexcept { return (uint32_t)commands.size(); }
+		/**
+		 * @brief Returns true if there are no recorded commands.
+		 */
+		bool isEmpty() const noexcept { return commands.empty(); }
+
+		/***************************************************************************************************************
+		 * @brief Records a new entity creation.
+		 * @details Entity is created on the command execution, use returned target in the following commands.
+		 */
+		Target createEntity()
+		{
+			Target target;
+			target.createdIndex = ++createdCount;
+			addCommand(CommandType::CreateEntity, target, getTypeIndex<void>(), {}, 0);
+			return target;
+		}
+		/**
+		 * @brief Records entity destruction.
+		 * @param entity target entity instance or deferred entity
+		 */
+		void destroy(Target entity) { addCommand(CommandType::Destroy, entity, getTypeIndex<void>(), {}, 0); }
+
+		/**
+		 * @brief Records a new component addition to the entity.
+		 * @details See the @ref Manager::add().
+		 * 
+		 * @param entity target entity instance or deferred entity
+		 * @param componentType target component TypeIndex
+		 * @param[in] initializer component initializer function or null
+		 */
+		void add(Target entity, TypeIndex componentType, Initializer initializer = nullptr)
+		{
+			auto index = 0u;
+			if (initializer)
+			{
+				initializers.push_back(std::move(initializer));
+				index = (uint32_t)initializers.size();
+			}
+			addCommand(CommandType::Add, entity, componentType, {}, index);
+		}
+		/**
+		 * @brief Records a new component addition to the entity.
+		 * @details See the @ref Manager::add().
+		 * 
+		 * @param entity target entity instance or deferred entity
+		 * @tparam T target component type
+		 */
+		template<class T = Component>
+		void add(Target entity)
+		{
+			static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+			add(entity, getTypeIndex<T>());
+		}
+		/**
+		 * @brief Records a new component addition to the entity with data initialization.
+		 * @details Initializer function signature: void(T& component). Called after the component addition.
+		 * 
+		 * @param entity target entity instance or deferred entity
+		 * @param initializer component initializer function
+		 * @tparam T target component type
+		 */
+		template<class T = Component, class Function, std::enable_if_t<std::is_invocable_v<Function, T&>, int> = 0>
+		void add(Target entity, Function&& initializer)
+		{
+			static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+			add(entity, getTypeIndex<T>(), [function = std::forward<Function>(initializer)](View<Component> component)
+			{
+				auto componentView = View<T>(component);
+				function(**componentView);
+			});
+		}
+
+		/**
+		 * @brief Records component removal from the entity.
+		 * @details See the @ref Manager::remove().
+		 * 
+		 * @param entity target entity instance or deferred entity
+		 * @param componentType target component TypeIndex
+		 */
+		void remove(Target entity, TypeIndex componentType)
+		{
+			addCommand(CommandType::Remove, entity, componentType, {}, 0);
+		}
+		/**
+		 * @brief Records component removal from the entity.
+		 * @details See the @ref Manager::remove().
+		 * 
+		 * @param entity target entity instance or deferred entity
+		 * @tparam T target component type
+		 */
+		template<class T = Component>
+		void remove(Target entity)
+		{
+			static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+			remove(entity, getTypeIndex<T>());
+		}
+
+		/**
+		 * @brief Records component data copying from source entity to destination.
+		 * @details See the @ref Manager::copy().
+		 * 
+		 * @param source copy from entity instance or deferred entity
+		 * @param destination copy to entity instance or deferred entity
+		 * @param componentType target component TypeIndex
+		 */
+		void copy(Target source, Target destination, TypeIndex componentType)
+		{
+			assert(source);
+			addCommand(CommandType::Copy, destination, componentType, source, 0);
+		}
+		/**
+		 * @brief Records component data copying from source entity to destination.
+		 * @details See the @ref Manager::copy().
+		 * 
+		 * @param source copy from entity instance or deferred entity
+		 * @param destination copy to entity instance or deferred entity
+		 * @tparam T target component type
+		 */
+		template<class T = Component>
+		void copy(Target source, Target destination)
+		{
+			static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+			copy(source, destination, getTypeIndex<T>());
+		}
+	};
+
+	/**
+	 * @brief Resolved schedule graph node. (Ordered event subscriber)
+	 */
+	struct ScheduleNode final
+	{
+		const Event* event = nullptr;
+		uint32_t subscriber = 0;
+		uint32_t dependencyCount = 0;
+		std::vector<uint32_t> successors;
+		double cost = 0.0;     /**< Measured subscriber execution time moving average. (nanoseconds) */
+		double priority = 0.0; /**< Critical path cost from this node to the end of the frame. */
+	};
+	/**
+	 * @brief Resolved schedule graph edge.
+	 */
+	struct ScheduleEdge final
+	{
+		uint32_t from = 0, to = 0;
+		std::string reason;
+	};
+
+	using Systems = std::pmr::unordered_map<TypeIndex, System*>;
+	using ComponentTypes = std::pmr::unordered_map<TypeIndex, System*>;
+	using ComponentNames = std::pmr::map<std::string, System*>;
+	using Events = std::pmr::unordered_map<std::string_view, Event*>;
+	using OrderedEvents = std::pmr::vector<const Event*>;
+	using EntityPool = LinearPool<Entity>;
+	using GarbageComponent = std::pair<TypeIndex, ID<Entity>>;
+	using GarbageComponents = std::pmr::vector<GarbageComponent>;
+	using ComponentChange = std::pair<TypeIndex, ID<Entity>>;
+	using ComponentChanges = std::pmr::vector<ComponentChange>;
+	using Queries = std::pmr::vector<Query*>;
+	using ScheduleNodes = std::vector<ScheduleNode>;
+	using ScheduleEdges = std::vector<ScheduleEdge>;
+private:
+	std::pmr::memory_resource* memoryResource = nullptr;
+	Systems systems;
+	ComponentTypes componentTypes;
+	ComponentNames componentNames;
+	EntityPool entities;
+	ArchetypeStorage archetypes;
+	Events events;
+	std::pmr::vector<Event*> eventSlots;
+	OrderedEvents orderedEvents;
+	ID<Event> preInitEvent, initEvent, postInitEvent, preDeinitEvent, deinitEvent, postDeinitEvent;
+	GarbageComponents garbageComponents;
+	std::pmr::vector<System*> garbageSystems;
+	ComponentChanges addedComponents;
+	ComponentChanges removedComponents;
+	std::pmr::vector<ID<Component>> batchComponents;
+	std::pmr::vector<System*> staticComponentTypes;
+	std::pmr::vector<System*> staticSystemTypes;
+	Queries queries;
+	std::pmr::vector<Queries> typeQueries;
+	ThreadPool* threadPool = nullptr;
+	Profiler* profiler = nullptr;
+	ScheduleNodes scheduleNodes;
+	ScheduleEdges scheduleEdges;
+	std::vector<uint32_t> scheduleOrder;
+	std::unique_ptr<std::atomic<uint32_t>[]> scheduleCounters;
+	std::mutex locker;
+	std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+	std::vector<std::pair<uint32_t, uint32_t>> commandOrder;
+	std::vector<ID<Entity>> commandEntities;
+	std::mutex commandBufferLocker;
+	uint64_t instanceIndex = 0;
+	uint64_t frameIndex = 1;
+	int64_t disposeTimeBudget = 0;
+	std::atomic<uint32_t> readerCount = 0;
+	uint32_t disposeCountBudget = 0;
+	uint32_t componentTypeCount = 0;
+	bool initialized = false;
+	bool scheduleEnabled = false;
+	bool isScheduleDirty = true;
+	bool trackChanges = false;
+	bool keepDestroyedEntities = false;
+
+	#ifndef NDEBUG
+	ChangeState isChanging;
+	#endif
+
+	// Checked in release build too, it is a single relaxed load per structural change.
+	void checkWriteAccess() const
+	{
+		if (readerCount.load(std::memory_order_relaxed) != 0)
+			throw EcsmError("Manager change inside the read phase is not allowed.");
+	}
+
+	void addSystem(System* system, TypeIndex type, uint32_t staticTypeID);
+	void runSubscribers(const Event* event);
+	void runEventSubscribers(const Event* event);
+	void runSubscriber(const Event* event, uint32_t index);
+	void addPoolCounters();
+	void advanceFrame();
+	void addRemovedComponents(ID<Entity> entity);
+	void disposeGarbageComponent(const GarbageComponent& garbageComponent);
+	void disposeGarbageComponent(ID<Entity> entity, TypeIndex componentType);
+	void addSubscriber(Event* event, Delegate onEvent, const ComponentAccess& access);
+	bool removeSubscriber(Event* event, Delegate onEvent);
+	Event* addEvent(std::string_view name, bool isOrdered);
+	void removeEvent(Event* event);
+	void buildSchedule();
+	void runScheduleNode(uint32_t node);
+
+	Query& getQuery(const TypeIndex* includeTypes, uint32_t includeCount,
+		const TypeIndex* excludeTypes, uint32_t excludeCount);
+	bool isQueryMatch(const Query* query, ID<Entity> entity) const noexcept;
+	void addQueryEntity(Query* query, ID<Entity> entity);
+	void removeQueryEntity(Query* query, ID<Entity> entity);
+	void updateQueries(ID<Entity> entity, uint32_t componentType);
+	void removeQueriesEntity(ID<Entity> entity);
+	void destroyQueries(uint32_t componentType);
+
+	template<class F>
+	struct MemberClass;
+	template<class C, class R, class... A>
+	struct MemberClass<R(C::*)(A...)> { using Type = C; };
+	template<class C>
+	struct IsComponentSystem : std::false_type { };
+	template<class T, bool D, class P>
+	struct IsComponentSystem<ComponentSystem<T, D, P>> : std::true_type { };
+
+	// Not accessible copy function is treated as overridden.
+	template<class T, class = void>
+	struct IsBulkCopyable : std::false_type { };
+	template<class T>
+	struct IsBulkCopyable<T, std::void_t<decltype(&T::copyComponent)>> :
+		IsComponentSystem<typename MemberClass<decltype(&T::copyComponent)>::Type> { };
+
+	friend class Entity;
+
+	template<class... Components, size_t... I, class Function>
+	static void eachQuery(const Query& query, uint32_t index, std::index_sequence<I...>, Function& function)
+	{
+		auto components = query.getComponents(index);
+		auto systems = query.includeSystems.data();
+		function(query.entities[index], (**View<Components>(systems[I]->getComponent(components[I])))...);
+	}
+
+	System* findComponentSystem(TypeIndex componentType) const noexcept
+	{
+		auto result = componentTypes.find(componentType);
+		return result == componentTypes.end() ? nullptr : result->second;
+	}
+	const Entity::ComponentData* findComponent(ID<Entity> entity, TypeIndex componentType) const noexcept
+	{
+		assert(entity);
+		auto system = findComponentSystem(componentType);
+		if (!system)
+			return nullptr;
+		auto entityView = entities.tryGet(entity); // Stale entity has no components, also in release build.
+		return entityView ? entityView->findComponent(system->componentTypeID) : nullptr;
+	}
+	template<class T>
+	System* findComponentSystem() const noexcept
+	{
+		auto staticTypeID = getStaticTypeID<T>();
+		if (staticTypeID < staticComponentTypes.size() && staticComponentTypes[staticTypeID])
+			return staticComponentTypes[staticTypeID];
+		return findComponentSystem(getTypeIndex<T>()); // Custom system without static type identifier.
+	}
+	template<class T>
+	const Entity::ComponentData* findComponent(ID<Entity> entity) const noexcept
+	{
+		assert(entity);
+		auto system = findComponentSystem<T>();
+		if (!system)
+			return nullptr;
+		auto entityView = entities.tryGet(entity); // Stale entity has no components, also in release build.
+		return entityView ? entityView->findComponent(system->componentTypeID) : nullptr;
+	}
+
+	View<Component> addComponent(ID<Entity> entity, System* system, TypeIndex componentType);
+	void addComponents(const ID<Entity>* entities, uint32_t count, System* system, TypeIndex componentType);
+public:
+	bool isRunning = false;
+
+	/**
+	 * @brief Creates a new manager instance.
+	 *
+	 * @details
+	 * Memory resource is used by the entity pool, entity component arrays, system and event tables and by the
+	 * component pools of the systems created afterwards. It allows to place manager in the preallocated arena
+	 * or to track manager memory usage. Memory resource should outlive the manager.
+	 * 
+	 * @param setSingleton set manager singleton instance
+	 * @param[in] memoryResource manager memory resource (pmr)
+	 */
+	Manager(bool setSingleton = true, std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+	/**
+	 * @brief Destroys manager and all components/entities/systems.
+	 */
+	~Manager();
+
+	/**
+	 * @brief Returns manager memory resource.
+	 */
+	std::pmr::memory_resource* getMemoryResource() const noexcept { return memoryResource; }
+
+	/*******************************************************************************************************************
+	 * @brief Creates a new system instance.
+	 * 
+	 * @details
+	 * Instantiates a new system and registers it component, 
+	 * but initialization occurs only after the @ref initialize() call.
+	 * 
+	 * @tparam T target system type
+	 * @tparam Args additional argument types
+	 * @param args additional system creation arguments
+	 * 
+	 * @throw EcsmError if system is already created or component type registered.
+	 */
+	template<class T = System, typename... Args>
+	void createSystem(Args&&... args)
+	{
+		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
+		checkWriteAccess();
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Creation of the system inside other create/destroy is not allowed.");
+		isChanging = true;
+		#endif
+
+		CurrentScope currentScope(this);
+		auto system = new T(std::forward<Args>(args)...);
+		system->bulkCopy = IsBulkCopyable<T>::value;
+		addSystem(system, getTypeIndex<T>(), getStaticTypeID<T>());
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+
+	/**
+	 * @brief Terminates and destroys system.
+	 * @param type target system TypeIndex
+	 * @throw EcsmError if system is not found.
+	 */
+	void destroySystem(TypeIndex type);
+	/**
+	 * @brief Terminates and destroys system.
+	 * @tparam T target system type
+	 * @throw EcsmError if system is not found.
+	 */
+	template<class T = System>
+	void destroySystem()
+	{
+		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
+		destroySystem(getTypeIndex<T>());
+	}
+
+	/**
+	 * @brief Terminates and destroys system if exist.
+	 * @param type target system TypeIndex
+	 * @return True if system is destroyed, otherwise false.
+	 */
+	bool tryDestroySystem(TypeIndex type);
+	/**
+	 * @brief Terminates and destroys system if exist.
+	 * @tparam T target system type
+	 * @return True if system is destroyed, otherwise false.
+	 */
+	template<class T = System>
+	bool tryDestroySystem()
+	{
+		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
+		return tryDestroySystem(getTypeIndex<T>());
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns true if system is created.
+	 * @param type target system TypeIndex
+	 */
+	bool has(TypeIndex type) const noexcept
+	{
+		return systems.find(type) != systems.end();
+	}
+	/**
+	 * @brief Returns true if system is created.
+	 * @tparam T target system type
+	 */
+	template<class T = System>
+	bool has() const noexcept
+	{
+		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
+		return findSystem(getStaticTypeID<T>());
+	}
+
+	/**
 	 * @brief Returns system instance.
 	 * @warning Be carefull with system pointer, it can be destroyed later.
-	 * @param type target system typeid()
+	 * @param type target system TypeIndex
 	 * @throw EcsmError if system is not found.
 	 */
-	System* get(std::type_index type) const
+	System* get(TypeIndex type) const
 	{
 		auto result = systems.find(type);
 		if (result == systems.end())
@@ -359,14 +1315,26 @@ public:
 	T* get() const
 	{
 		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		return (T*)get(typeid(T));
+		auto system = findSystem(getStaticTypeID<T>());
+		if (!system)
+			throw EcsmError("System is not created. (type: " + typeToString(getTypeIndex<T>()) + ")");
+		return (T*)system;
 	}
 
+	/**
+	 * @brief Returns system instance by the static type identifier if created, otherwise nullptr.
+	 * @details Lookup is a single array load, used by the templated system functions and singletons.
+	 * @param staticTypeID target system static type identifier (See the @ref getStaticTypeID())
+	 */
+	System* findSystem(uint32_t staticTypeID) const noexcept
+	{
+		return staticTypeID < staticSystemTypes.size() ? staticSystemTypes[staticTypeID] : nullptr;
+	}
 	/**
 	 * @brief Returns system instance if created, otherwise nullptr.
-	 * @param type target system typeid()
+	 * @param type target system TypeIndex
 	 */
-	System* tryGet(std::type_index type) const noexcept
+	System* tryGet(TypeIndex type) const noexcept
 	{
 		auto result = systems.find(type);
 		return result == systems.end() ? nullptr : result->second;
@@ -379,26 +1347,81 @@ public:
 	T* tryGet() const noexcept
 	{
 		static_assert(std::is_base_of_v<System, T>, "Must be derived from the System class.");
-		return (T*)tryGet(typeid(T));
+		return (T*)findSystem(getStaticTypeID<T>());
 	}
 
 	/*******************************************************************************************************************
 	 * @brief Creates a new entity instance.
 	 * @details Created entity does not have any default component.
 	 */
-	ID<Entity> createEntity() { return entities.create(); }
+	ID<Entity> createEntity()
+	{
+		checkWriteAccess();
+		return entities.create();
+	}
+	/**
+	 * @brief Creates a new entity instances at once.
+	 * @details Reserves entity memory only once. Created entities do not have any default component.
+	 * 
+	 * @param[out] instances created entity instance array (count size)
+	 * @param count entity count to create
+	 */
+	void createEntities(ID<Entity>* instances, uint32_t count)
+	{
+		checkWriteAccess();
+		entities.createMany(instances, count);
+	}
+	/**
+	 * @brief Creates a new entity instances at once.
+	 * @details See the @ref createEntities(ID<Entity>* instances, uint32_t count).
+	 * @param count entity count to create
+	 */
+	std::vector<ID<Entity>> createEntities(uint32_t count)
+	{
+		std::vector<ID<Entity>> instances(count);
+		createEntities(instances.data(), count);
+		return instances;
+	}
 	/**
 	 * @brief Destroys entity instance and it components.
 	 * @note Entities are not destroyed immediately, only after the dispose call.
 	 * @param instance target entity instance or null
 	 */
-	void destroy(ID<Entity> instance) { entities.destroy(instance); }
+	void destroy(ID<Entity> instance)
+	{
+		checkWriteAccess();
+		if (instance && !queries.empty())
+			removeQueriesEntity(instance);
+		if (trackChanges)
+			addRemovedComponents(instance);
+		entities.destroy(instance);
+	}
+	/**
+	 * @brief Destroys entity instances and their components.
+	 * @note Entities are not destroyed immediately, only after the dispose call.
+	 * 
+	 * @param[in] instances target entity instance array (can contain nulls)
+	 * @param count entity instance count
+	 */
+	void destroy(const ID<Entity>* instances, uint32_t count);
+	/**
+	 * @brief Destroys entity instances and their components.
+	 * @note Entities are not destroyed immediately, only after the dispose call.
+	 * @param[in] instances target entity instance array (can contain nulls)
+	 */
+	void destroy(const std::vector<ID<Entity>>& instances) { destroy(instances.data(), (uint32_t)instances.size()); }
 	/**
 	 * @brief Returns entity internal data accessor. (@ref View)
 	 * @warning Do not store views, use them only in place. Because entity memory can be reallocated later.
 	 * @param instance target entity instance
 	 */
 	View<Entity> get(ID<Entity> instance) const noexcept { return entities.get(instance); }
+	/**
+	 * @brief Returns true if entity instance is not null and not stale. (Entity is not disposed)
+	 * @details Checks entity slot generation, destroyed but not yet disposed entities are still valid.
+	 * @param instance target entity instance or null
+	 */
+	bool isValid(ID<Entity> instance) const noexcept { return entities.isValid(instance); }
 	
 	/*******************************************************************************************************************
 	 * @brief Adds a new component to the entity.
@@ -406,12 +1429,15 @@ public:
 	 * @warning Do not store views, use them only in place. Because component memory can be reallocated later.
 	 * 
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 * 
 	 * @return Returns @ref View of the created component.
 	 * @throw EcsmError if component type is not registered, or component is already added.
 	 */
-	View<Component> add(ID<Entity> entity, std::type_index componentType);
+	View<Component> add(ID<Entity> entity, TypeIndex componentType)
+	{
+		return addComponent(entity, findComponentSystem(componentType), componentType);
+	}
 
 	/**
 	 * @brief Adds a new component to the entity.
@@ -432,7 +1458,56 @@ public:
 	View<T> add(ID<Entity> entity)
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return View<T>(add(entity, typeid(T)));
+		return View<T>(addComponent(entity, findComponentSystem<T>(), getTypeIndex<T>()));
+	}
+
+	/**
+	 * @brief Adds a new component to the each entity.
+	 * 
+	 * @details
+	 * Resolves component system and creates all components at once, it is much faster than adding
+	 * components one by one when spawning a lot of entities. Each entity should be unique in the array.
+	 * 
+	 * @param[in] entities target entity instance array
+	 * @param count entity instance count
+	 * @param componentType target component TypeIndex
+	 * 
+	 * @throw EcsmError if component type is not registered, or component is already added.
+	 */
+	void add(const ID<Entity>* entities, uint32_t count, TypeIndex componentType)
+	{
+		addComponents(entities, count, findComponentSystem(componentType), componentType);
+	}
+	/**
+	 * @brief Adds a new component to the each entity.
+	 * @details See the @ref add(const ID<Entity>* entities, uint32_t count, TypeIndex componentType).
+	 *
+	 * @param[in] entities target entity instance array
+	 * @param count entity instance count
+	 * @tparam T target component type
+	 * 
+	 * @throw EcsmError if component type is not registered, or component is already added.
+	 */
+	template<class T = Component>
+	void add(const ID<Entity>* entities, uint32_t count)
+	{
+		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+		addComponents(entities, count, findComponentSystem<T>(), getTypeIndex<T>());
+	}
+	/**
+	 * @brief Adds a new component to the each entity.
+	 * @details See the @ref add(const ID<Entity>* entities, uint32_t count, TypeIndex componentType).
+	 *
+	 * @param[in] entities target entity instance array
+	 * @tparam T target component type
+	 * 
+	 * @throw EcsmError if component type is not registered, or component is already added.
+	 */
+	template<class T = Component>
+	void add(const std::vector<ID<Entity>>& entities)
+	{
+		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+		addComponents(entities.data(), (uint32_t)entities.size(), findComponentSystem<T>(), getTypeIndex<T>());
 	}
 
 	/**
@@ -441,11 +1516,11 @@ public:
 	 * @note Components are not destroyed immediately, only after the dispose call.
 	 *
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 * 
 	 * @throw EcsmError if component is not found.
 	 */
-	void remove(ID<Entity> entity, std::type_index componentType);
+	void remove(ID<Entity> entity, TypeIndex componentType);
 	/**
 	 * @brief Removes component from the entity.
 	 * @details Component data destruction is handled by the @ref System.
@@ -460,7 +1535,7 @@ public:
 	void remove(ID<Entity> entity)
 	{ 
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		remove(entity, typeid(T));
+		remove(entity, getTypeIndex<T>());
 	}
 
 	/**
@@ -469,11 +1544,12 @@ public:
 	 * @note Components are not destroyed immediately, only after the dispose call.
 	 *
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 */
-	bool isGarbage(ID<Entity> entity, std::type_index componentType) const noexcept
+	bool isGarbage(ID<Entity> entity, TypeIndex componentType) const noexcept
 	{
-		return garbageComponents.find(std::make_pair(componentType, entity)) != garbageComponents.end();
+		auto component = findComponent(entity, componentType);
+		return component && component->isGarbage;
 	}
 	/**
 	 * @brief Returns true if target entity component was removed and is in the garbage pool.
@@ -487,7 +1563,8 @@ public:
 	bool isGarbage(ID<Entity> entity) const noexcept
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return isGarbage(entity, typeid(T));
+		auto component = findComponent<T>(entity);
+		return component && component->isGarbage;
 	}
 
 	/*******************************************************************************************************************
@@ -496,11 +1573,11 @@ public:
 	 *
 	 * @param source copy from entity instance
 	 * @param destination copy to entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 *
 	 * @throw EcsmError if source or destination component is not found.
 	 */
-	void copy(ID<Entity> source, ID<Entity> destination, std::type_index componentType);
+	void copy(ID<Entity> source, ID<Entity> destination, TypeIndex componentType);
 	/**
 	 * @brief Copies component data from source entity to destination.
 	 * @details Component data copying is handled by the @ref System.
@@ -515,7 +1592,7 @@ public:
 	void copy(ID<Entity> source, ID<Entity> destination)
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		copy(source, destination, typeid(T));
+		copy(source, destination, getTypeIndex<T>());
 	}
 
 	/**
@@ -525,23 +1602,63 @@ public:
 	 */
 	ID<Entity> duplicate(ID<Entity> entity);
 
-	/*******************************************************************************************************************
-	 * @brief Returns true if entity has target component.
-	 * @note It also checks for component in the garbage pool.
+	/**
+	 * @brief Creates a new prefab from the template entity components.
+	 * @details See the @ref Prefab and @ref instantiate().
+	 * @param entity target template entity instance
+	 * @throw EcsmError if entity has @ref DoNotDuplicateComponent.
+	 */
+	Prefab createPrefab(ID<Entity> entity) const;
+	/**
+	 * @brief Creates a new entities with copies of the prefab components.
 	 *
-	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @details
+	 * Creates all entities at once, then creates and copies components of each prefab system in bulk.
+	 * It is much faster than duplicating template entity several times. (See the @ref System::copyComponents())
+	 * 
+	 * @param[in] prefab target prefab to instantiate
+	 * @param[out] instances created entity instance array (count size)
+	 * @param count entity count to create
 	 */
-	bool has(ID<Entity> entity, std::type_index componentType) const noexcept
+	void instantiate(const Prefab& prefab, ID<Entity>* instances, uint32_t count);
+	/**
+	 * @brief Creates a new entities with copies of the prefab components.
+	 * @details See the @ref instantiate(const Prefab& prefab, ID<Entity>* instances, uint32_t count).
+	 * @param[in] prefab target prefab to instantiate
+	 * @param count entity count to create
+	 */
+	std::vector<ID<Entity>> instantiate(const Prefab& prefab, uint32_t count)
 	{
-		assert(entity);
-		const auto& components = entities.get(entity)->components;
-		return components.find(componentType) != components.end() && garbageComponents.find(
-			make_pair(componentType, entity)) == garbageComponents.end();
+		std::vector<ID<Entity>> instances(count);
+		instantiate(prefab, instances.data(), count);
+		return instances;
 	}
 	/**
-	 * @brief Returns true if entity has target component.
-	 * @note It also checks for component in the garbage pool.
+	 * @brief Creates a new entity with copies of the prefab components.
+	 * @param[in] prefab target prefab to instantiate
+	 */
+	ID<Entity> instantiate(const Prefab& prefab)
+	{
+		ID<Entity> instance;
+		instantiate(prefab, &instance, 1);
+		return instance;
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns true if entity has target component.
+	 * @note Removed components in the garbage pool are not counted. (See the @ref isGarbage())
+	 *
+	 * @param entity entity instance
+	 * @param componentType target component TypeIndex
+	 */
+	bool has(ID<Entity> entity, TypeIndex componentType) const noexcept
+	{
+		auto component = findComponent(entity, componentType);
+		return component && !component->isGarbage;
+	}
+	/**
+	 * @brief Returns true if entity has target component.
+	 * @note Removed components in the garbage pool are not counted. (See the @ref isGarbage())
 	 *
 	 * @param entity entity instance
 	 * @tparam T target component type
@@ -550,7 +1667,8 @@ public:
 	bool has(ID<Entity> entity) const noexcept
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return has(entity, typeid(T));
+		auto component = findComponent<T>(entity);
+		return component && !component->isGarbage;
 	}
 
 	/**
@@ -558,25 +1676,20 @@ public:
 	 * @warning Do not store views, use them only in place. Because component memory can be reallocated later.
 	 * 
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 * 
 	 * @throw EcsmError if component is not found.
 	 */
-	View<Component> get(ID<Entity> entity, std::type_index componentType) const
+	View<Component> get(ID<Entity> entity, TypeIndex componentType) const
 	{
-		assert(entity);
-		auto entityView = entities.get(entity);
-		auto result = entityView->components.find(componentType);
-
-		if (result == entityView->components.end())
+		auto component = findComponent(entity, componentType);
+		if (!component)
 		{
 			throw EcsmError("Component is not added. ("
 				"type: " + typeToString(componentType) +
 				"entity:" + std::to_string(*entity) + ")");
 		}
-
-		auto pair = result->second;
-		return pair.first->getComponent(pair.second);
+		return component->system->getComponent(component->instance);
 	}
 	/**
 	 * @brief Returns component data accessor. (@ref View)
@@ -591,36 +1704,35 @@ public:
 	View<T> get(ID<Entity> entity) const
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return View<T>(get(entity, typeid(T)));
+		auto component = findComponent<T>(entity);
+		if (!component)
+		{
+			throw EcsmError("Component is not added. ("
+				"type: " + typeToString(getTypeIndex<T>()) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		return View<T>(component->system->getComponent(component->instance));
 	}
 
 	/**
 	 * @brief Returns component data accessor if exist, otherwise null. (@ref View)
 	 * @warning Do not store views, use them only in place. Because component memory can be reallocated later.
-	 * @note It also checks for component in the garbage pool.
+	 * @note Returns null for removed components in the garbage pool.
 	 * 
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 */
-	View<Component> tryGet(ID<Entity> entity, std::type_index componentType) const noexcept
+	View<Component> tryGet(ID<Entity> entity, TypeIndex componentType) const noexcept
 	{
-		assert(entity);
-		const auto& components = entities.get(entity)->components;
-		
-		auto result = components.find(componentType);
-		if (result == components.end() || garbageComponents.find(
-			make_pair(componentType, entity)) != garbageComponents.end())
-		{
+		auto component = findComponent(entity, componentType);
+		if (!component || component->isGarbage)
 			return {};
-		}
-
-		auto pair = result->second;
-		return pair.first->getComponent(pair.second);
+		return component->system->getComponent(component->instance);
 	}
 	/**
 	 * @brief Returns component data accessor if exist, otherwise null. (@ref View)
 	 * @warning Do not store views, use them only in place. Because component memory can be reallocated later.
-	 * @note It also checks for component in the garbage pool.
+	 * @note Returns null for removed components in the garbage pool.
 	 * 
 	 * @param entity entity instance
 	 * @tparam T target component type
@@ -629,7 +1741,10 @@ public:
 	View<T> tryGet(ID<Entity> entity) const noexcept
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return View<T>(tryGet(entity, typeid(T)));
+		auto component = findComponent<T>(entity);
+		if (!component || component->isGarbage)
+			return {};
+		return View<T>(component->system->getComponent(component->instance));
 	}
 
 	/*******************************************************************************************************************
@@ -637,24 +1752,20 @@ public:
 	 * @details See the getID<T>(ID<Entity> entity).
 	 *
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 * 
 	 * @throw EcsmError if component is not found.
 	 */
-	ID<Component> getID(ID<Entity> entity, std::type_index componentType) const
+	ID<Component> getID(ID<Entity> entity, TypeIndex componentType) const
 	{
-		assert(entity);
-		auto entityView = entities.get(entity);
-		auto result = entityView->components.find(componentType);
-
-		if (result == entityView->components.end())
+		auto component = findComponent(entity, componentType);
+		if (!component)
 		{
 			throw EcsmError("Component is not added. ("
 				"type: " + typeToString(componentType) +
 				"entity:" + std::to_string(*entity) + ")");
 		}
-
-		return result->second.second;
+		return component->instance;
 	}
 	/**
 	 * @brief Returns entity component @ref ID.
@@ -669,31 +1780,30 @@ public:
 	ID<T> getID(ID<Entity> entity) const
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return ID<T>(getID(entity, typeid(T)));
+		auto component = findComponent<T>(entity);
+		if (!component)
+		{
+			throw EcsmError("Component is not added. ("
+				"type: " + typeToString(getTypeIndex<T>()) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		return ID<T>(component->instance);
 	}
 
 	/*******************************************************************************************************************
 	 * @brief Returns entity component @ref ID if added, otherwise null.
-	 * @note It also checks for component in the garbage pool.
+	 * @note Returns null for removed components in the garbage pool.
 	 * @details See the tryGetID<T>(ID<Entity> entity).
 	 *
 	 * @param entity entity instance
-	 * @param componentType target component typeid()
+	 * @param componentType target component TypeIndex
 	 */
-	ID<Component> tryGetID(ID<Entity> entity, std::type_index componentType) const noexcept
+	ID<Component> tryGetID(ID<Entity> entity, TypeIndex componentType) const noexcept
 	{
-		assert(entity);
-		const auto& components = entities.get(entity)->components;
-
-		auto result = components.find(componentType);
-		if (result == components.end() || garbageComponents.find(
-			make_pair(componentType, entity)) != garbageComponents.end())
-		{
+		auto component = findComponent(entity, componentType);
+		if (!component || component->isGarbage)
 			return {};
-		}
-
-		auto pair = result->second;
-		return pair.second;
+		return component->instance;
 	}
 	/**
 	 * @brief Returns entity component @ref ID if added, otherwise null.
@@ -706,30 +1816,115 @@ public:
 	ID<T> tryGetID(ID<Entity> entity) const noexcept
 	{
 		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
-		return ID<T>(tryGetID(entity, typeid(T)));
+		auto component = findComponent<T>(entity);
+		if (!component || component->isGarbage)
+			return {};
+		return ID<T>(component->instance);
 	}
 
 	/**
-	 * @brief Returns entity component count.
+	 * @brief Returns entity component count, or 0 if entity is stale.
 	 * @param entity target entity instance
 	 */
 	uint32_t getComponentCount(ID<Entity> entity) const noexcept
 	{
-		return (uint32_t)entities.get(entity)->components.size();
+		auto entityView = entities.tryGet(entity);
+		return entityView ? entityView->count : 0;
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns cached query of the entities with all target components.
+	 *
+	 * @details
+	 * Query is created on the first call, using the smallest included component set to find matching
+	 * entities. After that it is updated incrementally on component add/remove and entity destruction.
+	 * Removed (garbage) components and destroyed entities are excluded from the query immediately.
+	 *
+	 * @warning Query reference is invalidated when any of the query component systems is destroyed.
+	 * @tparam Components included component types
+	 * @tparam Excluded excluded component types (@ref Exclude)
+	 *
+	 * @throw EcsmError if component type is not registered, or query is not prepared inside the read phase.
+	 */
+	template<class... Components, class... Excluded>
+	Query& query(Exclude<Excluded...> = {})
+	{
+		static_assert(sizeof...(Components) > 0, "Must have at least one component type.");
+		static_assert((std::is_base_of_v<Component, Components> && ...), "Must be derived from the Component struct.");
+		static_assert((std::is_base_of_v<Component, Excluded> && ...), "Must be derived from the Component struct.");
+
+		const TypeIndex includeTypes[] = { getTypeIndex<Components>()... };
+		if constexpr (sizeof...(Excluded) > 0)
+		{
+			const TypeIndex excludeTypes[] = { getTypeIndex<Excluded>()... };
+			return getQuery(includeTypes, sizeof...(Components), excludeTypes, sizeof...(Excluded));
+		}
+		else
+		{
+			return getQuery(includeTypes, sizeof...(Components), nullptr, 0);
+		}
+	}
+	/**
+	 * @brief Creates entity query ahead of time, so it can be used inside the read phase.
+	 * @details Queries can not be created inside the read phase. (See the @ref query() and @ref beginRead())
+	 *
+	 * @tparam Components included component types
+	 * @tparam Excluded excluded component types (@ref Exclude)
+	 *
+	 * @throw EcsmError if component type is not registered, or called inside the read phase.
+	 */
+	template<class... Components, class... Excluded>
+	void prepareQuery(Exclude<Excluded...> exclude = {}) { query<Components...>(exclude); }
+
+	/**
+	 * @brief Calls function for each entity with all target components.
+	 *
+	 * @details
+	 * Iterates over the cached query matching entity list. See the @ref query().
+	 * Function signature: void(ID<Entity>, Components&...)
+	 *
+	 * @warning Do not add or remove query components, or destroy matching entities inside the function.
+	 * @param function target function to call
+	 * @tparam Components included component types
+	 * @tparam Excluded excluded component types (@ref Exclude)
+	 *
+	 * @throw EcsmError if component type is not registered, or query is not prepared inside the read phase.
+	 */
+	template<class... Components, class Function, class... Excluded>
+	void each(Function&& function, Exclude<Excluded...> exclude = {})
+	{
+		auto& query = this->query<Components...>(exclude);
+
+		#ifndef NDEBUG // Changes are already forbidden inside the read phase, where several threads iterate query.
+		auto isReadPhase = readerCount.load(std::memory_order_relaxed) != 0;
+		auto wasIterating = query.isIterating;
+		if (!isReadPhase)
+			query.isIterating = true;
+		#endif
+
+		auto count = (uint32_t)query.entities.size();
+		for (uint32_t i = 0; i < count; i++)
+			eachQuery<Components...>(query, i, std::index_sequence_for<Components...>(), function);
+
+		#ifndef NDEBUG
+		if (!isReadPhase)
+			query.isIterating = wasIterating;
+		#endif
 	}
 
 	/*******************************************************************************************************************
 	 * @brief Registers a new unordered event.
 	 * @param[in] name target event name
+	 * @return Event handle, use it to run event without name lookup.
 	 * @throw EcsmError if event is already registered.
 	 */
-	void registerEvent(const std::string& name);
+	ID<Event> registerEvent(std::string_view name);
 	/**
 	 * @brief Registers a new unordered event if not exist.
 	 * @param[in] name target event name
 	 * @return True if event is registered, otherwise false.
 	 */
-	bool tryRegisterEvent(const std::string& name);
+	bool tryRegisterEvent(std::string_view name);
 
 	/**
 	 * @brief Registers a new ordered event before another.
@@ -737,115 +1932,194 @@ public:
 	 * @param[in] newEvent target event name
 	 * @param[in] beforeEvent name of the event after target event
 	 * 
+	 * @return Event handle, use it to run event without name lookup.
 	 * @throw EcsmError if event is already registered.
 	 */
-	void registerEventBefore(const std::string& newEvent, const std::string& beforeEvent);
+	ID<Event> registerEventBefore(std::string_view newEvent, std::string_view beforeEvent);
 	/**
 	 * @brief Registers a new ordered event after another.
 	 *
 	 * @param[in] newEvent target event name
 	 * @param[in] afterEvent name of the event before target event
 	 *
+	 * @return Event handle, use it to run event without name lookup.
 	 * @throw EcsmError if event is already registered.
 	 */
-	void registerEventAfter(const std::string& newEvent, const std::string& afterEvent);
+	ID<Event> registerEventAfter(std::string_view newEvent, std::string_view afterEvent);
 
 	/**
 	 * @brief Unregisters existing event.
 	 * @param[in] name target event name
 	 * @throw EcsmError if event is not registered, or not found.
 	 */
-	void unregisterEvent(const std::string& name);
+	void unregisterEvent(std::string_view name);
 	/**
 	 * @brief Unregisters event if exist.
 	 * @param[in] name target event name
 	 * @return True if event is unregistered, otherwise false.
 	 */
-	bool tryUnregisterEvent(const std::string& name);
+	bool tryUnregisterEvent(std::string_view name);
 
 	/**
 	 * @brief Returns true if event is registered.
 	 * @param[in] name target event name
 	 */
-	bool hasEvent(const std::string& name) const noexcept
+	bool hasEvent(std::string_view name) const noexcept
 	{
 		assert(!name.empty());
 		return events.find(name) != events.end();
 	}
+	/**
+	 * @brief Returns event handle.
+	 * @param[in] name target event name
+	 * @throw EcsmError if event is not registered.
+	 */
+	ID<Event> getEventID(std::string_view name) const
+	{
+		assert(!name.empty());
+		auto result = events.find(name);
+		if (result == events.end())
+			throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
+		return result->second->id;
+	}
+	/**
+	 * @brief Returns event holder by handle.
+	 * @param event target event handle
+	 * @throw EcsmError if event is unregistered.
+	 */
+	const Event& getEvent(ID<Event> event) const
+	{
+		assert(event);
+		assert(*event <= eventSlots.size());
+		auto eventData = eventSlots[*event - 1];
+		if (!eventData)
+			throw EcsmError("Event is not registered. (id: " + std::to_string(*event) + ")");
+		return *eventData;
+	}
 	/**
 	 * @brief Returns true if event is ordered.
 	 * @param[in] name target event name
 	 * @throw EcsmError if event is not registered.
 	 */
-	bool isEventOrdered(const std::string& name) const;
+	bool isEventOrdered(std::string_view name) const;
 	/**
 	 * @brief Returns all event subscribers.
 	 * @param[in] name target event name
 	 * @throw EcsmError if event is not registered.
 	 */
-	const Event::Subscribers& getEventSubscribers(const std::string& name) const;
+	const Event::Subscribers& getEventSubscribers(std::string_view name) const;
 	/**
 	 * @brief Returns true if event has subscribers.
 	 * @param[in] name target event name
 	 * @throw EcsmError if event is not registered.
 	 */
-	bool isEventHasSubscribers(const std::string& name) const;
+	bool isEventHasSubscribers(std::string_view name) const;
 
 	/**
 	 * @brief Calls all event subscribers.
 	 * @param[in] name target event name
 	 * @throw EcsmError if event is not registered.
 	 */
-	void runEvent(const std::string& name);
+	void runEvent(std::string_view name);
+	/**
+	 * @brief Calls all event subscribers without name lookup.
+	 * @param event target event handle
+	 * @throw EcsmError if event is unregistered.
+	 */
+	void runEvent(ID<Event> event) { runSubscribers(&getEvent(event)); }
 	/**
 	 * @brief Calls all event subscribers if event exist.
 	 * @param[in] name target event name
 	 * @return True if event is found.
 	 */
-	bool tryRunEvent(const std::string& name);
+	bool tryRunEvent(std::string_view name);
 	/**
 	 * @brief Runs all ordered events.
 	 * @details Unordered events subscribers are not called.
 	 */
 	void runOrderedEvents();
 
+	/**
+	 * @brief Runs all ordered event subscribers using the dependency graph.
+	 * 
+	 * @details
+	 * Builds directed acyclic graph from the ordered event subscribers. Subscriber depends on the previous
+	 * subscribers with conflicting component access (@ref ComponentAccess) and on all subscribers of the
+	 * systems it is declared to run after. Independent subscribers, including subscribers of different events,
+	 * are executed concurrently by the manager @ref ThreadPool. Ready subscribers with the longest remaining
+	 * critical path (measured execution time) are started first. Without thread pool subscribers are
+	 * executed sequentially in the resolved topological order.
+	 * 
+	 * @throw EcsmError if schedule graph has dependency cycle.
+	 */
+	void runSchedule();
+	/**
+	 * @brief Returns resolved schedule graph in the Graphviz DOT format.
+	 * @details Useful to see which dependencies are serializing the frame.
+	 * @throw EcsmError if schedule graph has dependency cycle.
+	 */
+	std::string getScheduleGraph();
+
 	/**
 	 * @brief Adds a new event subscriber.
+	 * @details Non-conflicting subscribers can be executed in parallel. (See the @ref ComponentAccess)
 	 * 
 	 * @param[in] name target event name
-	 * @param[in] onEvent on event function callback
+	 * @param[in] onEvent on event function delegate
+	 * @param[in] access subscriber component access
 	 * 
 	 * @throw EcsmError if event is not registered.
 	 */
-	void subscribeToEvent(const std::string& name, const std::function<void()>& onEvent);
+	void subscribeToEvent(std::string_view name, Delegate onEvent, const ComponentAccess& access = {});
 	/**
-	 * @brief Removes existing event subscriber.
+	 * @brief Adds a new event subscriber function object.
+	 * 
+	 * @details
+	 * Function object is copied to a separate heap allocation owned by the event. Use returned delegate to
+	 * unsubscribe it. This is a convenience overload for tests, tools and one-off callbacks, it is not zero cost:
+	 * subscribe allocates and each event run adds the std::function indirection on top of the delegate call.
 	 * 
+	 * @warning Prefer the @ref Delegate overload (ECSM_SUBSCRIBE_TO_EVENT macros) for the system hot path.
+	 *
 	 * @param[in] name target event name
 	 * @param[in] onEvent on event function callback
+	 * @param[in] access subscriber component access
+	 *
+	 * @return Subscriber delegate calling the function object copy.
+	 * @throw EcsmError if event is not registered.
+	 */
+	Delegate subscribeToEvent(std::string_view name, const std::function<void()>& onEvent, 
+		const ComponentAccess& access = {});
+	/**
+	 * @brief Removes existing event subscriber.
+	 * 
+	 * @param[in] name target event name
+	 * @param[in] onEvent on event function delegate
 	 * 
 	 * @throw EcsmError if event is not registered, or not subscribed.
 	 */
-	void unsubscribeFromEvent(const std::string& name, const std::function<void()>& onEvent);
+	void unsubscribeFromEvent(std::string_view name, Delegate onEvent);
 
 	/**
-	 * @brief Adds a new event subscriber if not exist.
+	 * @brief Adds a new event subscriber if event exist.
+	 * @details Non-conflicting subscribers can be executed in parallel. (See the @ref ComponentAccess)
 	 * 
 	 * @param[in] name target event name
-	 * @param[in] onEvent on event function callback
+	 * @param[in] onEvent on event function delegate
+	 * @param[in] access subscriber component access
 	 * 
 	 * @return True if subscribed to the event, otherwise false.
 	 */
-	bool trySubscribeToEvent(const std::string& name, const std::function<void()>& onEvent);
+	bool trySubscribeToEvent(std::string_view name, Delegate onEvent, const ComponentAccess& access = {});
 	/**
 	 * @brief Removes existing event subscriber if exist.
 	 * 
 	 * @param[in] name target event name
-	 * @param[in] onEvent on event function callback
+	 * @param[in] onEvent on event function delegate
 	 * 
-	 * @throw True if unsubscribed from the event, otherwise false.
+	 * @return True if unsubscribed from the event, otherwise false.
 	 */
-	bool tryUnsubscribeFromEvent(const std::string& name, const std::function<void()>& onEvent);
+	bool tryUnsubscribeFromEvent(std::string_view name, Delegate onEvent);
 
 	/*******************************************************************************************************************
 	 * @brief Returns all manager systems.
@@ -877,11 +2151,70 @@ public:
 	 * @note Use manager functions to access entities.
 	 */
 	const EntityPool& getEntities() const noexcept { return entities; }
+	/**
+	 * @brief Returns manager archetype component storage.
+	 * @details It is shared by all @ref ArchetypeSystem instances.
+	 */
+	ArchetypeStorage& getArchetypes() noexcept { return archetypes; }
+	/**
+	 * @brief Returns manager constant archetype component storage.
+	 * @details It is shared by all @ref ArchetypeSystem instances.
+	 */
+	const ArchetypeStorage& getArchetypes() const noexcept { return archetypes; }
 	/**
 	 * @brief Returns manager garbage components pool.
+	 * @details Removed components in the removal order, they are destroyed on dispose call.
 	 * @note Use manager functions to check if component is garbage.
 	 */
 	const GarbageComponents& getGarbageComponents() const noexcept { return garbageComponents; }
+	/**
+	 * @brief Returns all cached manager queries.
+	 * @note Use manager functions to create queries.
+	 */
+	const Queries& getQueries() const noexcept { return queries; }
+	/**
+	 * @brief Returns manager thread pool, or nullptr if events are executed sequentially.
+	 */
+	ThreadPool* getThreadPool() const noexcept { return threadPool; }
+	/**
+	 * @brief Sets thread pool used to execute non-conflicting event subscribers in parallel.
+	 * @details Thread pool is not owned by the manager. Set nullptr to execute all subscribers sequentially.
+	 * @warning Subscribers executed in parallel should not create or destroy entities and components.
+	 * @param threadPool target thread pool or null
+	 */
+	void setThreadPool(ThreadPool* threadPool) noexcept { this->threadPool = threadPool; }
+
+	/**
+	 * @brief Returns manager frame profiler, or null if not set.
+	 */
+	Profiler* getProfiler() const noexcept { return profiler; }
+	/**
+	 * @brief Sets manager frame profiler, or disables profiling if null.
+	 * @details Profiler is not owned by the manager, it should outlive the manager or be unset.
+	 * @param profiler target frame profiler or null
+	 */
+	void setProfiler(Profiler* profiler) noexcept { this->profiler = profiler; }
+
+	/**
+	 * @brief Returns true if @ref update() runs ordered events using the schedule. (See the @ref runSchedule())
+	 */
+	bool isScheduleEnabled() const noexcept { return scheduleEnabled; }
+	/**
+	 * @brief Sets if @ref update() should run ordered events using the schedule. (See the @ref runSchedule())
+	 * @param isEnabled use dependency graph schedule
+	 */
+	void setScheduleEnabled(bool isEnabled) noexcept { scheduleEnabled = isEnabled; }
+	/**
+	 * @brief Returns resolved schedule graph nodes.
+	 * @note Graph is rebuilt on the next @ref runSchedule() call after events change.
+	 */
+	const ScheduleNodes& getScheduleNodes() const noexcept { return scheduleNodes; }
+	/**
+	 * @brief Returns resolved schedule graph edges.
+	 * @note Graph is rebuilt on the next @ref runSchedule() call after events change.
+	 */
+	const ScheduleEdges& getScheduleEdges() const noexcept { return scheduleEdges; }
+
 	/**
 	 * @brief Returns true if manager is initialized.
 	 */
@@ -913,163 +2246,1077 @@ public:
 	/**
 	 * @brief Actually destroys system components and internal resources.
 	 * @details Systen components are not destroyed immediately, only after the dispose call.
+	 * @note Only systems queued by the @ref addGarbageSystem() are disposed.
 	 */
 	void disposeSystemComponents();
 	/**
 	 * @brief Actually destroys entities.
 	 * @details Entities are not destroyed immediately, only after the dispose call.
 	 */
-	void disposeEntities() { entities.dispose(); }
-
-	/*******************************************************************************************************************
-	 * @brief Locks manager for synchronous access. (MT-Safe)
-	 * @note Use it if you want to access manager from multiple threads asynchronously.
-	 */
-	void lock() { locker.lock(); }
-	/**
-	 * @brief Tries to locks manager for synchronous access. (MT-Safe)
-	 * @note Use it if you want to access manager from multiple threads asynchronously.
-	 */
-	bool tryLock() noexcept { return locker.try_lock(); }
+	void disposeEntities()
+	{
+		checkWriteAccess();
+		entities.dispose();
+	}
 	/**
-	 * @brief Unlock manager after synchronous access. (MT-Safe)
-	 * @note Always unlock manager after synchronous access!
+	 * @brief Destroys garbage components, entities and system components within the specified budget.
+	 * 
+	 * @details
+	 * Garbage components are disposed first in the removal order, then queued system components, then destroyed
+	 * entities. Entities are disposed only when there are no garbage components and queued systems. Budgeted
+	 * entity dispose destroys entity components but keeps its slot until they are disposed by the systems, so
+	 * entity slot is never reused while its components are still pending. At least one item is processed on each
+	 * call. Not yet disposed components keep their garbage state, and entities stay valid until the next calls.
+	 * 
+	 * @param maxCount maximum processed garbage component, system component and entity count, or 0 if unlimited
+	 * @param maxTime maximum garbage dispose duration in nanoseconds, or 0 if unlimited
+	 * @return True if all garbage is disposed, otherwise false. (See the @ref hasPendingGarbage())
 	 */
-	void unlock() noexcept { locker.unlock(); }
-
+	bool disposeGarbage(uint32_t maxCount = 0, int64_t maxTime = 0);
 	/**
-	 * @brief Sets manager singleton to this instance.
-	 * @details Useful in cases when we need to switch between multiple managers.
+	 * @brief Returns true if there are removed components, destroyed entities or queued systems waiting for the dispose.
 	 */
-	void setSingletonCurrent() noexcept
+	bool hasPendingGarbage() const noexcept
 	{
-		singletonInstance = this;
+		return !garbageComponents.empty() || !garbageSystems.empty() || entities.getCount() != entities.getLiveCount();
 	}
 	/**
-	 * @brief Unsets manager singleton instance.
-	 * @details See the @ref setSingletonCurrent().
+	 * @brief Queues system components dispose on the next @ref disposeSystemComponents() call.
+	 * @details Manager queues system when it destroys system component. Use it for the custom system garbage.
+	 * @param[in] system target system instance
 	 */
-	void unsetSingletonCurrent() noexcept
+	void addGarbageSystem(System* system)
 	{
-		singletonInstance = nullptr;
+		assert(system);
+		if (system->isGarbageQueued)
+			return;
+		system->isGarbageQueued = true;
+		garbageSystems.push_back(system);
 	}
-};
 
-/***********************************************************************************************************************
- * @brief Base system class with components.
- * @details See the @ref System.
- *
- * @tparam T type of the system component
- * @tparam DestroyComponents system should call destroy() function of the components
- */
-template<class T = Component, bool DestroyComponents = true>
-class ComponentSystem : public System
-{
-protected:
 	/**
-	 * @brief System component pool.
+	 * @brief Returns maximum garbage item count processed on each @ref update(), or 0 if unlimited.
 	 */
-	LinearPool<T, DestroyComponents> components;
-
+	uint32_t getDisposeCountBudget() const noexcept { return disposeCountBudget; }
 	/**
-	 * @brief Creates a new component instance for the entity.
-	 * @details You should use @ref Manager to add components to the entity.
+	 * @brief Returns maximum garbage dispose duration of each @ref update() in nanoseconds, or 0 if unlimited.
 	 */
-	ID<Component> createComponent(ID<Entity> entity) override
-	{
-		return ID<Component>(components.create());
-	}
+	int64_t getDisposeTimeBudget() const noexcept { return disposeTimeBudget; }
 	/**
-	 * @brief Destroys component instance.
-	 * @details You should use @ref Manager to remove components from the entity.
+	 * @brief Sets garbage dispose budget of each @ref update().
+	 * 
+	 * @details
+	 * It spreads large component removal and entity destruction over several frames. (See the @ref disposeGarbage())
+	 * Adding removed but not yet disposed component again disposes the pending one immediately.
+	 * 
+	 * @param maxCount maximum processed garbage component, system component and entity count, or 0 if unlimited
+	 * @param maxTime maximum garbage dispose duration in nanoseconds, or 0 if unlimited
 	 */
-	void destroyComponent(ID<Component> instance) override
+	void setDisposeBudget(uint32_t maxCount, int64_t maxTime = 0) noexcept
 	{
-		components.destroy(ID<T>(instance));
+		assert(maxTime >= 0);
+		disposeCountBudget = maxCount;
+		disposeTimeBudget = maxTime;
 	}
+
 	/**
-	 * @brief Copies component data from source to destination.
-	 * @details You should use @ref Manager to copy component data of entities.
+	 * @brief Reserves entity memory for the specified count.
+	 * @details Reserved memory is kept after all entities are destroyed. (See the @ref LinearPool::reserve())
+	 * @warning This function can reallocate entity memory and invalidate all previous views.
+	 * @param count target entity capacity
 	 */
-	void copyComponent(View<Component> source, View<Component> destination) override
+	void reserveEntities(uint32_t count)
 	{
-		const auto sourceView = View<T>(source);
-		auto destinationView = View<T>(destination);
-		if constexpr (DestroyComponents)
-			destinationView->destroy();
-		**destinationView = **sourceView;
+		checkWriteAccess();
+		entities.reserve(count);
 	}
-public:
 	/**
-	 * @brief Returns specific component name of the system.
+	 * @brief Reserves component memory of the system for the specified count.
+	 * @details See the @ref System::reserveComponents().
+	 * 
+	 * @param componentType target component TypeIndex
+	 * @param count target component capacity
+	 * 
+	 * @throw EcsmError if component type is not registered.
 	 */
-	const std::string& getComponentName() const override
-	{
-		static const std::string name = typeToString(typeid(T));
-		return name;
-	}
+	void reserveComponents(TypeIndex componentType, uint32_t count);
 	/**
-	 * @brief Returns specific component typeid() of the system.
-	 * @note Override it to define a custom component of the system.
+	 * @brief Reserves component memory of the system for the specified count.
+	 * @details See the @ref System::reserveComponents().
+	 * 
+	 * @param count target component capacity
+	 * @tparam T target component type
+	 * 
+	 * @throw EcsmError if component type is not registered.
 	 */
-	std::type_index getComponentType() const override
+	template<class T = Component>
+	void reserveComponents(uint32_t count)
 	{
-		return typeid(T);
+		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+		reserveComponents(getTypeIndex<T>(), count);
 	}
 	/**
-	 * @brief Returns specific component @ref View.
+	 * @brief Releases unused entity and component memory.
+	 * @details Call it after the dispose, for example to trim memory after level loading peak.
+	 * @warning This function can reallocate entity and component memory and invalidate all previous views.
 	 */
-	View<Component> getComponent(ID<Component> instance) override
-	{
-		return View<Component>(components.get(ID<T>(instance)));
-	}
+	void shrinkToFit();
+
+	/*******************************************************************************************************************
+	 * @brief Writes all entities and components to the binary snapshot.
+	 *
+	 * @details
+	 * Writes entity pool, entity component tables and each component system pool as contiguous blocks, component
+	 * systems are identified by the @ref System::getComponentName(). Write it after the @ref update(), when there
+	 * are no destroyed entities and removed components waiting for the dispose. (See the @ref hasPendingGarbage())
+	 *
+	 * @param[out] writer target snapshot writer
+	 * @throw EcsmError if there are pending garbage entities or components, or system does not support snapshots.
+	 */
+	void writeSnapshot(SnapshotWriter& writer) const;
 	/**
-	 * @brief Actually destroys system components.
-	 * @details Components are not destroyed immediately, only after the dispose call.
+	 * @brief Replaces all entities and components with the binary snapshot data.
+	 *
+	 * @details
+	 * Snapshot should contain the same set of the component systems, which are already created. Trivially copyable
+	 * components are copied directly from the snapshot memory, which can be a memory mapped file. Current entities
+	 * and components are destructed without the destroy() call, cached queries are rebuilt. Pending garbage
+	 * components, queued system garbage and recorded added/removed components of the replaced world are discarded.
+	 *
+	 * @warning This function invalidates all previous entity and component views and identifiers.
+	 * @warning Entities and components are in the unspecified state if corrupted snapshot entity data is read.
+	 * @param[in] reader source snapshot reader
+	 *
+	 * @throw EcsmError if snapshot is corrupted or has different component systems.
 	 */
-	void disposeComponents() override
-	{
-		components.dispose();
-	}
+	void readSnapshot(SnapshotReader& reader);
 
+	/*******************************************************************************************************************
+	 * @brief Returns current manager frame index.
+	 * @details It is incremented after each @ref update() and used as the component change version.
+	 */
+	uint64_t getFrameIndex() const noexcept { return frameIndex; }
 	/**
-	 * @brief Returns true if entity has specific component.
-	 * @param entity target entity with component
-	 * @note This function is faster than the Manager one.
+	 * @brief Returns true if added and removed components are recorded.
+	 * @details See the @ref setTrackingChanges().
 	 */
-	bool hasComponent(ID<Entity> entity) const
+	bool isTrackingChanges() const noexcept { return trackChanges; }
+	/**
+	 * @brief Enables or disables added and removed component recording.
+	 *
+	 * @details
+	 * Added components are recorded by the add, instantiate and duplicate functions. Removed components are recorded
+	 * when they are disposed, and when their entity is destroyed. Records are kept until the
+	 * @ref clearComponentChanges() call. Component data changes are tracked by the component systems, see the
+	 * @ref ComponentSystem::setTrackingChanges().
+	 *
+	 * @param isTracking record added and removed components
+	 */
+	void setTrackingChanges(bool isTracking)
 	{
-		assert(entity);
-		const auto entityView = Manager::Instance::get()->getEntities().get(entity);
-		const auto& entityComponents = entityView->getComponents();
-		return entityComponents.find(typeid(T)) != entityComponents.end();
+		if (!isTracking)
+			clearComponentChanges();
+		trackChanges = isTracking;
 	}
 	/**
-	 * @brief Returns entity specific component view.
-	 * @param entity target entity with component
-	 * @note This function is faster than the Manager one.
+	 * @brief Returns recorded added components in the addition order.
+	 * @details Entity can be already destroyed. (See the @ref setTrackingChanges())
 	 */
-	View<T> getComponent(ID<Entity> entity) const
+	const ComponentChanges& getAddedComponents() const noexcept { return addedComponents; }
+	/**
+	 * @brief Returns recorded removed components in the removal order.
+	 * @details Entity can be already destroyed. (See the @ref setTrackingChanges())
+	 */
+	const ComponentChanges& getRemovedComponents() const noexcept { return removedComponents; }
+	/**
+	 * @brief Removes all recorded added and removed components.
+	 */
+	void clearComponentChanges() noexcept
 	{
-		assert(entity);
-		const auto entityView = Manager::Instance::get()->getEntities().get(entity);
-		const auto& pair = entityView->getComponents().at(typeid(T));
-		return components.get(ID<T>(pair.second));
+		addedComponents.clear();
+		removedComponents.clear();
 	}
+
 	/**
-	 * @brief Returns entity specific component view if exist.
+	 * @brief Marks entity component as changed in the current frame.
+	 * @details Component system should track changes, otherwise nothing is recorded.
+	 * @note Do not call it inside the concurrent read phase, it changes system state.
+	 *
 	 * @param entity target entity with component
-	 * @note This function is faster than the Manager one.
+	 * @param componentType target component TypeIndex
+	 *
+	 * @throw EcsmError if component is not found.
+	 */
+	void markChanged(ID<Entity> entity, TypeIndex componentType);
+	/**
+	 * @brief Marks entity component as changed in the current frame.
+	 * @details Component system should track changes, otherwise nothing is recorded.
+	 * @note Do not call it inside the concurrent read phase, it changes system state.
+	 *
+	 * @param entity target entity with component
+	 * @tparam T target component type
+	 *
+	 * @throw EcsmError if component is not found.
+	 */
+	template<class T = Component>
+	void markChanged(ID<Entity> entity)
+	{
+		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+		markChanged(entity, getTypeIndex<T>());
+	}
+	/**
+	 * @brief Appends entities with components changed after the specified frame.
+	 * @details Cost depends on the recorded change count, not on the component count.
+	 *
+	 * @param componentType target component TypeIndex
+	 * @param sinceFrame last already processed frame index
+	 * @param[out] entities target entity array
+	 *
+	 * @throw EcsmError if component type is not registered.
+	 */
+	void getChangedEntities(TypeIndex componentType, uint64_t sinceFrame,
+		std::vector<ID<Entity>>& entities) const;
+	/**
+	 * @brief Appends entities with components changed after the specified frame.
+	 * @details Cost depends on the recorded change count, not on the component count.
+	 *
+	 * @param sinceFrame last already processed frame index
+	 * @param[out] entities target entity array
+	 * @tparam T target component type
+	 *
+	 * @throw EcsmError if component type is not registered.
+	 */
+	template<class T = Component>
+	void getChangedEntities(uint64_t sinceFrame, std::vector<ID<Entity>>& entities) const
+	{
+		static_assert(std::is_base_of_v<Component, T>, "Must be derived from the Component struct.");
+		getChangedEntities(getTypeIndex<T>(), sinceFrame, entities);
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Begins concurrent read-only access phase. (MT-Safe)
+	 * 
+	 * @details
+	 * Multiple threads can read entities and components without locking until the matching @ref endRead(), using 
+	 * the const manager and system functions (get, tryGet, has...), component pool iteration, and query each of
+	 * the queries created by @ref prepareQuery() before the read phase. All structural manager changes inside
+	 * the read phase throw @ref EcsmError, record them to the @ref CommandBuffer instead. Nested and overlapping read phases of the multiple threads are allowed.
+	 */
+	void beginRead() noexcept { readerCount.fetch_add(1, std::memory_order_acquire); }
+	/**
+	 * @brief Ends concurrent read-only access phase. (MT-Safe)
+	 * @details See the @ref beginRead().
+	 */
+	void endRead() noexcept
+	{
+		assert(readerCount.load(std::memory_order_relaxed) > 0);
+		readerCount.fetch_sub(1, std::memory_order_release);
+	}
+	/**
+	 * @brief Returns current read-only access phase count. (MT-Safe)
+	 * @details See the @ref beginRead().
+	 */
+	uint32_t getReaderCount() const noexcept { return readerCount.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Returns command buffer of the calling thread. (MT-Safe)
+	 * @details Buffer is created on the first thread call, see the @ref CommandBuffer.
+	 */
+	CommandBuffer& getCommandBuffer();
+	/**
+	 * @brief Executes and clears recorded commands of all thread command buffers.
+	 * 
+	 * @details
+	 * Creates all deferred entities at once, then executes commands in the sort key order. It is called inside the 
+	 * @ref update(), you can also call it at the other sync point. Command buffers are cleared even on error.
+	 * 
+	 * @throw EcsmError if command manager function failed. (See the @ref add(), @ref remove(), @ref copy())
+	 */
+	void executeCommands();
+
+	/*******************************************************************************************************************
+	 * @brief Locks manager for synchronous access. (MT-Safe)
+	 * @note Use it if you want to access manager from multiple threads asynchronously.
+	 * @details Read-only access does not require the lock, see the @ref beginRead().
+	 */
+	void lock() { locker.lock(); }
+	/**
+	 * @brief Tries to locks manager for synchronous access. (MT-Safe)
+	 * @note Use it if you want to access manager from multiple threads asynchronously.
+	 */
+	bool tryLock() noexcept { return locker.try_lock(); }
+	/**
+	 * @brief Unlock manager after synchronous access. (MT-Safe)
+	 * @note Always unlock manager after synchronous access!
+	 */
+	void unlock() noexcept { locker.unlock(); }
+
+	/**
+	 * @brief Sets manager singleton to this instance.
+	 * @details Useful in cases when we need to switch between multiple managers.
+	 */
+	void setSingletonCurrent() noexcept
+	{
+		singletonInstance = this;
+	}
+	/**
+	 * @brief Unsets manager singleton instance.
+	 * @details See the @ref setSingletonCurrent().
+	 */
+	void unsetSingletonCurrent() noexcept
+	{
+		singletonInstance = nullptr;
+	}
+
+	/**
+	 * @brief Returns calling thread current manager instance, or null if it is not set.
+	 * @details See the @ref Manager::Instance. Thread current instance is stored inside the library.
+	 */
+	static Manager* getThreadCurrent() noexcept;
+	/**
+	 * @brief Sets calling thread current manager instance.
+	 * @details Use it to access manager singletons from the threads outside of the manager events.
+	 * @param[in] manager target manager instance or null
+	 */
+	static void setThreadCurrent(Manager* manager) noexcept;
+};
+
+/***********************************************************************************************************************
+ * @brief Base system class with components.
+ * @details See the @ref System.
+ *
+ * @tparam T type of the system component
+ * @tparam DestroyComponents system should call destroy() function of the components
+ * @tparam Pool type of the system component pool (@ref LinearPool or @ref ChunkedPool)
+ */
+template<class T = Component, bool DestroyComponents = true, class Pool = LinearPool<T, DestroyComponents>>
+class ComponentSystem : public System
+{
+	static Pool createPool()
+	{
+		if constexpr (std::is_constructible_v<Pool, std::pmr::memory_resource*>)
+		{
+			auto manager = Manager::Instance::tryGet();
+			return Pool(manager ? manager->getMemoryResource() : std::pmr::get_default_resource());
+		}
+		else
+		{
+			return Pool();
+		}
+	}
+
+	friend class Manager;
+protected:
+	/**
+	 * @brief System component pool.
+	 * @details It uses @ref Manager memory resource if pool supports it.
+	 */
+	Pool components;
+
+	/**
+	 * @brief Creates a new component system instance.
+	 */
+	ComponentSystem() : components(createPool()) { }
+
+	/**
+	 * @brief Creates a new component instance for the entity.
+	 * @details You should use @ref Manager to add components to the entity.
+	 */
+	ID<Component> createComponent(ID<Entity> entity) override
+	{
+		return ID<Component>(components.create());
+	}
+	/**
+	 * @brief Creates a new component instances for the entities.
+	 * @details You should use @ref Manager to add components to the entities.
+	 */
+	void createComponents(const ID<Entity>* entities, uint32_t count, ID<Component>* instances) override
+	{
+		components.createMany(instances, count);
+		for (uint32_t i = 0; i < count; i++)
+			components.get(ID<T>(instances[i]))->entity = entities[i];
+	}
+	/**
+	 * @brief Destroys component instance.
+	 * @details You should use @ref Manager to remove components from the entity.
+	 */
+	void destroyComponent(ID<Component> instance) override
+	{
+		components.destroy(ID<T>(instance));
+	}
+	/**
+	 * @brief Copies component data from source to destination.
+	 * @details You should use @ref Manager to copy component data of entities.
+	 */
+	void copyComponent(View<Component> source, View<Component> destination) override
+	{
+		const auto sourceView = View<T>(source);
+		auto destinationView = View<T>(destination);
+		if constexpr (DestroyComponents)
+			destinationView->destroy();
+		**destinationView = **sourceView;
+	}
+	/**
+	 * @brief Copies component data from source to the just created destination components.
+	 * 
+	 * @details
+	 * Trivially copyable components are copied with memcpy(). Destination component entity is preserved. If system
+	 * overrides @ref copyComponent(), it is called for each destination component instead. (See @ref canBulkCopy())
+	 */
+	void copyComponents(ID<Component> source, const ID<Component>* destinations, uint32_t count) override
+	{
+		if (!canBulkCopy())
+		{
+			System::copyComponents(source, destinations, count);
+			return;
+		}
+
+		const auto sourceView = components.get(ID<T>(source));
+		for (uint32_t i = 0; i < count; i++)
+		{
+			auto destinationView = components.get(ID<T>(destinations[i]));
+			auto entity = destinationView->entity;
+			if constexpr (std::is_trivially_copyable_v<T>)
+				memcpy((void*)*destinationView, (const void*)*sourceView, sizeof(T));
+			else
+				**destinationView = **sourceView;
+			destinationView->entity = entity;
+		}
+	}
+	/**
+	 * @brief Writes all system components to the binary snapshot.
+	 * @details Trivially copyable components are written as a single memory block.
+	 * @warning Override it if component is not trivially copyable.
+	 */
+	void writeComponents(SnapshotWriter& writer) const override
+	{
+		if constexpr (std::is_trivially_copyable_v<T>)
+			components.writeSnapshot(writer);
+		else
+			System::writeComponents(writer);
+	}
+	/**
+	 * @brief Replaces all system components with the binary snapshot data.
+	 * @details Trivially copyable components are copied with a single memcpy().
+	 * @warning Override it if component is not trivially copyable.
+	 */
+	void readComponents(SnapshotReader& reader) override
+	{
+		if constexpr (std::is_trivially_copyable_v<T>)
+			components.readSnapshot(reader);
+		else
+			System::readComponents(reader);
+	}
+public:
+	/**
+	 * @brief Returns specific component name of the system.
+	 */
+	const std::string& getComponentName() const override
+	{
+		static const std::string name = typeToString(getTypeIndex<T>());
+		return name;
+	}
+	/**
+	 * @brief Returns specific component TypeIndex of the system.
+	 * @note Override it to define a custom component of the system.
+	 */
+	TypeIndex getComponentType() const override
+	{
+		return getTypeIndex<T>();
+	}
+	/**
+	 * @brief Returns specific component static type identifier of the system.
+	 * @note Override it to define a custom component of the system.
+	 */
+	uint32_t getComponentStaticTypeID() const override
+	{
+		return getStaticTypeID<T>();
+	}
+	/**
+	 * @brief Returns specific component @ref View.
+	 */
+	View<Component> getComponent(ID<Component> instance) override
+	{
+		return View<Component>(components.get(ID<T>(instance)));
+	}
+	/**
+	 * @brief Returns system component count.
+	 */
+	uint32_t getComponentCount() const override
+	{
+		return components.getLiveCount();
+	}
+	/**
+	 * @brief Appends entities of all system components to the array.
+	 * @param[out] entities target entity array
+	 */
+	void getComponentEntities(std::vector<ID<Entity>>& entities) const override
+	{
+		for (const auto& component : components)
+			entities.push_back(component.getEntity());
+	}
+	/**
+	 * @brief Actually destroys system components.
+	 * @details Components are not destroyed immediately, only after the dispose call.
+	 * @param maxCount maximum processed garbage component count
+	 */
+	uint32_t disposeComponents(uint32_t maxCount) override
+	{
+		auto disposedCount = components.dispose(maxCount);
+		if (components.getCount() != components.getLiveCount())
+			getManager()->addGarbageSystem(this);
+		return disposedCount;
+	}
+	/**
+	 * @brief Reserves component pool memory for the specified count.
+	 * @param count target component capacity
+	 */
+	void reserveComponents(uint32_t count) override
+	{
+		components.reserve(count);
+	}
+	/**
+	 * @brief Releases unused component pool memory.
+	 */
+	void shrinkComponents() override
+	{
+		components.shrinkToFit();
+	}
+	/**
+	 * @brief Returns allocated component pool capacity.
+	 */
+	uint32_t getComponentCapacity() const override
+	{
+		return components.getCapacity();
+	}
+	/**
+	 * @brief Sets current component change version. (Manager frame index)
+	 */
+	void setComponentChangeVersion(uint64_t version) override
+	{
+		components.setChangeVersion(version);
+	}
+	/**
+	 * @brief Marks system component as changed with the current change version.
+	 */
+	void markComponentChanged(ID<Component> instance) override
+	{
+		components.markChanged(ID<T>(instance));
+	}
+	/**
+	 * @brief Appends entities of the system components changed after the specified version.
+	 * @param sinceVersion last already processed change version
+	 * @param[out] entities target entity array
+	 */
+	void getChangedEntities(uint64_t sinceVersion, std::vector<ID<Entity>>& entities) const override
+	{
+		components.eachChanged(sinceVersion, [&entities](ID<T>, const T& component)
+		{
+			entities.push_back(component.getEntity());
+		});
+	}
+
+	/**
+	 * @brief Returns true if component changes are tracked.
+	 */
+	bool isTrackingChanges() const noexcept { return components.isTrackingChanges(); }
+	/**
+	 * @brief Enables or disables component change tracking.
+	 *
+	 * @details
+	 * Tracked components are marked as changed on creation and by the @ref Manager::markChanged() call, with
+	 * the current manager frame index. See the @ref LinearPool::setTrackingChanges().
+	 *
+	 * @param isTracking track component changes
+	 */
+	void setTrackingChanges(bool isTracking) { components.setTrackingChanges(isTracking); }
+	/**
+	 * @brief Releases recorded component changes up to the specified frame. (Inclusive)
+	 * @param untilFrame last processed frame index
+	 */
+	void clearChanges(uint64_t untilFrame) { components.clearChanges(untilFrame); }
+
+	/**
+	 * @brief Returns true if entity has specific component.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	bool hasComponent(ID<Entity> entity) const
+	{
+		assert(entity);
+		const auto entityView = getManager()->getEntities().tryGet(entity);
+		auto component = entityView ? entityView->findComponent(getComponentTypeID()) : nullptr;
+		return component && !component->isGarbage;
+	}
+	/**
+	 * @brief Returns entity specific component view.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	View<T> getComponent(ID<Entity> entity) const
+	{
+		assert(entity);
+		const auto entityView = getManager()->getEntities().tryGet(entity);
+		auto component = entityView ? entityView->findComponent(getComponentTypeID()) : nullptr;
+		if (!component)
+		{
+			throw EcsmError("Component is not added. ("
+				"type: " + typeToString(getTypeIndex<T>()) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		return components.get(ID<T>(component->instance));
+	}
+	/**
+	 * @brief Returns entity specific component view if exist.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
 	 */
 	View<T> tryGetComponent(ID<Entity> entity) const
 	{
 		assert(entity);
-		const auto entityView = Manager::Instance::get()->getEntities().get(entity);
-		const auto& entityComponents = entityView->getComponents();
-		auto result = entityComponents.find(typeid(T));
-		if (result == entityComponents.end())
+		const auto entityView = getManager()->getEntities().tryGet(entity);
+		auto component = entityView ? entityView->findComponent(getComponentTypeID()) : nullptr;
+		if (!component || component->isGarbage)
 			return {};
-		return components.get(ID<T>(result->second.second));
+		return components.get(ID<T>(component->instance));
+	}
+};
+
+/***********************************************************************************************************************
+ * @brief Base system class with components stored in the archetype storage.
+ * 
+ * @details
+ * See the @ref ComponentSystem and @ref ArchetypeStorage. Components of all archetype systems are grouped 
+ * by the entity component set, so systems processing several components of the same entity can iterate 
+ * them together using @ref ArchetypeStorage::each(). Component identifier is the entity identifier.
+ * 
+ * @warning Adding or disposing archetype components moves entity rows and invalidates all previous @ref View.
+ *
+ * @tparam T type of the system component
+ * @tparam DestroyComponents system should call destroy() function of the components
+ */
+template<class T = Component, bool DestroyComponents = true>
+class ArchetypeSystem : public System
+{
+protected:
+	/**
+	 * @brief Archetype component storage.
+	 */
+	ArchetypeStorage* storage = nullptr;
+	/**
+	 * @brief Archetype storage component type.
+	 */
+	uint32_t storageType = 0;
+	/**
+	 * @brief Entities with destroyed components.
+	 */
+	std::vector<ID<Entity>> garbageComponents;
+
+	/**
+	 * @brief Creates a new archetype system instance.
+	 * @param storage target archetype storage or null to use the manager one
+	 */
+	ArchetypeSystem(ArchetypeStorage* storage = nullptr) :
+		storage(storage ? storage : &Manager::Instance::get()->getArchetypes()),
+		storageType(this->storage->template registerType<T>()) { }
+	/**
+	 * @brief Destroys archetype system instance and it components.
+	 */
+	~ArchetypeSystem() override
+	{
+		if constexpr (DestroyComponents)
+			storage->template each<T>([](ID<Entity>, T& component) { component.destroy(); });
+	}
+
+	/**
+	 * @brief Creates a new component instance for the entity.
+	 * @details You should use @ref Manager to add components to the entity.
+	 */
+	ID<Component> createComponent(ID<Entity> entity) override
+	{
+		if (storage->has(entity, storageType))
+			disposeGarbageComponent(entity);
+		storage->add(entity, storageType);
+		return ID<Component>(entity);
+	}
+	/**
+	 * @brief Removes not yet disposed component of the entity, when the component is added again.
+	 * @details Component is destroyed without the delay, even if its destroy() function returns false.
+	 * @param entity target entity instance
+	 */
+	void disposeGarbageComponent(ID<Entity> entity)
+	{
+		auto result = std::find(garbageComponents.begin(), garbageComponents.end(), entity);
+		if (result == garbageComponents.end())
+			return;
+		garbageComponents.erase(result);
+		if constexpr (DestroyComponents)
+			storage->template get<T>(entity, storageType)->destroy();
+		storage->remove(entity, storageType);
+	}
+	/**
+	 * @brief Destroys component instance.
+	 * @details You should use @ref Manager to remove components from the entity.
+	 */
+	void destroyComponent(ID<Component> instance) override
+	{
+		garbageComponents.push_back(ID<Entity>(instance));
+	}
+	/**
+	 * @brief Copies component data from source to destination.
+	 * @details You should use @ref Manager to copy component data of entities.
+	 */
+	void copyComponent(View<Component> source, View<Component> destination) override
+	{
+		const auto sourceView = View<T>(source);
+		auto destinationView = View<T>(destination);
+		if constexpr (DestroyComponents)
+			destinationView->destroy();
+		**destinationView = **sourceView;
+	}
+public:
+	/**
+	 * @brief Returns specific component name of the system.
+	 */
+	const std::string& getComponentName() const override
+	{
+		static const std::string name = typeToString(getTypeIndex<T>());
+		return name;
+	}
+	/**
+	 * @brief Returns specific component TypeIndex of the system.
+	 */
+	TypeIndex getComponentType() const override
+	{
+		return getTypeIndex<T>();
+	}
+	/**
+	 * @brief Returns specific component static type identifier of the system.
+	 * @note Override it to define a custom component of the system.
+	 */
+	uint32_t getComponentStaticTypeID() const override
+	{
+		return getStaticTypeID<T>();
+	}
+	/**
+	 * @brief Returns specific component @ref View.
+	 */
+	View<Component> getComponent(ID<Component> instance) override
+	{
+		return View<Component>(storage->template get<T>(ID<Entity>(instance), storageType));
+	}
+	/**
+	 * @brief Returns system component count.
+	 */
+	uint32_t getComponentCount() const override
+	{
+		uint32_t count = 0;
+		for (const auto& pair : storage->getArchetypes())
+		{
+			if (pair.second->findColumn(storageType) >= 0)
+				count += pair.second->getCount();
+		}
+		return count;
+	}
+	/**
+	 * @brief Appends entities of all system components to the array.
+	 * @param[out] entities target entity array
+	 */
+	void getComponentEntities(std::vector<ID<Entity>>& entities) const override
+	{
+		for (const auto& pair : storage->getArchetypes())
+		{
+			if (pair.second->findColumn(storageType) < 0)
+				continue;
+			const auto& archetypeEntities = pair.second->getEntities();
+			entities.insert(entities.end(), archetypeEntities.begin(), archetypeEntities.end());
+		}
+	}
+	/**
+	 * @brief Actually destroys system components.
+	 * @details Components are not destroyed immediately, only after the dispose call.
+	 * @param maxCount maximum processed garbage component count
+	 */
+	uint32_t disposeComponents(uint32_t maxCount) override
+	{
+		auto processCount = std::min(garbageComponents.size(), (size_t)maxCount);
+		size_t keptCount = 0;
+		uint32_t disposedCount = 0;
+
+		for (size_t i = 0; i < processCount; i++)
+		{
+			auto entity = garbageComponents[i];
+			if constexpr (DestroyComponents)
+			{
+				if (!storage->template get<T>(entity, storageType)->destroy())
+				{
+					garbageComponents[keptCount++] = entity;
+					continue;
+				}
+			}
+			storage->remove(entity, storageType);
+			disposedCount++;
+		}
+
+		// Not yet processed components are moved before the kept ones, so the next call starts from them.
+		auto garbageData = garbageComponents.data();
+		auto restCount = garbageComponents.size() - processCount;
+		std::copy(garbageData + processCount, garbageData + garbageComponents.size(), garbageData + keptCount);
+		std::rotate(garbageData, garbageData + keptCount, garbageData + keptCount + restCount);
+		garbageComponents.resize(keptCount + restCount);
+
+		if (!garbageComponents.empty())
+			getManager()->addGarbageSystem(this);
+		return disposedCount;
+	}
+
+	/**
+	 * @brief Returns archetype storage component type of the system.
+	 */
+	uint32_t getStorageType() const noexcept { return storageType; }
+
+	/**
+	 * @brief Returns true if entity has specific component.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	bool hasComponent(ID<Entity> entity) const noexcept
+	{
+		return storage->has(entity, storageType) && !getManager()->template isGarbage<T>(entity);
+	}
+	/**
+	 * @brief Returns entity specific component view.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	View<T> getComponent(ID<Entity> entity) const
+	{
+		auto component = storage->template get<T>(entity, storageType);
+		if (!component)
+		{
+			throw EcsmError("Component is not added. ("
+				"type: " + typeToString(getTypeIndex<T>()) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		return component;
+	}
+	/**
+	 * @brief Returns entity specific component view if exist.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	View<T> tryGetComponent(ID<Entity> entity) const noexcept
+	{
+		if (getManager()->template isGarbage<T>(entity))
+			return {};
+		return storage->template get<T>(entity, storageType);
+	}
+};
+
+/***********************************************************************************************************************
+ * @brief Base system class with component fields stored in the separate aligned arrays. (SoA)
+ * 
+ * @details
+ * See the @ref ComponentSystem and @ref SoaStorage. Component type is used only for the entity back-reference
+ * and type identity, component data is declared by the field types. Use @ref SoaStorage::each() or 
+ * @ref SoaStorage::eachBatch() to process fields with the SIMD friendly loops. Component identifier is the
+ * entity identifier.
+ * 
+ * @warning Disposing components moves component rows and invalidates all previous @ref View and field pointers.
+ *
+ * @tparam T type of the system component (entity back-reference)
+ * @tparam Fields types of the system component fields
+ */
+template<class T, class... Fields>
+class SoaComponentSystem : public System
+{
+protected:
+	/**
+	 * @brief System component field storage.
+	 */
+	SoaStorage<T, Fields...> components;
+	/**
+	 * @brief Entities with destroyed components.
+	 */
+	std::vector<ID<Entity>> garbageComponents;
+
+	/**
+	 * @brief Creates a new component instance for the entity.
+	 * @details You should use @ref Manager to add components to the entity.
+	 */
+	ID<Component> createComponent(ID<Entity> entity) override
+	{
+		if (components.findRow(entity) != UINT32_MAX)
+			disposeGarbageComponent(entity);
+		components.add(entity);
+		return ID<Component>(entity);
+	}
+	/**
+	 * @brief Removes not yet disposed component of the entity, when the component is added again.
+	 * @param entity target entity instance
+	 */
+	void disposeGarbageComponent(ID<Entity> entity)
+	{
+		auto result = std::find(garbageComponents.begin(), garbageComponents.end(), entity);
+		if (result == garbageComponents.end())
+			return;
+		garbageComponents.erase(result);
+		components.remove(entity);
+	}
+	/**
+	 * @brief Destroys component instance.
+	 * @details You should use @ref Manager to remove components from the entity.
+	 */
+	void destroyComponent(ID<Component> instance) override
+	{
+		garbageComponents.push_back(ID<Entity>(instance));
+	}
+	/**
+	 * @brief Copies component fields from source to destination.
+	 * @details You should use @ref Manager to copy component data of entities.
+	 */
+	void copyComponent(View<Component> source, View<Component> destination) override
+	{
+		components.copy(components.findRow(source->getEntity()), components.findRow(destination->getEntity()));
+	}
+	/**
+	 * @brief Writes all system components to the binary snapshot.
+	 * @details You should use @ref Manager to write world snapshot.
+	 */
+	void writeComponents(SnapshotWriter& writer) const override
+	{
+		components.writeSnapshot(writer);
+	}
+	/**
+	 * @brief Replaces all system components with the binary snapshot data.
+	 * @details You should use @ref Manager to read world snapshot.
+	 */
+	void readComponents(SnapshotReader& reader) override
+	{
+		components.readSnapshot(reader);
+		garbageComponents.clear();
+	}
+public:
+	/**
+	 * @brief Returns specific component name of the system.
+	 */
+	const std::string& getComponentName() const override
+	{
+		static const std::string name = typeToString(getTypeIndex<T>());
+		return name;
+	}
+	/**
+	 * @brief Returns specific component TypeIndex of the system.
+	 */
+	TypeIndex getComponentType() const override
+	{
+		return getTypeIndex<T>();
+	}
+	/**
+	 * @brief Returns specific component static type identifier of the system.
+	 */
+	uint32_t getComponentStaticTypeID() const override
+	{
+		return getStaticTypeID<T>();
+	}
+	/**
+	 * @brief Returns specific component @ref View.
+	 */
+	View<Component> getComponent(ID<Component> instance) override
+	{
+		return View<Component>(components.get(ID<Entity>(instance)));
+	}
+	/**
+	 * @brief Returns system component count.
+	 */
+	uint32_t getComponentCount() const override
+	{
+		return components.getCount();
+	}
+	/**
+	 * @brief Appends entities of all system components to the array.
+	 * @param[out] entities target entity array
+	 */
+	void getComponentEntities(std::vector<ID<Entity>>& entities) const override
+	{
+		auto items = components.getItems();
+		for (uint32_t i = 0; i < components.getCount(); i++)
+			entities.push_back(items[i].getEntity());
+	}
+	/**
+	 * @brief Actually destroys system components.
+	 * @details Components are not destroyed immediately, only after the dispose call.
+	 * @param maxCount maximum processed garbage component count
+	 */
+	uint32_t disposeComponents(uint32_t maxCount) override
+	{
+		auto disposeCount = std::min(garbageComponents.size(), (size_t)maxCount);
+		for (size_t i = 0; i < disposeCount; i++)
+			components.remove(garbageComponents[i]);
+		garbageComponents.erase(garbageComponents.begin(), garbageComponents.begin() + disposeCount);
+
+		if (!garbageComponents.empty())
+			getManager()->addGarbageSystem(this);
+		return (uint32_t)disposeCount;
+	}
+	/**
+	 * @brief Reserves memory for the specified system component count.
+	 * @param count target component count
+	 */
+	void reserveComponents(uint32_t count) override
+	{
+		components.reserve(count);
+	}
+	/**
+	 * @brief Deallocates unused system component memory.
+	 */
+	void shrinkComponents() override
+	{
+		components.shrink();
+	}
+	/**
+	 * @brief Returns allocated system component count.
+	 */
+	uint32_t getComponentCapacity() const override
+	{
+		return components.getCapacity();
+	}
+
+	/**
+	 * @brief Returns system component field storage.
+	 */
+	SoaStorage<T, Fields...>& getComponents() noexcept { return components; }
+	/**
+	 * @brief Returns constant system component field storage.
+	 */
+	const SoaStorage<T, Fields...>& getComponents() const noexcept { return components; }
+
+	/**
+	 * @brief Returns true if entity has specific component.
+	 * @param entity target entity with component
+	 * @note This function is faster than the Manager one.
+	 */
+	bool hasComponent(ID<Entity> entity) const noexcept
+	{
+		return components.has(entity) && !getManager()->template isGarbage<T>(entity);
+	}
+	/**
+	 * @brief Returns entity specific component field.
+	 * @param entity target entity with component
+	 * @tparam I index of the field
+	 * @throw EcsmError if component is not found.
+	 */
+	template<size_t I>
+	auto& getField(ID<Entity> entity)
+	{
+		auto row = components.findRow(entity);
+		if (row == UINT32_MAX)
+		{
+			throw EcsmError("Component is not added. ("
+				"type: " + typeToString(getTypeIndex<T>()) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		return components.template getField<I>(row);
 	}
 };
 
@@ -18,20 +18,66 @@
 
 #pragma once
 #include "ecsm-error.hpp"
+#include "snapshot.hpp"
 
-#include <stack>
+#include <new>
+#include <memory>
 #include <vector>
+#include <memory_resource>
+#include <algorithm>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <cassert>
 #include <cstring>
 #include <iterator>
+#include <thread>
 
 namespace ecsm
 {
 
 template<class T, bool Destroy = true>
 class LinearPool;
+template<class T, bool Destroy = true, uint32_t ChunkSize = 1024>
+class ChunkedPool;
+class ArchetypeStorage;
+template<class T, class... Fields>
+class SoaStorage;
+
+#ifndef NDEBUG
+/***********************************************************************************************************************
+ * @brief Debug change state of the container, which can be checked from the other threads.
+ * @details Stores changing thread, so concurrent reads from the other threads during the change can be detected.
+ */
+class ChangeState final
+{
+	std::atomic<std::thread::id> thread = {};
+public:
+	/**
+	 * @brief Begins or ends container change on the calling thread.
+	 * @param isChanging is container changing
+	 */
+	ChangeState& operator=(bool isChanging) noexcept
+	{
+		thread.store(isChanging ? std::this_thread::get_id() : std::thread::id(), std::memory_order_relaxed);
+		return *this;
+	}
+	/**
+	 * @brief Returns true if container is changing by any thread.
+	 */
+	operator bool() const noexcept { return thread.load(std::memory_order_relaxed) != std::thread::id(); }
+
+	/**
+	 * @brief Returns true if container is changing by the other thread.
+	 * @details Reading container during the other thread change is a data race.
+	 */
+	bool isOtherThread() const noexcept
+	{
+		auto changingThread = thread.load(std::memory_order_relaxed);
+		return changingThread != std::thread::id() && changingThread != std::this_thread::get_id();
+	}
+};
+#endif
 
 /**
  * @brief Item identifier in the @ref LinearPool.
@@ -40,17 +86,23 @@ class LinearPool;
  * @details
  * Identifier or index associated with individual items within the pool. Each item in the pool 
  * can be uniquely identified by its identifier, which helps in managing and referencing items.
+ * 
+ * Identifier also contains item slot generation, which is incremented when the item is disposed. It allows to
+ * detect stale identifiers of the disposed items, even if their slot is reused. (See the isValid() of the pool)
  */
 template<class T>
 struct ID final
 {
 private:
 	uint32_t index = 0;
+	uint32_t generation = 0;
 
-	constexpr ID(uint32_t index) noexcept : index(index) { }
+	constexpr ID(uint32_t index, uint32_t generation) noexcept : index(index), generation(generation) { }
 
 	friend class LinearPool<T, true>;
 	friend class LinearPool<T, false>;
+	template<class U, bool D, uint32_t S>
+	friend class ChunkedPool;
 public:
 	constexpr ID() = default;
 
@@ -62,7 +114,7 @@ public:
 	 * @param id item identifier in the linear pool
 	 */
 	template<class U>
-	constexpr explicit ID(ID<U> id) noexcept : index(*id) { }
+	constexpr explicit ID(ID<U> id) noexcept : index(*id), generation(id.getGeneration()) { }
 
 	/**
 	 * @brief Returns item index + 1 in the linear pool.
@@ -74,22 +126,30 @@ public:
 	 * @note You can use it to set the identifier index value.
 	 */
 	uint32_t& operator*() noexcept { return index; }
+	/**
+	 * @brief Returns item slot generation in the linear pool.
+	 * @details Pool increments slot generation when the item is disposed.
+	 */
+	constexpr uint32_t getGeneration() const noexcept { return generation; }
 
 	/**
 	 * @brief Returns true if this identifier is equal to the v identifier.
 	 * @param v other identifier value
 	 */
-	constexpr bool operator==(ID v) const noexcept { return index == v.index; }
+	constexpr bool operator==(ID v) const noexcept { return index == v.index && generation == v.generation; }
 	/**
 	 * @brief Returns true if this identifier is not equal to the v identifier.
 	 * @param v other identifier value
 	 */
-	constexpr bool operator!=(ID v) const noexcept { return index != v.index; }
+	constexpr bool operator!=(ID v) const noexcept { return index != v.index || generation != v.generation; }
 	/**
 	 * @brief Returns true if this identifier is less than the v identifier.
 	 * @param v other identifier value
 	 */
-	constexpr bool operator<(ID v) const noexcept { return index < v.index; }
+	constexpr bool operator<(ID v) const noexcept
+	{
+		return index < v.index || (index == v.index && generation < v.generation);
+	}
 
 	/**
 	 * @brief Returns true if item is not null.
@@ -107,7 +167,7 @@ struct IdHash
 	/**
 	 * @brief Returns item identifier hash value. 
 	 */
-	size_t operator()(ID<T> id) const noexcept { return (size_t)*id; }
+	size_t operator()(ID<T> id) const noexcept { return (size_t)*id ^ ((size_t)id.getGeneration() << 24); }
 };
 
 /***********************************************************************************************************************
@@ -139,6 +199,11 @@ private:
 	
 	friend class LinearPool<T, true>;
 	friend class LinearPool<T, false>;
+	template<class U, bool D, uint32_t S>
+	friend class ChunkedPool;
+	friend class ArchetypeStorage;
+	template<class U, class... F>
+	friend class SoaStorage;
 public:
 	/**
 	 * @brief Creates a new null item view.
@@ -395,6 +460,250 @@ static constexpr bool operator<(const Ref<T>& r, ID<T> i) noexcept { return ID<T
 template<typename T>
 static constexpr bool operator<(ID<T> i, const Ref<T>& r) noexcept { return i < ID<T>(r); }
 
+/***********************************************************************************************************************
+ * @brief Item reference counters of the pool.
+ *
+ * @details
+ * Counters are indexed by the item identifier and stored in the fixed size chunks, so reference counting does not
+ * allocate memory per item and counter memory is never relocated. Chunks are allocated on the first item reference.
+ * Atomic and non-atomic @ref PoolRef share the same counters, non-atomic ones use relaxed load and store.
+ */
+class RefCounters final
+{
+public:
+	/**
+	 * @brief Item reference counter type.
+	 */
+	using Counter = std::atomic<int64_t>;
+private:
+	static constexpr uint32_t chunkSize = 1024;
+	std::pmr::vector<Counter*> chunks;
+public:
+	/**
+	 * @brief Creates a new empty reference counter array.
+	 * @param[in] memoryResource counter chunks memory resource
+	 */
+	explicit RefCounters(std::pmr::memory_resource* memoryResource) : chunks(memoryResource) { }
+	/**
+	 * @brief Destroys reference counter array.
+	 * @warning All counter references should be destroyed before this call.
+	 */
+	~RefCounters()
+	{
+		auto memoryResource = chunks.get_allocator().resource();
+		for (auto chunk : chunks)
+		{
+			std::destroy(chunk, chunk + chunkSize);
+			memoryResource->deallocate(chunk, chunkSize * sizeof(Counter), alignof(Counter));
+		}
+	}
+
+	RefCounters(const RefCounters&) = delete;
+	RefCounters& operator=(const RefCounters&) = delete;
+
+	/**
+	 * @brief Returns item index reference counter, allocates counter chunk if required.
+	 * @warning It is not thread safe, chunk array can be reallocated.
+	 * @param index target item index in the pool
+	 */
+	Counter& get(uint32_t index)
+	{
+		auto chunkIndex = index / chunkSize;
+		while (chunkIndex >= chunks.size())
+		{
+			auto memoryResource = chunks.get_allocator().resource();
+			auto chunk = (Counter*)memoryResource->allocate(chunkSize * sizeof(Counter), alignof(Counter));
+			for (uint32_t i = 0; i < chunkSize; i++)
+				new (chunk + i) Counter(0);
+			chunks.push_back(chunk);
+		}
+		return chunks[chunkIndex][index % chunkSize];
+	}
+	/**
+	 * @brief Returns current item index reference count.
+	 * @param index target item index in the pool
+	 */
+	int64_t getCount(uint32_t index) const noexcept
+	{
+		auto chunkIndex = index / chunkSize;
+		if (chunkIndex >= chunks.size())
+			return 0;
+		return chunks[chunkIndex][index % chunkSize].load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Resets item index reference counter when the item is disposed.
+	 * @details Disposed item slot can be reused, so the new item starts with zero references.
+	 * @param index target item index in the pool
+	 */
+	void reset(uint32_t index) noexcept
+	{
+		assert(getCount(index) == 0); // Item reference outlives disposed item.
+		auto chunkIndex = index / chunkSize;
+		if (chunkIndex >= chunks.size())
+			return;
+		chunks[chunkIndex][index % chunkSize].store(0, std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Resets all reference counters when the pool items are replaced.
+	 * @details Counter memory is kept, so it can be reused by the new items.
+	 */
+	void clear() noexcept
+	{
+		for (auto chunk : chunks)
+		{
+			for (uint32_t i = 0; i < chunkSize; i++)
+			{
+				assert(chunk[i].load(std::memory_order_relaxed) == 0); // Item reference outlives replaced item.
+				chunk[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+/***********************************************************************************************************************
+ * @brief Item identifier in the pool with pool-backed usage counter.
+ * @tparam T type of the item in the pool
+ * @tparam Atomic use atomic counter, which can be shared between threads
+ *
+ * @details
+ * Alternative to the @ref Ref, which does not allocate counter on the heap. Counter is stored in the pool counter
+ * array next to the other item counters. Use non-atomic counter if references are used only by one thread.
+ * You can get reference using getRef() function of the @ref LinearPool or @ref ChunkedPool.
+ *
+ * @warning Pool should outlive all of its item references.
+ */
+template<typename T, bool Atomic = true>
+struct PoolRef final
+{
+	/**
+	 * @brief Item reference counter type.
+	 */
+	using Counter = RefCounters::Counter;
+private:
+	Counter* counter = nullptr;
+	ID<T> item = {};
+
+	static void increment(Counter* counter) noexcept
+	{
+		if constexpr (Atomic)
+			counter->fetch_add(1, std::memory_order_relaxed);
+		else
+			counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	static void decrement(Counter* counter) noexcept
+	{
+		if constexpr (Atomic)
+		{
+			if (counter->fetch_sub(1, std::memory_order_release) == 1)
+				std::atomic_thread_fence(std::memory_order_acquire);
+		}
+		else
+		{
+			counter->store(counter->load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+		}
+	}
+
+	PoolRef(Counter& counter, ID<T> item) noexcept : counter(&counter), item(item) { increment(this->counter); }
+
+	template<class U, bool D>
+	friend class LinearPool;
+	template<class U, bool D, uint32_t S>
+	friend class ChunkedPool;
+public:
+	constexpr PoolRef() = default;
+
+	/**
+	 * @brief Destroys item reference. (Decrements counter)
+	 */
+	~PoolRef()
+	{
+		if (item)
+			decrement(counter);
+	}
+
+	PoolRef(const PoolRef& ref) noexcept : counter(ref.counter), item(ref.item)
+	{
+		if (item)
+			increment(counter);
+	}
+	PoolRef(PoolRef&& ref) noexcept : counter(ref.counter), item(ref.item)
+	{
+		ref.counter = nullptr;
+		ref.item = ID<T>();
+	}
+
+	PoolRef& operator=(const PoolRef& ref) noexcept
+	{
+		if (this != &ref)
+		{
+			if (ref.item)
+				increment(ref.counter);
+			if (item)
+				decrement(counter);
+			counter = ref.counter;
+			item = ref.item;
+		}
+		return *this;
+	}
+	PoolRef& operator=(PoolRef&& ref) noexcept
+	{
+		if (this != &ref)
+		{
+			if (item)
+				decrement(counter);
+			counter = ref.counter;
+			item = ref.item;
+			ref.counter = nullptr;
+			ref.item = ID<T>();
+		}
+		return *this;
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns current item reference count.
+	 */
+	int64_t getRefCount() const noexcept
+	{
+		if (!item)
+			return 0;
+		return counter->load(std::memory_order_relaxed);
+	}
+	/**
+	 * @brief Returns true if this is last item reference.
+	 */
+	bool isLastRef() const noexcept { return getRefCount() == 1; }
+
+	/**
+	 * @brief Returns true if this reference item is equal to the v reference item.
+	 * @param v other reference value
+	 */
+	constexpr bool operator==(const PoolRef& v) const noexcept { return item == v.item; }
+	/**
+	 * @brief Returns true if this reference item is not equal to the v reference item.
+	 * @param v other reference value
+	 */
+	constexpr bool operator!=(const PoolRef& v) const noexcept { return item != v.item; }
+	/**
+	 * @brief Returns true if this reference item is less than the v reference item.
+	 * @param v other reference value
+	 */
+	constexpr bool operator<(const PoolRef& v) const noexcept { return item < v.item; }
+
+	/**
+	 * @brief Returns reference item @ref ID.
+	 * @tparam T type of the item in the pool
+	 */
+	constexpr explicit operator ID<T>() const noexcept { return item; }
+	/**
+	 * @brief Returns true if reference item is not null.
+	 */
+	constexpr explicit operator bool() const noexcept { return (bool)item; }
+	/**
+	 * @brief Returns reference item index + 1 in the pool.
+	 */
+	uint32_t operator*() const noexcept { return *item; }
+};
+
 /***********************************************************************************************************************
  * @brief Item array with linear memory block.
  * 
@@ -410,21 +719,173 @@ static constexpr bool operator<(ID<T> i, const Ref<T>& r) noexcept { return i <
 template<class T, bool DestroyItems /* = true */>
 class LinearPool final
 {
+public:
+	/**
+	 * @brief Linear pool growth policy function. (capacity, requiredCapacity)
+	 * @details Returns a new items capacity, it should be not less than the required capacity.
+	 */
+	using GrowthPolicy = uint32_t(*)(uint32_t, uint32_t);
+private:
 	T* items = nullptr;
-	uint32_t occupancy = 0, capacity = 1;
-	std::stack<ID<T>> freeItems;
-	std::vector<ID<T>> garbageItems;
+	uint32_t occupancy = 0, capacity = 1, reservedCapacity = 1;
+	GrowthPolicy growthPolicy = doubleCapacity;
+	std::pmr::memory_resource* memoryResource = nullptr;
+	std::pmr::vector<ID<T>> freeItems;
+	std::pmr::vector<ID<T>> garbageItems;
+	std::pmr::vector<uint32_t> liveItems;
+	std::pmr::vector<uint32_t> livePositions;
+	std::pmr::vector<uint8_t> garbageFlags;
+	std::pmr::vector<uint32_t> generations;
+	std::pmr::vector<uint64_t> changeVersions;
+	std::pmr::vector<std::pair<uint64_t, uint32_t>> changedItems;
+	RefCounters refCounters;
 
 	#ifndef NDEBUG
 	uint64_t version = 0;
-	bool isChanging = false;
+	ChangeState isChanging;
 	#endif
+	uint64_t changeVersion = 1;
+	bool lowestFreeFirst = false;
+	bool trackChanges = false;
+
+	static bool isHigherItem(ID<T> a, ID<T> b) noexcept { return b < a; }
+	static uint32_t doubleCapacity(uint32_t capacity, uint32_t requiredCapacity) noexcept
+	{
+		while (capacity < requiredCapacity)
+			capacity *= 2;
+		return capacity;
+	}
+
+	// Items memory is not initialized, only live and garbage item slots contain constructed items.
+	T* allocateItems(uint32_t count)
+	{
+		return (T*)memoryResource->allocate(count * sizeof(T), alignof(T));
+	}
+	void deallocateItems(T* items, uint32_t count) noexcept
+	{
+		memoryResource->deallocate(items, count * sizeof(T), alignof(T));
+	}
+	void destructItems() noexcept
+	{
+		if constexpr (!std::is_trivially_destructible_v<T>)
+		{
+			for (auto index : liveItems)
+				items[index].~T();
+		}
+	}
+
+	void reallocate(uint32_t newCapacity)
+	{
+		assert(newCapacity >= occupancy && newCapacity > 0);
+		T* newItems = allocateItems(newCapacity);
+
+		if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			if (occupancy > 0)
+				memcpy((void*)newItems, (const void*)items, occupancy * sizeof(T));
+		}
+		else if (freeItems.empty())
+		{
+			std::uninitialized_move(items, items + occupancy, newItems);
+			std::destroy(items, items + occupancy);
+		}
+		else
+		{
+			auto relocateItem = [this, newItems](uint32_t index)
+			{
+				new (newItems + index) T(std::move(items[index]));
+				items[index].~T();
+			};
+			for (auto index : liveItems)
+				relocateItem(index);
+		}
+
+		deallocateItems(items, capacity);
+		items = newItems;
+		capacity = newCapacity;
+
+		#ifndef NDEBUG
+		version++;
+		#endif
+	}
+	void grow(uint32_t requiredCapacity)
+	{
+		auto newCapacity = growthPolicy(capacity, requiredCapacity);
+		assert(newCapacity >= requiredCapacity);
+		reallocate(newCapacity);
+	}
+
+	void pushFreeItem(ID<T> item)
+	{
+		freeItems.push_back(item);
+		if (lowestFreeFirst)
+			std::push_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+	}
+	ID<T> popFreeItem() noexcept
+	{
+		if (lowestFreeFirst)
+			std::pop_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+		auto freeItem = freeItems.back();
+		freeItems.pop_back();
+		return freeItem;
+	}
+
+	ID<T> getSlotID(uint32_t index) const noexcept { return ID<T>(index + 1, generations[index]); }
+	void freeSlot(ID<T> item)
+	{
+		// Generation increment makes all previous identifiers of the slot stale.
+		pushFreeItem(ID<T>(*item, ++generations[*item - 1]));
+		refCounters.reset(*item - 1);
+	}
+
+	void addLiveItem(uint32_t index)
+	{
+		livePositions[index] = (uint32_t)liveItems.size();
+		liveItems.push_back(index);
+		if (trackChanges)
+			markSlotChanged(index);
+	}
+	void markSlotChanged(uint32_t index)
+	{
+		if (index >= (uint32_t)changeVersions.size())
+			changeVersions.resize(index + 1, 0);
+		if (changeVersions[index] == changeVersion) // Item is already in the changed item list.
+			return;
+		changeVersions[index] = changeVersion;
+		changedItems.emplace_back(changeVersion, index);
+	}
+	// Called only on dispose, so destroying items during the iteration does not reorder the live item array.
+	void removeLiveItem(uint32_t index) noexcept
+	{
+		auto position = livePositions[index];
+		auto lastItem = liveItems.back();
+		liveItems[position] = lastItem;
+		livePositions[lastItem] = position;
+		livePositions[index] = UINT32_MAX;
+		garbageFlags[index] = false;
+		liveItems.pop_back();
+	}
 public:
 	/**
 	 * @brief Creates a new empty linear pool.
 	 * @details It pre-allocates items array.
+	 * @param[in] memoryResource items and internal arrays memory resource
+	 */
+	explicit LinearPool(std::pmr::memory_resource* memoryResource) : memoryResource(memoryResource),
+		freeItems(memoryResource), garbageItems(memoryResource), liveItems(memoryResource), 
+		livePositions(memoryResource), garbageFlags(memoryResource), generations(memoryResource),
+		changeVersions(memoryResource), changedItems(memoryResource), refCounters(memoryResource)
+	{
+		assert(memoryResource);
+		items = allocateItems(1);
+	}
+	/**
+	 * @brief Creates a new empty linear pool using default memory resource.
+	 * @details It pre-allocates items array.
 	 */
-	LinearPool() { items = new T[1]; }
+	LinearPool() : LinearPool(std::pmr::get_default_resource()) { }
+	LinearPool(const LinearPool&) = delete;
+	LinearPool& operator=(const LinearPool&) = delete;
 
 	/**
 	 * @brief Destroys linear pool.
@@ -440,14 +901,12 @@ public:
 		
 		if constexpr (DestroyItems)
 		{
-			if (occupancy - (uint32_t)freeItems.size() != 0)
-			{
-				for (uint32_t i = 0; i < occupancy; i++)
-					items[i].destroy();
-			}
+			for (auto index : liveItems)
+				items[index].destroy();
 		}
 		
-		delete[] items;
+		destructItems();
+		deallocateItems(items, capacity);
 
 		#ifndef NDEBUG
 		isChanging = false;
@@ -473,10 +932,9 @@ public:
 
 		if (!freeItems.empty())
 		{
-			auto freeItem = freeItems.top();
-			freeItems.pop();
-			auto& item = items[*freeItem - 1];
-			item = T(std::forward<Args>(args)...);
+			auto freeItem = popFreeItem();
+			new (items + (*freeItem - 1)) T(std::forward<Args>(args)...);
+			addLiveItem(*freeItem - 1);
 
 			#ifndef NDEBUG
 			isChanging = false;
@@ -486,28 +944,80 @@ public:
 		}
 		
 		if (occupancy == capacity)
+			grow(occupancy + 1);
+
+		new (items + occupancy) T(std::forward<Args>(args)...);
+		livePositions.push_back(UINT32_MAX);
+		garbageFlags.push_back(false);
+		addLiveItem(occupancy);
+		if (occupancy == (uint32_t)generations.size())
+			generations.push_back(0);
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+
+		return getSlotID(occupancy++);
+	}
+
+	/**
+	 * @brief Creates a new default constructed items in the pool.
+	 * @details Reuses free item slots first, then reallocates linear memory block only once for the remaining items.
+	 * @warning This function can reallocate items memory and invalidate all previous @ref View.
+	 * 
+	 * @param[out] instances created item identifier array (count size)
+	 * @param count item count to create
+	 * @tparam U type of the identifier item (see the ID cast)
+	 */
+	template<class U = T>
+	void createMany(ID<U>* instances, uint32_t count)
+	{
+		assert(instances || count == 0);
+
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Creation of the item inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		auto instance = instances, end = instances + count;
+		while (instance != end && !freeItems.empty())
 		{
-			capacity *= 2;
-			T* newItems = new T[capacity];
-			for (uint32_t i = 0; i < occupancy; i++)
-				newItems[i] = std::move(items[i]);
-			delete[] items;
-			items = newItems;
+			auto freeItem = popFreeItem();
+			new (items + (*freeItem - 1)) T();
+			addLiveItem(*freeItem - 1);
+			*instance++ = ID<U>(freeItem);
 		}
 
-		items[occupancy] = T(std::forward<Args>(args)...);
+		auto newOccupancy = occupancy + (uint32_t)(end - instance);
+		if (newOccupancy > capacity)
+			grow(newOccupancy);
+
+		livePositions.resize(newOccupancy, UINT32_MAX);
+		garbageFlags.resize(newOccupancy, false);
+		liveItems.reserve(liveItems.size() + (newOccupancy - occupancy));
+		if (newOccupancy > (uint32_t)generations.size())
+			generations.resize(newOccupancy, 0);
+		
+		for (; occupancy < newOccupancy; occupancy++)
+		{
+			new (items + occupancy) T();
+			addLiveItem(occupancy);
+			*instance++ = ID<U>(getSlotID(occupancy));
+		}
 
 		#ifndef NDEBUG
 		isChanging = false;
-		version++;
 		#endif
-
-		return ID<T>(++occupancy);
 	}
 
 	/**
 	 * @brief Destroys linear pool item.
-	 * @details It puts items to the garbage array, and destroys them after @ref dispose() call.
+	 * 
+	 * @details
+	 * It puts items to the garbage array, and destroys them after @ref dispose() call. Destroyed item is excluded
+	 * from the iteration, repeated destruction or destruction using stale identifier is ignored. Items can be
+	 * destroyed during the pool iteration, live item array is compacted only by the @ref dispose().
 	 * 
 	 * @param instance item identifier in the pool or null
 	 * @tparam T type of the item in the linear pool
@@ -517,11 +1027,12 @@ public:
 		if (!instance)
 			return;
 
-		#ifndef NDEBUG
 		assert(*instance - 1 < occupancy);
-		version++; // Protects from the use after free.
-		#endif
+		auto index = *instance - 1;
+		if (livePositions[index] == UINT32_MAX || garbageFlags[index] || generations[index] != instance.getGeneration())
+			return;
 
+		garbageFlags[index] = true;
 		garbageItems.push_back(instance);
 	}
 
@@ -536,6 +1047,12 @@ public:
 	{
 		assert(instance);
 		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
 		#ifndef NDEBUG
 		return View(&items[*instance - 1], version);
 		#else
@@ -553,6 +1070,37 @@ public:
 	{
 		assert(instance);
 		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
+		#ifndef NDEBUG
+		return View(&items[*instance - 1], version);
+		#else
+		return View(&items[*instance - 1]);
+		#endif
+	}
+	/**
+	 * @brief Returns @ref View of the item in the linear pool.
+	 * @warning Do not store views, use them only in place. Because item memory can be reallocated later.
+	 *
+	 * @param instance item identifier in the pool
+	 * @tparam T type of the item in the linear pool
+	 * @tparam Atomic is reference counter atomic
+	 */
+	template<bool Atomic>
+	View<T> get(const PoolRef<T, Atomic>& instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == ID<T>(instance).getGeneration()); // Stale disposed item identifier.
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != ID<T>(instance).getGeneration())
+			return {}; // Stale disposed item identifier.
+		#endif
 		#ifndef NDEBUG
 		return View(&items[*instance - 1], version);
 		#else
@@ -560,6 +1108,42 @@ public:
 		#endif
 	}
 
+	/**
+	 * @brief Returns a new item reference with pool-backed usage counter. (Increments counter)
+	 * @details Counters are stored in the pool array indexed by the item identifier, see the @ref PoolRef.
+	 * @warning It can allocate counter memory, call it only outside the concurrent read phase, not from several
+	 *          threads at once. Reference copies and destruction are thread safe for atomic references.
+	 *
+	 * @param instance target item identifier in the pool
+	 * @tparam Atomic use atomic counter, which can be shared between threads
+	 * @return Item reference, or null reference if identifier is stale and ECSM_CHECK_GENERATIONS is defined.
+	 */
+	template<bool Atomic = true>
+	PoolRef<T, Atomic> getRef(ID<T> instance)
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		assert(generations[*instance - 1] == instance.getGeneration()); // Stale disposed item identifier.
+		#ifdef ECSM_CHECK_GENERATIONS
+		if (generations[*instance - 1] != instance.getGeneration())
+			return {}; // Stale identifier should not share the reused slot counter.
+		#endif
+		return PoolRef<T, Atomic>(refCounters.get(*instance - 1), instance);
+	}
+	/**
+	 * @brief Returns current pool-backed item reference count. (Atomic and non-atomic references)
+	 * @details Returns 0 if item identifier is stale, reused slot counter belongs to the new item.
+	 * @param instance target item identifier in the pool
+	 */
+	int64_t getRefCount(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		if (generations[*instance - 1] != instance.getGeneration())
+			return 0;
+		return refCounters.getCount(*instance - 1);
+	}
+
 	/**
 	 * @brief Returns @ref ID of the item pointer.
 	 * @warning Use with extreme caution!
@@ -571,36 +1155,335 @@ public:
 	{
 		assert(instance >= items);
 		assert(instance < items + capacity);
-		return ID<T>((uint32_t)(instance - items) + 1);
+		return getSlotID((uint32_t)(instance - items));
 	}
 
 	/**
 	 * @brief Returns linear pool item memory block.
-	 * @warning It contains destroyed items too. Use custom code to detect freed items.
+	 * @warning It contains destroyed and not constructed free item slots too. Use @ref isLive() or pool iterator.
 	 * @tparam T type of the item in the linear pool
 	 */
 	T* getData() noexcept { return items; }
 	/**
 	 * @brief Returns linear pool constant item memory block.
-	 * @warning It contains destroyed items too. Use custom code to detect freed items.
+	 * @warning It contains destroyed and not constructed free item slots too. Use @ref isLive() or pool iterator.
 	 * @tparam T type of the item in the linear pool
 	 */
 	const T* getData() const noexcept { return items; }
 	
+	/**
+	 * @brief Returns true if item is created and not destroyed.
+	 * @param instance item identifier in the pool
+	 */
+	bool isLive(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		assert(*instance - 1 < occupancy);
+		auto index = *instance - 1;
+		return livePositions[index] != UINT32_MAX && !garbageFlags[index] && 
+			generations[index] == instance.getGeneration();
+	}
+	/**
+	 * @brief Returns true if item identifier is not null and not stale. (Item is not disposed)
+	 * @details Checks item slot generation, destroyed but not yet disposed items are still valid.
+	 * @param instance item identifier in the pool or null
+	 */
+	bool isValid(ID<T> instance) const noexcept
+	{
+		return instance && *instance - 1 < occupancy && generations[*instance - 1] == instance.getGeneration();
+	}
+	/**
+	 * @brief Returns @ref View of the item in the linear pool, or null view if identifier is not valid.
+	 * @details See the @ref isValid().
+	 * @warning Do not store views, use them only in place. Because item memory can be reallocated later.
+	 * 
+	 * @param instance item identifier in the pool or null
+	 * @tparam T type of the item in the linear pool
+	 */
+	View<T> tryGet(ID<T> instance) const noexcept
+	{
+		assert(!isChanging.isOtherThread()); // Concurrent read during the other thread change.
+		if (!isValid(instance))
+			return {};
+		#ifndef NDEBUG
+		return View(&items[*instance - 1], version);
+		#else
+		return View(&items[*instance - 1]);
+		#endif
+	}
+
 	/**
 	 * @brief Returns current created item count.
 	 * @note This is not an allocated item count.
 	 */
 	uint32_t getCount() const noexcept { return occupancy - (uint32_t)freeItems.size(); }
+	/**
+	 * @brief Returns current live item count. (Created and not destroyed)
+	 * @details This is a number of the items visited by the pool iterator.
+	 */
+	uint32_t getLiveCount() const noexcept { return (uint32_t)(liveItems.size() - garbageItems.size()); }
+	/**
+	 * @brief Returns live item array size, including destroyed and not yet disposed items.
+	 * @details Used to split the pool iteration into ranges, see the @ref eachInRange().
+	 */
+	uint32_t getLiveRangeSize() const noexcept { return (uint32_t)liveItems.size(); }
+	/**
+	 * @brief Calls function for each live item in the live item array range, skipping destroyed items.
+	 * @details Non-overlapping ranges can be processed concurrently. (See the @ref getLiveRangeSize())
+	 *
+	 * @param begin live item array range begin
+	 * @param end live item array range end (exclusive)
+	 * @param function target function (T& item)
+	 */
+	template<class Function>
+	void eachInRange(uint32_t begin, uint32_t end, Function&& function)
+	{
+		assert(begin <= end && end <= (uint32_t)liveItems.size());
+		for (uint32_t i = begin; i < end; i++)
+		{
+			auto index = liveItems[i];
+			if (!garbageFlags[index])
+				function(items[index]);
+		}
+	}
 	/**
 	 * @brief Returns linear memory used item slots count.
 	 * @warning This number also contains destroyed items.
 	 */
 	uint32_t getOccupancy() const noexcept { return occupancy; }
 
+	/**
+	 * @brief Returns true if free item slots with the lowest index are reused first.
+	 * @details See the @ref setLowestFreeFirst().
+	 */
+	bool isLowestFreeFirst() const noexcept { return lowestFreeFirst; }
+	/**
+	 * @brief Sets free item slot reuse policy.
+	 * 
+	 * @details
+	 * By default the last freed item slot is reused first (LIFO). Reusing the lowest index slot 
+	 * instead keeps live items packed near the front of the items memory, at the small cost of 
+	 * the free item heap maintenance on each item creation and disposal.
+	 * 
+	 * @param lowestFirst reuse free item slots with the lowest index first
+	 */
+	void setLowestFreeFirst(bool lowestFirst)
+	{
+		if (lowestFirst && !lowestFreeFirst)
+			std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+		lowestFreeFirst = lowestFirst;
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns true if item change versions are tracked.
+	 * @details See the @ref setTrackingChanges().
+	 */
+	bool isTrackingChanges() const noexcept { return trackChanges; }
+	/**
+	 * @brief Enables or disables item change tracking.
+	 *
+	 * @details
+	 * Tracked pool stores the last change version of each item slot and the changed item list ordered by the version,
+	 * so changed items can be visited without iterating the whole pool. Items are marked as changed on creation and
+	 * by the @ref markChanged() call. Disabling tracking releases all recorded changes.
+	 *
+	 * @param isTracking track item change versions
+	 */
+	void setTrackingChanges(bool isTracking)
+	{
+		if (!isTracking)
+		{
+			changeVersions = {};
+			changedItems = {};
+		}
+		trackChanges = isTracking;
+	}
+	/**
+	 * @brief Returns current item change version.
+	 * @details This version is stored for the changed items. (For example manager frame index)
+	 */
+	uint64_t getChangeVersion() const noexcept { return changeVersion; }
+	/**
+	 * @brief Sets current item change version.
+	 * @param version target change version (should not decrease)
+	 */
+	void setChangeVersion(uint64_t version) noexcept
+	{
+		assert(version >= changeVersion);
+		changeVersion = version;
+	}
+	/**
+	 * @brief Returns last item change version, or 0 if it is not tracked.
+	 * @param instance item identifier in the pool
+	 */
+	uint64_t getChangeVersion(ID<T> instance) const noexcept
+	{
+		assert(instance);
+		auto index = *instance - 1;
+		return index < (uint32_t)changeVersions.size() ? changeVersions[index] : 0;
+	}
+	/**
+	 * @brief Marks item as changed with the current change version.
+	 * @details Nothing is recorded if tracking is disabled. Destroyed or stale items are ignored.
+	 * @warning Do not call it inside the concurrent read phase, it changes pool state.
+	 * @param instance item identifier in the pool or null
+	 */
+	void markChanged(ID<T> instance)
+	{
+		if (!trackChanges || !instance)
+			return;
+
+		assert(*instance - 1 < occupancy);
+		auto index = *instance - 1;
+		if (livePositions[index] == UINT32_MAX || garbageFlags[index] || generations[index] != instance.getGeneration())
+			return;
+		markSlotChanged(index);
+	}
+	/**
+	 * @brief Calls function for each live item changed after the specified version.
+	 * @details Each changed item is visited once, cost depends only on the recorded change count.
+	 *
+	 * @param sinceVersion last already processed change version
+	 * @param function target function (ID<T> instance, T& item)
+	 */
+	template<class Function>
+	void eachChanged(uint64_t sinceVersion, Function&& function) const
+	{
+		auto begin = std::upper_bound(changedItems.begin(), changedItems.end(), sinceVersion,
+			[](uint64_t version, const std::pair<uint64_t, uint32_t>& item) { return version < item.first; });
+		for (auto i = begin; i != changedItems.end(); i++)
+		{
+			auto index = i->second;
+			if (index >= occupancy || changeVersions[index] != i->first || 
+				livePositions[index] == UINT32_MAX || garbageFlags[index])
+				continue; // Item is changed again later, or destroyed.
+			function(getSlotID(index), items[index]);
+		}
+	}
+	/**
+	 * @brief Returns recorded item change count, including repeated changes of the same item.
+	 */
+	size_t getChangeCount() const noexcept { return changedItems.size(); }
+	/**
+	 * @brief Releases recorded changes with version less or equal to the specified one.
+	 * @details Call it when all change consumers processed this version.
+	 * @warning Version should be less than the current change version, otherwise new changes can be lost.
+	 * @param untilVersion last processed change version
+	 */
+	void clearChanges(uint64_t untilVersion)
+	{
+		auto end = std::upper_bound(changedItems.begin(), changedItems.end(), untilVersion,
+			[](uint64_t version, const std::pair<uint64_t, uint32_t>& item) { return version < item.first; });
+		changedItems.erase(changedItems.begin(), end);
+	}
+
+	/**
+	 * @brief Returns items and internal arrays memory resource.
+	 */
+	std::pmr::memory_resource* getMemoryResource() const noexcept { return memoryResource; }
+	/**
+	 * @brief Returns linear memory block item capacity.
+	 */
+	uint32_t getCapacity() const noexcept { return capacity; }
+	/**
+	 * @brief Returns item capacity kept by the @ref clear().
+	 * @details See the @ref reserve().
+	 */
+	uint32_t getReservedCapacity() const noexcept { return reservedCapacity; }
+	/**
+	 * @brief Returns items memory growth policy function.
+	 */
+	GrowthPolicy getGrowthPolicy() const noexcept { return growthPolicy; }
+	/**
+	 * @brief Sets items memory growth policy function.
+	 * @details By default items capacity is doubled until it fits all items.
+	 * @param growthPolicy target growth policy function
+	 */
+	void setGrowthPolicy(GrowthPolicy growthPolicy) noexcept
+	{
+		assert(growthPolicy);
+		this->growthPolicy = growthPolicy;
+	}
+
+	/**
+	 * @brief Reserves linear memory block for the specified item count.
+	 * @details Reserved capacity is also kept by the @ref clear(), useful to presize pool before level loading.
+	 * @warning This function can reallocate items memory and invalidate all previous @ref View.
+	 * @param capacity target item capacity
+	 */
+	void reserve(uint32_t capacity)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Reserve of the items inside other create/dispose/clear is not allowed.");
+		#endif
+
+		reservedCapacity = std::max(capacity, 1u);
+		if (capacity > this->capacity)
+			reallocate(capacity);
+	}
+	/**
+	 * @brief Releases unused linear memory block.
+	 * 
+	 * @details
+	 * Trims free item slots from the end of the pool and reallocates memory to fit remaining items.
+	 * Free slots in the middle are kept, so all item identifiers stay valid. Also resets reserved capacity.
+	 * Remaining free slot reuse order is reset to the item index order.
+	 * 
+	 * @warning This function can reallocate items memory and invalidate all previous @ref View.
+	 */
+	void shrinkToFit()
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Shrink of the items inside other create/dispose/clear is not allowed.");
+		isChanging = true;
+		#endif
+
+		if (!freeItems.empty())
+		{
+			// Sorted free list has the trailing free slots at its end, no temporary allocation is needed.
+			std::sort(freeItems.begin(), freeItems.end(), [](ID<T> a, ID<T> b) { return *a < *b; });
+
+			auto newOccupancy = occupancy;
+			while (!freeItems.empty() && *freeItems.back() == newOccupancy)
+			{
+				freeItems.pop_back();
+				newOccupancy--;
+			}
+
+			if (lowestFreeFirst)
+				std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+
+			if (newOccupancy != occupancy)
+			{
+				occupancy = newOccupancy;
+				livePositions.resize(newOccupancy); // Generations are kept, trimmed slot identifiers stay stale.
+				garbageFlags.resize(newOccupancy);
+				if (changeVersions.size() > newOccupancy)
+					changeVersions.resize(newOccupancy);
+			}
+		}
+
+		reservedCapacity = 1;
+		if (capacity != std::max(occupancy, 1u))
+			reallocate(std::max(occupancy, 1u));
+
+		freeItems.shrink_to_fit();
+		garbageItems.shrink_to_fit();
+		liveItems.shrink_to_fit();
+		livePositions.shrink_to_fit();
+		garbageFlags.shrink_to_fit();
+
+		#ifndef NDEBUG
+		isChanging = false;
+		#endif
+	}
+
 	/*******************************************************************************************************************
 	 * @brief Destroys all items in the linear pool.
-	 * @warning This function deallocates items memory and invalidates all previous @ref View.
+	 * @details Keeps reserved items memory, see the @ref reserve().
+	 * @warning This function can deallocate items memory and invalidates all previous @ref View.
 	 * @param destroyItems should call destroy() function of the items
 	 */
 	void clear(bool destroyItems = DestroyItems)
@@ -613,41 +1496,51 @@ public:
 		isChanging = true;
 		#endif
 
-		if (occupancy - (uint32_t)freeItems.size() != 0)
+		if (destroyItems)
 		{
-			if (destroyItems)
-			{
-				for (uint32_t i = 0; i < occupancy; i++)
-				{
-					items[i].destroy();
-					items[i] = T();
-				}
-			}
-			else
-			{
-				for (uint32_t i = 0; i < occupancy; i++)
-					items[i] = T();
-			}
+			for (auto index : liveItems)
+				items[index].destroy();
 		}
+		destructItems();
+
+		if (capacity != reservedCapacity)
+		{
+			deallocateItems(items, capacity);
+			items = allocateItems(reservedCapacity);
+			capacity = reservedCapacity;
+		}
+
+		for (uint32_t i = 0; i < occupancy; i++)
+			generations[i]++; // Generations are kept, cleared item identifiers stay stale.
+		refCounters.clear();
 
-		delete[] items;
-		items = new T[1];
 		occupancy = 0;
-		capacity = 1;
 		freeItems = {};
 		garbageItems = {};
+		liveItems = {};
+		livePositions = {};
+		garbageFlags = {};
+		changeVersions = {};
+		changedItems = {};
 
 		#ifndef NDEBUG
-		version = 0;
+		version++;
 		isChanging = false;
 		#endif
 	}
 
 	/*******************************************************************************************************************
 	 * @brief Actually destroys items.
-	 * @details See the @ref destroy(). It marks destroyed item memory as free, and can reuse it later.
+	 * 
+	 * @details
+	 * See the @ref destroy(). It marks destroyed item memory as free, and can reuse it later.
+	 * Items which destroy() function returned false are kept in the garbage array until the next call.
+	 * Disposed items are removed from the live item array, so do not call it during the pool iteration.
+	 * 
+	 * @param maxCount maximum processed item count, rest of the garbage items are disposed on the next calls
+	 * @return Actually destroyed item count.
 	 */
-	void dispose()
+	uint32_t dispose(uint32_t maxCount = UINT32_MAX)
 	{
 		#ifndef NDEBUG
 		if (isChanging)
@@ -655,125 +1548,280 @@ public:
 		isChanging = true;
 		#endif
 
+		uint32_t disposedCount = 0;
 		if constexpr (DestroyItems)
 		{
-			for (int64_t i = garbageItems.size() - 1; i >= 0; i--)
+			// Compacts not yet destroyed items in one pass, they will be disposed on the next call.
+			auto garbageData = garbageItems.data();
+			auto garbageCount = garbageItems.size();
+			auto processCount = std::min(garbageCount, (size_t)maxCount);
+			size_t keptCount = 0;
+
+			for (size_t i = 0; i < processCount; i++)
 			{
-				auto item = garbageItems[i];
+				auto item = garbageData[i];
 				auto index = *item - 1;
 				if (!items[index].destroy())
+				{
+					garbageData[keptCount++] = item;
 					continue;
+				}
 			
-				items[index] = T();
-				freeItems.push(item);
-				garbageItems.erase(garbageItems.begin() + i);
+				items[index].~T();
+				removeLiveItem(index);
+				freeSlot(item);
+				disposedCount++;
+			}
+
+			// Not yet processed items are moved before the kept ones, so the next call starts from them.
+			auto restCount = garbageCount - processCount;
+			if (restCount > 0)
+			{
+				std::copy(garbageData + processCount, garbageData + garbageCount, garbageData + keptCount);
+				std::rotate(garbageData, garbageData + keptCount, garbageData + keptCount + restCount);
 			}
+			garbageItems.resize(keptCount + restCount);
 		}
 		else
 		{
-			for (auto item : garbageItems)
+			auto processCount = std::min(garbageItems.size(), (size_t)maxCount);
+			for (size_t i = 0; i < processCount; i++)
 			{
-				auto index = *item - 1;
-				items[index] = T();
-				freeItems.push(item);
+				auto item = garbageItems[i];
+				items[*item - 1].~T();
+				removeLiveItem(*item - 1);
+				freeSlot(item);
 			}
-			garbageItems.clear();
+			garbageItems.erase(garbageItems.begin(), garbageItems.begin() + processCount);
+			disposedCount = (uint32_t)processCount;
 		}
 
 		#ifndef NDEBUG
 		isChanging = false;
 		#endif
+		return disposedCount;
 	}
 
 	/*******************************************************************************************************************
-	 * @brief Linear pool iterator class.
+	 * @brief Writes pool item slots and items to the binary snapshot.
+	 *
+	 * @details
+	 * Writes item size, occupancy, generations, free, garbage and live item arrays as contiguous blocks. Trivially
+	 * copyable items are written as a single memory block, other items should be written by the pool owner.
+	 * Snapshot layout is the same for the @ref LinearPool and @ref ChunkedPool.
+	 *
+	 * @param[out] writer target snapshot writer
 	 */
-	struct Iterator
+	void writeSnapshot(SnapshotWriter& writer) const
 	{
-		using iterator_category = std::random_access_iterator_tag;
-		using value_type = T;
-		using difference_type = ptrdiff_t;
-		using pointer = value_type*;
-		using reference = value_type&;
-	private:
-		pointer ptr = nullptr;
-	public:
-		Iterator(pointer ptr) noexcept : ptr(ptr) { }
-		Iterator& operator=(const Iterator& i) noexcept = default;
-		Iterator& operator=(pointer ptr) noexcept { this->ptr = ptr; return (*this); }
-
-		operator bool() const noexcept { return ptr; }
-
-		bool operator==(const Iterator& i) const noexcept { return ptr == i.ptr; }
-		bool operator!=(const Iterator& i) const noexcept { return ptr != i.ptr; }
-
-		Iterator& operator+=(const difference_type& m) noexcept { ptr += m; return *this; }
-		Iterator& operator-=(const difference_type& m) noexcept { ptr -= m; return *this; }
-		Iterator& operator++() noexcept { ++ptr; return *this; }
-		Iterator& operator--() noexcept { --ptr; return *this; }
-		Iterator operator++(int) noexcept { auto tmp = *this; ++ptr; return tmp; }
-		Iterator operator--(int) noexcept { auto tmp = *this; --ptr; return tmp; }
-		Iterator operator+(const difference_type& m) noexcept { return Iterator(ptr + m); }
-		Iterator operator-(const difference_type& m) noexcept { return Iterator(ptr - m); }
-		difference_type operator-(const Iterator& i) noexcept { return std::distance(i.ptr, ptr); }
-
-		reference operator*() const noexcept { return *ptr; }
-		pointer operator->() noexcept { return ptr; }
-	};
+		writer.write((uint32_t)sizeof(T));
+		writer.write(occupancy);
+		writer.writeArray(generations);
+		writer.writeArray(freeItems);
+		writer.writeArray(garbageItems);
+
+		if (garbageItems.empty())
+		{
+			writer.writeArray(liveItems);
+		}
+		else
+		{
+			writer.write(getLiveCount()); // Garbage items are written only to the garbage array.
+			for (auto index : liveItems)
+			{
+				if (!garbageFlags[index])
+					writer.write(index);
+			}
+		}
+
+		if constexpr (std::is_trivially_copyable_v<T>)
+			writer.write(items, (size_t)occupancy * sizeof(T));
+	}
+	/**
+	 * @brief Replaces pool item slots and items with the binary snapshot data.
+	 *
+	 * @details
+	 * Current items are destructed without the destroy() call, use @ref clear() before if it is required. Trivially
+	 * copyable items are copied from the snapshot with a single memcpy(), other live and garbage items are default
+	 * constructed and should be read by the pool owner. Item references are not stored in the snapshot.
+	 *
+	 * @warning This function can reallocate items memory and invalidates all previous @ref View.
+	 * @param[in] reader source snapshot reader
+	 * @throw EcsmError if snapshot data is truncated or corrupted, pool is empty after it.
+	 */
+	void readSnapshot(SnapshotReader& reader)
+	{
+		#ifndef NDEBUG
+		if (isChanging)
+			throw EcsmError("Snapshot read of the items inside other create/dispose/clear is not allowed.");
+		#endif
+
+		if (reader.read<uint32_t>() != (uint32_t)sizeof(T))
+			throw EcsmError("Snapshot pool item size mismatch. (size: " + std::to_string(sizeof(T)) + ")");
+
+		#ifndef NDEBUG
+		isChanging = true;
+		#endif
+
+		destructItems();
+		refCounters.clear();
+		occupancy = 0;
+
+		try
+		{
+			auto newOccupancy = reader.read<uint32_t>();
+			reader.readArray(generations);
+			reader.readArray(freeItems);
+			reader.readArray(garbageItems);
+			reader.readArray(liveItems);
+
+			if (!SnapshotReader::isPoolValid(newOccupancy, generations, freeItems, garbageItems, liveItems))
+				throw EcsmError("Bad pool snapshot item slots.");
+
+			if (newOccupancy > capacity)
+			{
+				auto newCapacity = growthPolicy(capacity, newOccupancy);
+				auto newItems = allocateItems(newCapacity);
+				deallocateItems(items, capacity);
+				items = newItems;
+				capacity = newCapacity;
+			}
+			if constexpr (std::is_trivially_copyable_v<T>)
+			{
+				auto itemData = reader.read((size_t)newOccupancy * sizeof(T));
+				if (newOccupancy > 0)
+					memcpy((void*)items, itemData, (size_t)newOccupancy * sizeof(T));
+			}
+			occupancy = newOccupancy;
+		}
+		catch (...)
+		{
+			freeItems.clear();
+			garbageItems.clear();
+			liveItems.clear();
+			livePositions.clear();
+			garbageFlags.clear();
+			changeVersions.clear();
+			changedItems.clear();
+			#ifndef NDEBUG
+			version++;
+			isChanging = false;
+			#endif
+			throw;
+		}
+
+		if (trackChanges)
+		{
+			changeVersions.assign(occupancy, 0);
+			changedItems.clear();
+			for (auto index : liveItems)
+				markSlotChanged(index);
+		}
+
+		garbageFlags.assign(occupancy, false);
+		for (auto item : garbageItems)
+		{
+			liveItems.push_back(*item - 1);
+			garbageFlags[*item - 1] = true;
+		}
+
+		if constexpr (!std::is_trivially_copyable_v<T>)
+		{
+			for (auto index : liveItems)
+				new (items + index) T();
+		}
+
+		livePositions.assign(occupancy, UINT32_MAX);
+		for (uint32_t i = 0; i < (uint32_t)liveItems.size(); i++)
+			livePositions[liveItems[i]] = i;
+		if (lowestFreeFirst)
+			std::make_heap(freeItems.begin(), freeItems.end(), isHigherItem);
+
+		#ifndef NDEBUG
+		version++;
+		isChanging = false;
+		#endif
+	}
 
 	/*******************************************************************************************************************
-	 * @brief Linear pool constant iterator class.
+	 * @brief Linear pool live item iterator class.
+	 * 
+	 * @details
+	 * Visits only created and not destroyed items in an unspecified order, skipping free and garbage item 
+	 * slots. Iteration cost depends on the live item count instead of the pool occupancy or capacity.
+	 * Items can be destroyed during the iteration, do not create or dispose them.
 	 */
-	struct ConstantIterator
+	template<class V>
+	struct LiveIterator
 	{
-		using iterator_category = std::random_access_iterator_tag;
-		using value_type = const T;
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = V;
 		using difference_type = ptrdiff_t;
 		using pointer = value_type*;
 		using reference = value_type&;
 	private:
-		pointer ptr = nullptr;
+		pointer items = nullptr;
+		const uint32_t* index = nullptr;
+		const uint32_t* end = nullptr;
+		const uint8_t* garbageFlags = nullptr;
+
+		void skipGarbage() noexcept
+		{
+			while (index != end && garbageFlags[*index])
+				++index;
+		}
 	public:
-		ConstantIterator(pointer ptr) noexcept : ptr(ptr) { }
-		ConstantIterator& operator=(const ConstantIterator& i) noexcept = default;
-		ConstantIterator& operator=(pointer ptr) noexcept { this->ptr = ptr; return (*this); }
-
-		operator bool() const noexcept { return ptr; }
-
-		bool operator==(const ConstantIterator& i) const noexcept { return ptr == i.ptr; }
-		bool operator!=(const ConstantIterator& i) const noexcept { return ptr != i.ptr; }
-
-		ConstantIterator& operator+=(const difference_type& m) noexcept { ptr += m; return *this; }
-		ConstantIterator& operator-=(const difference_type& m) noexcept { ptr -= m; return *this; }
-		ConstantIterator& operator++() noexcept { ++ptr; return *this; }
-		ConstantIterator& operator--() noexcept { --ptr; return *this; }
-		ConstantIterator operator++(int) noexcept { auto tmp = *this; ++ptr; return tmp; }
-		ConstantIterator operator--(int) noexcept { auto tmp = *this; --ptr; return tmp; }
-		ConstantIterator operator+(const difference_type& m) noexcept { return ConstantIterator(ptr + m); }
-		ConstantIterator operator-(const difference_type& m) noexcept { return ConstantIterator(ptr - m); }
-		difference_type operator-(const ConstantIterator& i) noexcept { return std::distance(i.ptr, ptr); }
-
-		reference operator*() const noexcept { return *ptr; }
-		pointer operator->() noexcept { return ptr; }
+		LiveIterator(pointer items, const uint32_t* index, 
+			const uint32_t* end, const uint8_t* garbageFlags) noexcept :
+			items(items), index(index), end(end), garbageFlags(garbageFlags) { skipGarbage(); }
+		LiveIterator& operator=(const LiveIterator& i) noexcept = default;
+
+		bool operator==(const LiveIterator& i) const noexcept { return index == i.index; }
+		bool operator!=(const LiveIterator& i) const noexcept { return index != i.index; }
+
+		LiveIterator& operator++() noexcept { ++index; skipGarbage(); return *this; }
+		LiveIterator operator++(int) noexcept { auto tmp = *this; ++index; skipGarbage(); return tmp; }
+
+		reference operator*() const noexcept { return items[*index]; }
+		pointer operator->() noexcept { return &items[*index]; }
 	};
 
+	using Iterator = LiveIterator<T>;
+	using ConstantIterator = LiveIterator<const T>;
+
 	/**
-	 * @brief Returns an iterator pointing to the first element in the items array.
+	 * @brief Returns an iterator pointing to the first live item.
 	 */
-	Iterator begin() noexcept { return Iterator(&items[0]); }
+	Iterator begin() noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return Iterator(items, liveItems.data(), end, garbageFlags.data());
+	}
 	/**
-	 * @brief Returns an iterator pointing to the past-the-end element in the items array.
+	 * @brief Returns an iterator pointing to the past-the-end live item.
 	 */
-	Iterator end() noexcept { return Iterator(&items[capacity]); }
+	Iterator end() noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return Iterator(items, end, end, garbageFlags.data());
+	}
 
 	/**
-	 * @brief Returns a constant iterator pointing to the first element in the items array.
+	 * @brief Returns a constant iterator pointing to the first live item.
 	 */
-	ConstantIterator begin() const noexcept { return ConstantIterator(&items[0]); }
+	ConstantIterator begin() const noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return ConstantIterator(items, liveItems.data(), end, garbageFlags.data());
+	}
 	/**
-	 * @brief Returns a constant iterator pointing to the past-the-end element in the items array.
+	 * @brief Returns a constant iterator pointing to the past-the-end live item.
 	 */
-	ConstantIterator end() const noexcept { return ConstantIterator(&items[capacity]); }
+	ConstantIterator end() const noexcept
+	{
+		auto end = liveItems.data() + liveItems.size();
+		return ConstantIterator(items, end, end, garbageFlags.data());
+	}
 };
 
 } // namespace ecsm
\ No newline at end of file
@@ -0,0 +1,180 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Manager frame profiler classes.
+ */
+
+#pragma once
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace ecsm
+{
+
+/***********************************************************************************************************************
+ * @brief Frame profiler of the manager events, subscribers, dispose phases and pools.
+ *
+ * @details
+ * Attach profiler to the @ref Manager using setProfiler(), manager records high resolution timings of each update
+ * phase, event and subscriber, plus entity and component pool counts and growth events. Collected samples can be
+ * exported to the Chrome trace JSON format. (chrome://tracing or https://ui.perfetto.dev) Manager does not record
+ * anything if profiler is not attached, so it has only a null pointer check cost.
+ *
+ * @note All profiler functions are thread safe, subscribers can be recorded by the thread pool workers.
+ */
+class Profiler final
+{
+public:
+	/**
+	 * @brief Profiler time point or duration. (nanoseconds)
+	 */
+	using Time = int64_t;
+
+	/**
+	 * @brief Recorded time range sample.
+	 */
+	struct Sample final
+	{
+		std::string name;
+		std::string_view category;
+		Time begin = 0;        /**< Sample begin time since the profiler creation. */
+		Time duration = 0;
+		uint32_t thread = 0;   /**< Profiler thread index in the thread appearance order. */
+	};
+	/**
+	 * @brief Recorded pool item count and capacity.
+	 */
+	struct Counter final
+	{
+		std::string name;
+		Time time = 0;
+		uint64_t count = 0;
+		uint64_t capacity = 0;
+		bool isGrown = false; /**< Is pool capacity increased since the previous record. */
+	};
+	/**
+	 * @brief Accumulated sample statistics.
+	 */
+	struct Stats final
+	{
+		uint64_t count = 0;
+		Time totalTime = 0;
+		Time minTime = INT64_MAX;
+		Time maxTime = 0;
+		Time lastTime = 0;
+
+		/**
+		 * @brief Returns average sample duration.
+		 */
+		Time getAverageTime() const noexcept { return count ? totalTime / (Time)count : 0; }
+	};
+
+	using Samples = std::vector<Sample>;
+	using Counters = std::vector<Counter>;
+	using StatsMap = std::map<std::string, Stats, std::less<>>;
+private:
+	std::chrono::steady_clock::time_point startTime;
+	mutable std::mutex locker;
+	Samples samples;
+	Counters counters;
+	StatsMap stats;
+	std::unordered_map<std::string, uint64_t> capacities;
+	std::vector<std::thread::id> threads;
+	uint32_t maxSampleCount = 0;
+	uint32_t growthCount = 0;
+
+	uint32_t getThreadIndex();
+public:
+	/**
+	 * @brief Creates a new frame profiler.
+	 * @param maxSampleCount maximum stored sample and counter count, new ones are not stored until @ref clear()
+	 */
+	Profiler(uint32_t maxSampleCount = 1000000);
+
+	/**
+	 * @brief Returns current time since the profiler creation. (nanoseconds)
+	 */
+	Time getTime() const noexcept
+	{
+		auto time = std::chrono::steady_clock::now() - startTime;
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Records a new time range sample of the calling thread.
+	 * @details Also accumulates sample statistics, which are kept after the maximum sample count is reached.
+	 *
+	 * @param name target sample name
+	 * @param category sample category name (static string)
+	 * @param begin sample begin time (see the @ref getTime())
+	 * @param end sample end time (see the @ref getTime())
+	 */
+	void addSample(std::string name, std::string_view category, Time begin, Time end);
+	/**
+	 * @brief Records pool item count and capacity.
+	 * @details Pool growth event is detected if capacity is increased since the previous record with the same name.
+	 *
+	 * @param name target pool name
+	 * @param time record time (see the @ref getTime())
+	 * @param count current pool item count
+	 * @param capacity current pool item capacity
+	 */
+	void addCounter(std::string name, Time time, uint64_t count, uint64_t capacity);
+
+	/**
+	 * @brief Returns recorded time range samples.
+	 * @warning Do not call it while other threads are recording samples.
+	 */
+	const Samples& getSamples() const noexcept { return samples; }
+	/**
+	 * @brief Returns recorded pool counters.
+	 * @warning Do not call it while other threads are recording samples.
+	 */
+	const Counters& getCounters() const noexcept { return counters; }
+	/**
+	 * @brief Returns accumulated sample statistics by the sample name.
+	 * @warning Do not call it while other threads are recording samples.
+	 */
+	const StatsMap& getStats() const noexcept { return stats; }
+	/**
+	 * @brief Returns sample statistics, or null if there are no samples with specified name.
+	 * @param name target sample name
+	 */
+	const Stats* getStats(std::string_view name) const;
+	/**
+	 * @brief Returns total recorded pool growth event count.
+	 */
+	uint32_t getGrowthCount() const noexcept { return growthCount; }
+
+	/**
+	 * @brief Removes all recorded samples, counters and statistics.
+	 */
+	void clear();
+	/**
+	 * @brief Returns recorded samples and counters in the Chrome trace event JSON format.
+	 * @details Samples are complete events, counters are counter events and pool growths are instant events.
+	 */
+	std::string getChromeTrace() const;
+};
+
+} // namespace ecsm
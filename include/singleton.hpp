@@ -25,9 +25,9 @@
 namespace ecsm
 {
 
-void* getManagerSystem(std::type_index type);
-bool hasManagerSystem(std::type_index type);
-void* tryGetManagerSystem(std::type_index type);
+void* getManagerSystem(TypeIndex type, uint32_t staticTypeID);
+bool hasManagerSystem(uint32_t staticTypeID);
+void* tryGetManagerSystem(uint32_t staticTypeID);
 
 /**
  * @brief Base singleton class.
@@ -72,7 +72,7 @@ protected:
 		if (singletonInstance)
 		{
 			throw EcsmError("Singleton instance is already set. ("
-				"type: " + typeToString(typeid(T)) + ")");
+				"type: " + typeToString(getTypeIndex<T>()) + ")");
 		}
 		singletonInstance = (T*)this;
 		return;
@@ -95,7 +95,7 @@ public:
 		if (singletonInstance)
 			return true;
 		if constexpr (UseManager)
-			return hasManagerSystem(typeid(T));
+			return hasManagerSystem(getStaticTypeID<T>());
 		return false;
 	}
 	/**
@@ -106,9 +106,9 @@ public:
 		if (singletonInstance)
 			return singletonInstance;
 		if constexpr (UseManager)
-			return (T*)getManagerSystem(typeid(T));
+			return (T*)getManagerSystem(getTypeIndex<T>(), getStaticTypeID<T>());
 		throw EcsmError("Singleton instance is not set. ("
-			"type: " + typeToString(typeid(T)) + ")");
+			"type: " + typeToString(getTypeIndex<T>()) + ")");
 	}
 	/**
 	 * @brief Returns class singleton or manager instance if exist.
@@ -118,7 +118,7 @@ public:
 		if (singletonInstance)
 			return singletonInstance;
 		if constexpr (UseManager)
-			return (T*)tryGetManagerSystem(typeid(T));
+			return (T*)tryGetManagerSystem(getStaticTypeID<T>());
 		return nullptr;
 	}
 };
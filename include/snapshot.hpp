@@ -0,0 +1,229 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Binary snapshot writer and reader classes.
+ */
+
+#pragma once
+#include "ecsm-error.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace ecsm
+{
+
+/***********************************************************************************************************************
+ * @brief Binary snapshot data writer.
+ *
+ * @details
+ * Values are written as contiguous blocks in the native byte order without any padding, so snapshot can be loaded
+ * only on the platform with the same endianness. Pool item arrays are written as a single memory block.
+ */
+class SnapshotWriter final
+{
+	std::vector<uint8_t> data;
+public:
+	/**
+	 * @brief Writes raw memory block.
+	 * @param[in] values target memory block
+	 * @param size memory block size in bytes
+	 */
+	void write(const void* values, size_t size)
+	{
+		if (size > 0)
+			data.insert(data.end(), (const uint8_t*)values, (const uint8_t*)values + size);
+	}
+	/**
+	 * @brief Writes trivially copyable value.
+	 * @param value target value
+	 */
+	template<class T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Value should be trivially copyable.");
+		write(&value, sizeof(T));
+	}
+	/**
+	 * @brief Writes trivially copyable value array and its size.
+	 * @param[in] values target value array
+	 */
+	template<class T, class A>
+	void writeArray(const std::vector<T, A>& values)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Value should be trivially copyable.");
+		write((uint32_t)values.size());
+		write(values.data(), values.size() * sizeof(T));
+	}
+	/**
+	 * @brief Writes string characters and its length.
+	 * @param value target string
+	 */
+	void writeString(std::string_view value)
+	{
+		write((uint32_t)value.size());
+		write(value.data(), value.size());
+	}
+
+	/**
+	 * @brief Returns written snapshot data.
+	 */
+	const std::vector<uint8_t>& getData() const noexcept { return data; }
+	/**
+	 * @brief Removes all written data, keeps allocated memory.
+	 */
+	void clear() noexcept { data.clear(); }
+};
+
+/***********************************************************************************************************************
+ * @brief Binary snapshot data reader.
+ *
+ * @details
+ * Reads values from the external memory block, which can be a memory mapped snapshot file. Data is not copied
+ * by the reader, pool item arrays are copied from it directly to the pool memory.
+ *
+ * @warning Snapshot memory block should outlive the reader.
+ */
+class SnapshotReader final
+{
+	const uint8_t* data = nullptr;
+	size_t size = 0, offset = 0;
+public:
+	/**
+	 * @brief Creates a new snapshot reader.
+	 * @param[in] data snapshot memory block
+	 * @param size snapshot memory block size in bytes
+	 */
+	SnapshotReader(const void* data, size_t size) noexcept : data((const uint8_t*)data), size(size) { }
+
+	/**
+	 * @brief Returns raw memory block and advances reader.
+	 * @param count memory block size in bytes
+	 * @throw EcsmError if snapshot data is truncated.
+	 */
+	const void* read(size_t count)
+	{
+		if (count > size - offset)
+			throw EcsmError("Snapshot data is truncated. (offset: " + std::to_string(offset) + ")");
+		auto values = data + offset;
+		offset += count;
+		return values;
+	}
+	/**
+	 * @brief Reads trivially copyable value.
+	 * @throw EcsmError if snapshot data is truncated.
+	 */
+	template<class T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Value should be trivially copyable.");
+		T value;
+		memcpy((void*)&value, read(sizeof(T)), sizeof(T));
+		return value;
+	}
+	/**
+	 * @brief Reads trivially copyable value array and its size.
+	 * @details Array is not changed if snapshot data is truncated.
+	 *
+	 * @param[out] values target value array
+	 * @throw EcsmError if snapshot data is truncated.
+	 */
+	template<class T, class A>
+	void readArray(std::vector<T, A>& values)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Value should be trivially copyable.");
+		auto count = read<uint32_t>();
+		auto arrayData = read((size_t)count * sizeof(T));
+		values.resize(count);
+		if (count > 0)
+			memcpy((void*)values.data(), arrayData, (size_t)count * sizeof(T));
+	}
+	/**
+	 * @brief Reads string characters and its length.
+	 * @details Returned string points to the snapshot memory block.
+	 * @throw EcsmError if snapshot data is truncated.
+	 */
+	std::string_view readString()
+	{
+		auto length = read<uint32_t>();
+		return std::string_view((const char*)read(length), length);
+	}
+
+	/**
+	 * @brief Returns current read offset in bytes.
+	 */
+	size_t getOffset() const noexcept { return offset; }
+	/**
+	 * @brief Returns snapshot memory block size in bytes.
+	 */
+	size_t getSize() const noexcept { return size; }
+	/**
+	 * @brief Returns true if all snapshot data is read.
+	 */
+	bool isEnd() const noexcept { return offset == size; }
+
+	/**
+	 * @brief Returns true if pool snapshot item slots are consistent.
+	 * @details Each occupied item slot should be exactly once in the free, garbage or live item array.
+	 *
+	 * @param occupancy pool occupied item slot count
+	 * @param[in] generations pool item slot generations
+	 * @param[in] freeItems pool free item identifiers
+	 * @param[in] garbageItems pool garbage item identifiers
+	 * @param[in] liveItems pool live item slot indices
+	 */
+	template<class G, class I, class L>
+	static bool isPoolValid(uint32_t occupancy, const G& generations,
+		const I& freeItems, const I& garbageItems, const L& liveItems)
+	{
+		if (generations.size() < occupancy || (uint64_t)freeItems.size() +
+			garbageItems.size() + liveItems.size() != occupancy)
+		{
+			return false;
+		}
+
+		std::vector<bool> isSlotUsed(occupancy);
+		auto useSlot = [&isSlotUsed, occupancy](uint32_t index)
+		{
+			if (index >= occupancy || isSlotUsed[index])
+				return false;
+			isSlotUsed[index] = true;
+			return true;
+		};
+
+		for (auto item : freeItems)
+		{
+			if (!item || !useSlot(*item - 1))
+				return false;
+		}
+		for (auto item : garbageItems)
+		{
+			if (!item || !useSlot(*item - 1))
+				return false;
+		}
+		for (auto index : liveItems)
+		{
+			if (!useSlot(index))
+				return false;
+		}
+		return true;
+	}
+};
+
+} // namespace ecsm
@@ -0,0 +1,389 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Structure of arrays (SoA) component storage class.
+ */
+
+#pragma once
+#include "linear-pool.hpp"
+
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace ecsm
+{
+
+class Entity;
+
+/***********************************************************************************************************************
+ * @brief Component storage with each declared field in the separate aligned array. (SoA)
+ *
+ * @details
+ * Components are stored densely without gaps, each field is a contiguous array aligned to the @ref alignment,
+ * so loops over the fields can be auto-vectorized with the full SIMD register width. Component item with the
+ * entity back-reference is stored in the side array at the same row. Removing component moves the last row to
+ * the removed one, use @ref findRow() to get entity component row.
+ *
+ * @warning Adding or removing components can move rows and invalidates all previous @ref View and field pointers.
+ *
+ * @tparam T type of the component item (entity back-reference)
+ * @tparam Fields types of the component fields
+ */
+template<class T, class... Fields>
+class SoaStorage final
+{
+public:
+	/**
+	 * @brief Field array memory alignment in bytes. (Cache line and AVX-512 register size)
+	 */
+	static constexpr size_t alignment = 64;
+	/**
+	 * @brief Component field type.
+	 * @tparam I index of the field
+	 */
+	template<size_t I>
+	using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+private:
+	static_assert(sizeof...(Fields) > 0, "Must have at least one field type.");
+	static_assert(std::is_trivially_copyable_v<T> && (std::is_trivially_copyable_v<Fields> && ...),
+		"Item and field types should be trivially copyable.");
+	static_assert(std::is_default_constructible_v<T> && (std::is_default_constructible_v<Fields> && ...),
+		"Item and field types should be default constructible.");
+
+	uint8_t* memory = nullptr;
+	T* items = nullptr;
+	std::tuple<Fields*...> fields = {};
+	std::vector<uint32_t> rows;
+	uint32_t count = 0;
+	uint32_t capacity = 0;
+
+	#ifndef NDEBUG
+	uint64_t version = 0;
+	#endif
+
+	template<size_t... I>
+	void copyFields(const std::tuple<const Fields*...>& sources, std::index_sequence<I...>) noexcept
+	{
+		(memcpy((void*)std::get<I>(fields), std::get<I>(sources), count * sizeof(Field<I>)), ...);
+	}
+
+	static constexpr size_t alignSize(size_t size) noexcept { return (size + (alignment - 1)) & ~(alignment - 1); }
+
+	void reallocate(uint32_t newCapacity)
+	{
+		auto size = alignSize(newCapacity * sizeof(T));
+		((size += alignSize(newCapacity * sizeof(Fields))), ...);
+		auto newMemory = newCapacity > 0 ? (uint8_t*)operator new(size, std::align_val_t(alignment)) : nullptr;
+
+		auto offset = (size_t)0;
+		auto relocate = [this, newMemory, newCapacity, &offset](auto* array)
+		{
+			using U = std::remove_pointer_t<decltype(array)>;
+			auto newArray = newMemory ? (U*)(newMemory + offset) : nullptr;
+			if (count > 0)
+				memcpy((void*)newArray, array, count * sizeof(U));
+			offset += alignSize(newCapacity * sizeof(U));
+			return newArray;
+		};
+
+		items = relocate(items);
+		std::apply([&relocate](auto*&... arrays) { ((arrays = relocate(arrays)), ...); }, fields);
+		operator delete(memory, std::align_val_t(alignment));
+		memory = newMemory;
+		capacity = newCapacity;
+
+		#ifndef NDEBUG
+		version++; // Protects from the use after reallocation.
+		#endif
+	}
+public:
+	/**
+	 * @brief Creates a new empty SoA storage.
+	 */
+	SoaStorage() = default;
+	/**
+	 * @brief Deallocates storage memory.
+	 */
+	~SoaStorage() { operator delete(memory, std::align_val_t(alignment)); }
+
+	SoaStorage(const SoaStorage&) = delete;
+	SoaStorage& operator=(const SoaStorage&) = delete;
+
+	/*******************************************************************************************************************
+	 * @brief Adds a new value initialized component to the entity.
+	 * @param entity target entity instance
+	 * @return Added component row.
+	 * @throw EcsmError if component is already added.
+	 */
+	uint32_t add(ID<Entity> entity)
+	{
+		assert(entity);
+		auto index = *entity - 1;
+		if (index < rows.size() && rows[index] != UINT32_MAX)
+			throw EcsmError("SoA component is already added. (entity: " + std::to_string(*entity) + ")");
+
+		if (index >= rows.size())
+			rows.resize(index + 1, UINT32_MAX);
+		if (count == capacity)
+			reallocate(capacity ? capacity * 2 : 16);
+
+		auto row = count++;
+		items[row] = T();
+		items[row].entity = entity;
+		std::apply([row](Fields*... arrays) { ((arrays[row] = Fields()), ...); }, fields);
+		rows[index] = row;
+		return row;
+	}
+	/**
+	 * @brief Removes entity component.
+	 * @details Moves the last component row to the removed one.
+	 *
+	 * @param entity target entity instance
+	 * @throw EcsmError if component is not added.
+	 */
+	void remove(ID<Entity> entity)
+	{
+		auto row = findRow(entity);
+		if (row == UINT32_MAX)
+			throw EcsmError("SoA component is not added. (entity: " + std::to_string(*entity) + ")");
+
+		auto lastRow = --count;
+		if (row != lastRow)
+		{
+			items[row] = items[lastRow];
+			std::apply([row, lastRow](Fields*... arrays) { ((arrays[row] = arrays[lastRow]), ...); }, fields);
+			rows[*items[row].getEntity() - 1] = row;
+		}
+		rows[*entity - 1] = UINT32_MAX;
+
+		#ifndef NDEBUG
+		version++; // Protects from the use after move.
+		#endif
+	}
+	/**
+	 * @brief Copies all component fields from source row to destination.
+	 * @details Destination component entity is preserved.
+	 *
+	 * @param sourceRow source component row (from)
+	 * @param destinationRow destination component row (to)
+	 */
+	void copy(uint32_t sourceRow, uint32_t destinationRow) noexcept
+	{
+		assert(sourceRow < count);
+		assert(destinationRow < count);
+		std::apply([sourceRow, destinationRow](Fields*... arrays)
+		{
+			((arrays[destinationRow] = arrays[sourceRow]), ...);
+		}, fields);
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Returns entity component row, or UINT32_MAX if component is not added.
+	 * @param entity target entity instance
+	 */
+	uint32_t findRow(ID<Entity> entity) const noexcept
+	{
+		assert(entity);
+		auto index = *entity - 1;
+		return index < rows.size() ? rows[index] : UINT32_MAX;
+	}
+	/**
+	 * @brief Returns true if entity has component.
+	 * @param entity target entity instance
+	 */
+	bool has(ID<Entity> entity) const noexcept { return findRow(entity) != UINT32_MAX; }
+	/**
+	 * @brief Returns entity component item @ref View, or null if component is not added.
+	 * @warning Do not store views, use them only in place. Because component rows can be moved later.
+	 * @param entity target entity instance
+	 */
+	View<T> get(ID<Entity> entity) const noexcept
+	{
+		auto row = findRow(entity);
+		if (row == UINT32_MAX)
+			return {};
+		#ifndef NDEBUG
+		return View<T>(items + row, version);
+		#else
+		return View<T>(items + row);
+		#endif
+	}
+
+	/**
+	 * @brief Returns component field array.
+	 * @details Array is aligned to the @ref alignment and contains @ref getCount() fields.
+	 * @tparam I index of the field
+	 */
+	template<size_t I>
+	Field<I>* getField() noexcept { return std::get<I>(fields); }
+	/**
+	 * @brief Returns constant component field array.
+	 * @details Array is aligned to the @ref alignment and contains @ref getCount() fields.
+	 * @tparam I index of the field
+	 */
+	template<size_t I>
+	const Field<I>* getField() const noexcept { return std::get<I>(fields); }
+	/**
+	 * @brief Returns component field at the row.
+	 * @param row target component row
+	 * @tparam I index of the field
+	 */
+	template<size_t I>
+	Field<I>& getField(uint32_t row) noexcept
+	{
+		assert(row < count);
+		return std::get<I>(fields)[row];
+	}
+	/**
+	 * @brief Returns constant component field at the row.
+	 * @param row target component row
+	 * @tparam I index of the field
+	 */
+	template<size_t I>
+	const Field<I>& getField(uint32_t row) const noexcept
+	{
+		assert(row < count);
+		return std::get<I>(fields)[row];
+	}
+	/**
+	 * @brief Returns component item array. (Row to entity)
+	 */
+	const T* getItems() const noexcept { return items; }
+	/**
+	 * @brief Returns component count.
+	 */
+	uint32_t getCount() const noexcept { return count; }
+	/**
+	 * @brief Returns allocated component row count.
+	 */
+	uint32_t getCapacity() const noexcept { return capacity; }
+
+	/*******************************************************************************************************************
+	 * @brief Reserves memory for the specified component count.
+	 * @param capacity target component row count
+	 */
+	void reserve(uint32_t capacity)
+	{
+		if (capacity > this->capacity)
+			reallocate(capacity);
+	}
+	/**
+	 * @brief Deallocates unused component rows memory.
+	 */
+	void shrink()
+	{
+		if (count < capacity)
+			reallocate(count);
+	}
+
+	/**
+	 * @brief Calls function for each component fields.
+	 *
+	 * @details
+	 * Function signature: void(Fields&...). Function is called in a plain loop over the field arrays, so
+	 * simple arithmetic functions are inlined and auto-vectorized by the compiler.
+	 *
+	 * @warning Do not add or remove components inside the function.
+	 * @param function target function to call
+	 */
+	template<class Function>
+	void each(Function&& function)
+	{
+		auto count = this->count;
+		std::apply([count, &function](Fields*... arrays)
+		{
+			for (uint32_t i = 0; i < count; i++)
+				function(arrays[i]...);
+		}, fields);
+	}
+	/**
+	 * @brief Calls function once with all component field arrays.
+	 *
+	 * @details
+	 * Function signature: void(uint32_t count, Fields*...). Use it to write explicitly vectorized loops,
+	 * all field arrays are aligned to the @ref alignment. Use @ref getItems() to get row entities.
+	 *
+	 * @warning Do not add or remove components inside the function.
+	 * @param function target function to call
+	 */
+	template<class Function>
+	void eachBatch(Function&& function)
+	{
+		auto count = this->count;
+		std::apply([count, &function](Fields*... arrays) { function(count, arrays...); }, fields);
+	}
+
+	/*******************************************************************************************************************
+	 * @brief Writes all storage components to the binary snapshot.
+	 * @param[out] writer target snapshot writer
+	 */
+	void writeSnapshot(SnapshotWriter& writer) const
+	{
+		writer.write(count);
+		writer.write(items, count * sizeof(T));
+		std::apply([this, &writer](Fields*... arrays)
+		{
+			(writer.write(arrays, count * sizeof(Fields)), ...);
+		}, fields);
+	}
+	/**
+	 * @brief Replaces all storage components with the binary snapshot data.
+	 * @details Storage is not changed if snapshot data is truncated.
+	 *
+	 * @param[in] reader source snapshot reader
+	 * @throw EcsmError if snapshot data is truncated or invalid.
+	 */
+	void readSnapshot(SnapshotReader& reader)
+	{
+		auto newCount = reader.read<uint32_t>();
+		auto newItems = (const T*)reader.read(newCount * sizeof(T));
+		std::tuple<const Fields*...> newFields{ (const Fields*)reader.read(newCount * sizeof(Fields))... };
+
+		std::vector<uint32_t> newRows;
+		for (uint32_t i = 0; i < newCount; i++)
+		{
+			T item;
+			memcpy((void*)&item, newItems + i, sizeof(T));
+			auto entity = item.getEntity();
+			if (!entity)
+				throw EcsmError("Invalid SoA storage snapshot entity. (row: " + std::to_string(i) + ")");
+			if (*entity > newRows.size())
+				newRows.resize(*entity, UINT32_MAX);
+			if (newRows[*entity - 1] != UINT32_MAX)
+				throw EcsmError("Duplicate SoA storage snapshot entity. (entity: " + std::to_string(*entity) + ")");
+			newRows[*entity - 1] = i;
+		}
+
+		count = 0;
+		if (newCount > capacity)
+			reallocate(newCount);
+		count = newCount;
+		rows = std::move(newRows);
+
+		if (count > 0)
+		{
+			memcpy((void*)items, newItems, count * sizeof(T));
+			copyFields(newFields, std::index_sequence_for<Fields...>());
+		}
+
+		#ifndef NDEBUG
+		version++;
+		#endif
+	}
+};
+
+} // namespace ecsm
@@ -0,0 +1,195 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Work stealing thread pool classes.
+ */
+
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace ecsm
+{
+
+/***********************************************************************************************************************
+ * @brief Thread pool with work stealing task deques.
+ *
+ * @details
+ * Each worker thread has its own task deque. Worker pushes and pops its own tasks from the back (LIFO), which keeps
+ * recently created data hot in the cache, and steals tasks of the other workers from the front (FIFO) when its deque
+ * is empty. Threads waiting for the tasks also execute queued tasks, so nested parallel loops can not deadlock.
+ *
+ * @warning Manager entity and component changes are not thread safe, do not call them inside tasks.
+ */
+class ThreadPool final
+{
+public:
+	/**
+	 * @brief Thread pool task function.
+	 */
+	using Task = std::function<void()>;
+	/**
+	 * @brief Thread pool range task function. (begin, end)
+	 */
+	using RangeTask = std::function<void(uint32_t, uint32_t)>;
+
+	/**
+	 * @brief Group of the tasks which can be waited together.
+	 * @warning Group should outlive all of its tasks, always wait for it before destruction.
+	 */
+	class TaskGroup final
+	{
+		std::atomic<uint32_t> count = 0;
+		std::exception_ptr exception = nullptr;
+		std::mutex mutex;
+		friend class ThreadPool;
+	public:
+		/**
+		 * @brief Returns count of the not yet finished group tasks.
+		 */
+		uint32_t getCount() const noexcept { return count.load(); }
+	};
+private:
+	using Group = TaskGroup;
+
+	struct Job final
+	{
+		Task task;
+		Group* group = nullptr;
+	};
+	struct Worker final
+	{
+		std::deque<Job> jobs;
+		std::mutex mutex;
+	};
+
+	std::unique_ptr<Worker[]> workers;
+	std::vector<std::thread> threads;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+	std::atomic<uint32_t> queuedCount = 0;
+	std::atomic<uint32_t> nextWorker = 0;
+	Group defaultGroup;
+	uint32_t workerCount = 0;
+	bool isRunning = true;
+
+	void addJob(Task&& task, Group* group);
+	bool runJob(uint32_t workerIndex);
+	void waitGroup(Group* group);
+	void runWorker(uint32_t workerIndex);
+public:
+	/**
+	 * @brief Creates a new thread pool and starts worker threads.
+	 * @param threadCount worker thread count, or 0 to use hardware concurrency
+	 */
+	ThreadPool(uint32_t threadCount = 0);
+	/**
+	 * @brief Waits for all tasks and stops worker threads.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief Returns thread pool worker thread count.
+	 */
+	uint32_t getThreadCount() const noexcept { return workerCount; }
+	/**
+	 * @brief Returns true if it is called from the thread pool worker thread.
+	 */
+	bool isWorkerThread() const noexcept;
+
+	/*******************************************************************************************************************
+	 * @brief Adds a new task to the thread pool.
+	 * @details Task is pushed to the current worker deque if called from the worker thread.
+	 * @param task target task function
+	 */
+	void addTask(Task task)
+	{
+		assert(task);
+		addJob(std::move(task), &defaultGroup);
+	}
+	/**
+	 * @brief Waits for all tasks added by the @ref addTask().
+	 * @details Calling thread executes queued tasks while waiting.
+	 * @throw Rethrows first exception thrown by the tasks.
+	 */
+	void wait() { waitGroup(&defaultGroup); }
+
+	/**
+	 * @brief Adds a new task of the group to the thread pool.
+	 * @details Task is pushed to the current worker deque if called from the worker thread.
+	 * @param task target task function
+	 * @param group target task group
+	 */
+	void addTask(Task task, TaskGroup& group)
+	{
+		assert(task);
+		addJob(std::move(task), &group);
+	}
+	/**
+	 * @brief Waits for all tasks of the group.
+	 * @details Calling thread executes queued tasks while waiting.
+	 * @param group target task group
+	 * @throw Rethrows first exception thrown by the group tasks.
+	 */
+	void wait(TaskGroup& group) { waitGroup(&group); }
+
+	/**
+	 * @brief Splits range into batches and executes them in parallel.
+	 * @details Function signature: void(uint32_t begin, uint32_t end). Calling thread also executes batches.
+	 *
+	 * @param count total range item count
+	 * @param function target range function
+	 * @param batchSize range item count per task, or 0 to select it automatically
+	 *
+	 * @throw Rethrows first exception thrown by the range function.
+	 */
+	void parallelFor(uint32_t count, const RangeTask& function, uint32_t batchSize = 0);
+
+	/**
+	 * @brief Executes function for each live pool item in parallel.
+	 * @details Function signature: void(T& item). See the @ref LinearPool and @ref ChunkedPool.
+	 * @warning Do not create or destroy pool items inside the function.
+	 *
+	 * @param pool target item pool
+	 * @param function target item function
+	 * @param batchSize item count per task, or 0 to select it automatically
+	 * @tparam Pool type of the item pool
+	 *
+	 * @throw Rethrows first exception thrown by the item function.
+	 */
+	template<class Pool, class Function>
+	void parallelForEach(Pool& pool, Function&& function, uint32_t batchSize = 0)
+	{
+		parallelFor(pool.getLiveRangeSize(), [&pool, &function](uint32_t rangeBegin, uint32_t rangeEnd)
+		{
+			pool.eachInRange(rangeBegin, rangeEnd, function);
+		}, batchSize);
+	}
+};
+
+} // namespace ecsm
@@ -0,0 +1,155 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/***********************************************************************************************************************
+ * @file
+ * @brief Common type identifier functions. (RTTI independent)
+ */
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#ifndef ECSM_NO_RTTI
+#include <typeindex>
+#endif
+
+namespace ecsm
+{
+
+#ifndef ECSM_NO_RTTI
+/**
+ * @brief Type information wrapper, used as the ordered and hashed container key.
+ * @details It is std::type_index, or ecsm::TypeIndex class if library is built with ECSM_NO_RTTI.
+ */
+using TypeIndex = std::type_index;
+
+/**
+ * @brief Returns type @ref TypeIndex. (typeid() replacement)
+ * @tparam T target type
+ */
+template<class T>
+TypeIndex getTypeIndex() noexcept { return typeid(T); }
+#else
+
+/**
+ * @brief Type information record, unique for each type.
+ */
+struct TypeInfo final
+{
+	const char* signature = nullptr; /**< Compiler specific function signature with the type name. */
+};
+
+template<class T>
+constexpr const char* getTypeSignature() noexcept
+{
+	#if defined(_MSC_VER)
+	return __FUNCSIG__;
+	#else
+	return __PRETTY_FUNCTION__;
+	#endif
+}
+
+/**
+ * @brief Returns process wide type information record for the specified type signature.
+ * @details Records are stored inside the library, so the same type has one record across shared library boundaries.
+ * @param[in] signature target type signature string
+ */
+const TypeInfo& registerTypeInfo(const char* signature) noexcept;
+
+/**
+ * @brief Type information wrapper, used as the ordered and hashed container key.
+ * @details std::type_index replacement for the builds without RTTI, compares type information record addresses.
+ */
+class TypeIndex final
+{
+	const TypeInfo* info = nullptr;
+public:
+	/**
+	 * @brief Creates a new type information wrapper.
+	 * @param[in] info target type information record
+	 */
+	constexpr TypeIndex(const TypeInfo& info) noexcept : info(&info) { }
+
+	/**
+	 * @brief Returns type signature string. (Not demangled)
+	 */
+	const char* name() const noexcept { return info->signature; }
+	/**
+	 * @brief Returns type hash code.
+	 */
+	size_t hash_code() const noexcept { return std::hash<const void*>()(info); }
+
+	bool operator==(const TypeIndex& other) const noexcept { return info == other.info; }
+	bool operator!=(const TypeIndex& other) const noexcept { return info != other.info; }
+	bool operator<(const TypeIndex& other) const noexcept { return std::less<const TypeInfo*>()(info, other.info); }
+	bool operator>(const TypeIndex& other) const noexcept { return other < *this; }
+	bool operator<=(const TypeIndex& other) const noexcept { return !(other < *this); }
+	bool operator>=(const TypeIndex& other) const noexcept { return !(*this < other); }
+};
+
+/**
+ * @brief Returns type @ref TypeIndex. (typeid() replacement)
+ * @tparam T target type
+ */
+template<class T>
+TypeIndex getTypeIndex() noexcept
+{
+	static const TypeInfo& info = registerTypeInfo(getTypeSignature<std::remove_cv_t<T>>());
+	return info;
+}
+#endif
+
+/***********************************************************************************************************************
+ * @brief Returns static type identifier of the specified type, allocates a new one on the first call.
+ * @details Identifiers are allocated inside the library, so they match across shared library boundaries.
+ * @param type target type index
+ */
+uint32_t allocateStaticTypeID(TypeIndex type) noexcept;
+/**
+ * @brief Returns allocated static type identifier count.
+ */
+uint32_t getStaticTypeCount() noexcept;
+
+/**
+ * @brief Returns static type identifier.
+ *
+ * @details
+ * Identifiers are assigned from the process wide counter on the first call for each type, so they are small and
+ * dense, and can be used to index arrays instead of hashing @ref TypeIndex. Identifier values depend on the call
+ * order, do not store or serialize them. The result is cached per module, allocation happens inside the library.
+ *
+ * @tparam T target type
+ */
+template<class T>
+uint32_t getStaticTypeID() noexcept
+{
+	static const uint32_t typeID = allocateStaticTypeID(getTypeIndex<T>());
+	return typeID;
+}
+
+} // namespace ecsm
+
+#ifdef ECSM_NO_RTTI
+namespace std
+{
+	template<>
+	struct hash<ecsm::TypeIndex>
+	{
+		size_t operator()(const ecsm::TypeIndex& type) const noexcept { return type.hash_code(); }
+	};
+}
+#endif
@@ -18,22 +18,48 @@
  */
 
 #pragma once
+#include "type-index.hpp"
 #include <string>
 #include <cstring>
-#include <typeindex>
+#include <string_view>
 
-#ifdef __GNUG__
+#if defined(__GNUG__) && !defined(ECSM_NO_RTTI)
 #include <cxxabi.h>
 #endif
 
 namespace ecsm
 {
 
+#ifdef ECSM_NO_RTTI
 /**
- * @brief Returns @ref type_index string representation.
+ * @brief Returns @ref TypeIndex string representation.
+ * @details Type name is extracted from the type signature.
  * @param type target type
  */
-static std::string typeToString(std::type_index type)
+inline std::string typeToString(TypeIndex type)
+{
+	std::string_view signature = type.name();
+	#if defined(_MSC_VER)
+	auto begin = signature.find("getTypeSignature<");
+	auto end = signature.rfind(">(");
+	if (begin == std::string_view::npos || end == std::string_view::npos || end < begin)
+		return std::string(signature);
+	begin += sizeof("getTypeSignature<") - 1;
+	#else
+	auto begin = signature.find("T = ");
+	auto end = signature.find_first_of(";]", begin);
+	if (begin == std::string_view::npos || end == std::string_view::npos)
+		return std::string(signature);
+	begin += sizeof("T = ") - 1;
+	#endif
+	return std::string(signature.substr(begin, end - begin));
+}
+#else
+/**
+ * @brief Returns @ref TypeIndex string representation.
+ * @param type target type
+ */
+inline std::string typeToString(TypeIndex type)
 {
 	auto name = type.name();
 
@@ -55,14 +81,16 @@ static std::string typeToString(std::type_index type)
 	#endif
 	return result;
 }
+#endif
+
 /**
  * @brief Returns type string representation.
  * @tparam T target type
  */
 template<typename T>
-static std::string typeToString()
+inline std::string typeToString()
 {
-	return typeToString(typeid(T));
+	return typeToString(getTypeIndex<T>());
 }
 
 }; // namespace ecsm
\ No newline at end of file
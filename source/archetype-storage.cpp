@@ -0,0 +1,248 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "archetype-storage.hpp"
+
+using namespace ecsm;
+
+//**********************************************************************************************************************
+ArchetypeStorage::~ArchetypeStorage()
+{
+	for (const auto& pair : archetypes)
+	{
+		auto archetype = pair.second;
+		auto count = (uint32_t)archetype->entities.size();
+
+		for (const auto& column : archetype->columns)
+		{
+			const auto& columnType = columnTypes[column.type];
+			for (uint32_t i = 0; i < count; i++)
+				columnType.destruct(column.data + i * columnType.size);
+			operator delete(column.data, std::align_val_t(columnType.alignment));
+		}
+
+		delete archetype;
+	}
+}
+
+//**********************************************************************************************************************
+ArchetypeStorage::Archetype* ArchetypeStorage::findArchetype(const std::vector<uint32_t>& types)
+{
+	auto result = archetypes.find(types);
+	if (result != archetypes.end())
+		return result->second;
+
+	auto archetype = new Archetype();
+	archetype->types = types;
+	archetype->columns.resize(types.size());
+	for (size_t i = 0; i < types.size(); i++)
+		archetype->columns[i].type = types[i];
+	archetypes.emplace(types, archetype);
+	return archetype;
+}
+ArchetypeStorage::Archetype* ArchetypeStorage::getAddArchetype(Archetype* archetype, uint32_t type)
+{
+	if (!archetype)
+		return findArchetype({ type });
+
+	auto result = archetype->addEdges.find(type);
+	if (result != archetype->addEdges.end())
+		return result->second;
+
+	auto types = archetype->types;
+	types.insert(std::lower_bound(types.begin(), types.end(), type), type);
+	auto addArchetype = findArchetype(types);
+	archetype->addEdges.emplace(type, addArchetype);
+	return addArchetype;
+}
+ArchetypeStorage::Archetype* ArchetypeStorage::getRemoveArchetype(Archetype* archetype, uint32_t type)
+{
+	if (archetype->types.size() == 1)
+		return nullptr;
+
+	auto result = archetype->removeEdges.find(type);
+	if (result != archetype->removeEdges.end())
+		return result->second;
+
+	auto types = archetype->types;
+	types.erase(std::lower_bound(types.begin(), types.end(), type));
+	auto removeArchetype = findArchetype(types);
+	archetype->removeEdges.emplace(type, removeArchetype);
+	return removeArchetype;
+}
+
+//**********************************************************************************************************************
+uint32_t ArchetypeStorage::addRow(Archetype* archetype, ID<Entity> entity)
+{
+	auto row = (uint32_t)archetype->entities.size();
+	if (row == archetype->capacity)
+	{
+		auto capacity = archetype->capacity ? archetype->capacity * 2 : 16;
+		for (auto& column : archetype->columns)
+		{
+			const auto& columnType = columnTypes[column.type];
+			auto data = (uint8_t*)operator new(capacity * columnType.size, std::align_val_t(columnType.alignment));
+			for (uint32_t i = 0; i < row; i++)
+				columnType.relocate(data + i * columnType.size, column.data + i * columnType.size);
+			operator delete(column.data, std::align_val_t(columnType.alignment));
+			column.data = data;
+		}
+		archetype->capacity = capacity;
+	}
+
+	archetype->entities.push_back(entity);
+	return row;
+}
+void ArchetypeStorage::removeRow(Archetype* archetype, uint32_t row) noexcept
+{
+	auto lastRow = (uint32_t)archetype->entities.size() - 1;
+	if (row != lastRow)
+	{
+		for (auto& column : archetype->columns)
+		{
+			const auto& columnType = columnTypes[column.type];
+			columnType.relocate(column.data + row * columnType.size, column.data + lastRow * columnType.size);
+		}
+
+		auto lastEntity = archetype->entities[lastRow];
+		archetype->entities[row] = lastEntity;
+		records[*lastEntity - 1].row = row;
+	}
+	archetype->entities.pop_back();
+}
+
+//**********************************************************************************************************************
+void ArchetypeStorage::moveEntity(ID<Entity> entity, Archetype* newArchetype, uint32_t addedType, uint32_t removedType)
+{
+	auto record = records[*entity - 1];
+	auto oldArchetype = record.archetype;
+
+	if (newArchetype)
+	{
+		auto newRow = addRow(newArchetype, entity);
+		for (const auto& column : newArchetype->columns)
+		{
+			const auto& columnType = columnTypes[column.type];
+			auto destination = column.data + newRow * columnType.size;
+
+			if (column.type == addedType)
+			{
+				columnType.construct(destination);
+				continue;
+			}
+
+			auto source = oldArchetype->columns[oldArchetype->findColumn(column.type)].data;
+			columnType.relocate(destination, source + record.row * columnType.size);
+		}
+		records[*entity - 1] = { newArchetype, newRow };
+	}
+	else
+	{
+		records[*entity - 1] = {};
+	}
+
+	if (oldArchetype)
+	{
+		if (removedType != UINT32_MAX)
+		{
+			const auto& column = oldArchetype->columns[oldArchetype->findColumn(removedType)];
+			const auto& columnType = columnTypes[removedType];
+			columnType.destruct(column.data + record.row * columnType.size);
+		}
+		removeRow(oldArchetype, record.row);
+	}
+
+	#ifndef NDEBUG
+	version++; // Protects from the use after move.
+	#endif
+}
+
+//**********************************************************************************************************************
+void* ArchetypeStorage::add(ID<Entity> entity, uint32_t type)
+{
+	assert(entity);
+	assert(type < columnTypes.size());
+
+	#ifndef NDEBUG
+	if (isChanging)
+		throw EcsmError("Addition of the archetype component inside other add/remove is not allowed.");
+	#endif
+
+	auto index = *entity - 1;
+	if (index >= records.size())
+		records.resize(index + 1);
+
+	auto archetype = records[index].archetype;
+	if (archetype && archetype->findColumn(type) >= 0)
+	{
+		throw EcsmError("Archetype component is already added. ("
+			"type: " + std::to_string(type) + ", entity: " + std::to_string(*entity) + ")");
+	}
+
+	#ifndef NDEBUG
+	isChanging = true;
+	#endif
+
+	moveEntity(entity, getAddArchetype(archetype, type), type, UINT32_MAX);
+
+	#ifndef NDEBUG
+	isChanging = false;
+	#endif
+
+	return getItem(entity, type);
+}
+void ArchetypeStorage::remove(ID<Entity> entity, uint32_t type)
+{
+	assert(entity);
+
+	#ifndef NDEBUG
+	if (isChanging)
+		throw EcsmError("Removal of the archetype component inside other add/remove is not allowed.");
+	#endif
+
+	auto archetype = getArchetype(entity);
+	if (!archetype || archetype->findColumn(type) < 0)
+	{
+		throw EcsmError("Archetype component is not added. ("
+			"type: " + std::to_string(type) + ", entity: " + std::to_string(*entity) + ")");
+	}
+
+	#ifndef NDEBUG
+	isChanging = true;
+	#endif
+
+	auto oldArchetype = records[*entity - 1].archetype;
+	moveEntity(entity, getRemoveArchetype(oldArchetype, type), UINT32_MAX, type);
+
+	#ifndef NDEBUG
+	isChanging = false;
+	#endif
+}
+
+void* ArchetypeStorage::getItem(ID<Entity> entity, uint32_t type) const noexcept
+{
+	assert(entity);
+	auto index = *entity - 1;
+	if (index >= records.size())
+		return nullptr;
+
+	const auto& record = records[index];
+	if (!record.archetype)
+		return nullptr;
+
+	auto column = record.archetype->findColumn(type);
+	if (column < 0)
+		return nullptr;
+	return record.archetype->columns[column].data + record.row * columnTypes[type].size;
+}
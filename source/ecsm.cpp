@@ -13,14 +13,28 @@
 // limitations under the License.
 
 #include "ecsm.hpp"
+#include <chrono>
 
 using namespace ecsm;
 
+static std::atomic<uint64_t> managerInstanceCount = 0;
+// Thread current manager lives in the library translation unit, so all modules share one instance.
+static thread_local Manager* currentInstance = nullptr;
+
 //**********************************************************************************************************************
 ID<Component> System::createComponent(ID<Entity> entity)
 {
 	throw EcsmError("System has no components.");
 }
+void System::createComponents(const ID<Entity>* entities, uint32_t count, ID<Component>* instances)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto instance = createComponent(entities[i]);
+		getComponent(instance)->entity = entities[i];
+		instances[i] = instance;
+	}
+}
 void System::destroyComponent(ID<Component> instance)
 {
 	throw EcsmError("System has no components.");
@@ -29,56 +43,260 @@ void System::copyComponent(View<Component> source, View<Component> destination)
 {
 	throw EcsmError("System has no components.");
 }
+void System::copyComponents(ID<Component> source, const ID<Component>* destinations, uint32_t count)
+{
+	auto sourceView = getComponent(source);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto destinationView = getComponent(destinations[i]);
+		auto entity = destinationView->entity;
+		copyComponent(sourceView, destinationView);
+		destinationView->entity = entity;
+	}
+}
+void System::writeComponents(SnapshotWriter& writer) const
+{
+	throw EcsmError("System components snapshot is not supported. (name: " + getComponentName() + ")");
+}
+void System::readComponents(SnapshotReader& reader)
+{
+	throw EcsmError("System components snapshot is not supported. (name: " + getComponentName() + ")");
+}
 
 const std::string& System::getComponentName() const
 {
 	static const std::string name = "";
 	return name;
 }
-std::type_index System::getComponentType() const
+TypeIndex System::getComponentType() const
+{
+	return getTypeIndex<Component>();
+}
+uint32_t System::getComponentStaticTypeID() const
 {
-	return typeid(Component);
+	return UINT32_MAX;
 }
 View<Component> System::getComponent(ID<Component> instance)
 {
 	return {};
 }
-void System::disposeComponents()
+uint32_t System::getComponentCount() const
+{
+	return UINT32_MAX;
+}
+void System::getComponentEntities(std::vector<ID<Entity>>& entities) const
+{
+	return;
+}
+uint32_t System::disposeComponents(uint32_t maxCount)
+{
+	return 0;
+}
+void System::reserveComponents(uint32_t count)
+{
+	return;
+}
+void System::shrinkComponents()
+{
+	return;
+}
+uint32_t System::getComponentCapacity() const
+{
+	return 0;
+}
+void System::setComponentChangeVersion(uint64_t version)
+{
+	return;
+}
+void System::markComponentChanged(ID<Component> instance)
+{
+	return;
+}
+void System::getChangedEntities(uint64_t sinceVersion, std::vector<ID<Entity>>& entities) const
 {
 	return;
 }
 
 //**********************************************************************************************************************
-bool Entity::destroy()
+bool ComponentAccess::isConflicting(const ComponentAccess& other) const noexcept
+{
+	if (isExclusive || other.isExclusive)
+		return true;
+
+	for (const auto& type : writeComponents)
+	{
+		if (std::find(other.readComponents.begin(), other.readComponents.end(), type) !=
+			other.readComponents.end() || std::find(other.writeComponents.begin(), 
+			other.writeComponents.end(), type) != other.writeComponents.end())
+		{
+			return true;
+		}
+	}
+	for (const auto& type : other.writeComponents)
+	{
+		if (std::find(readComponents.begin(), readComponents.end(), type) != readComponents.end())
+			return true;
+	}
+	return false;
+}
+
+//**********************************************************************************************************************
+Entity::Entity(Entity&& entity) noexcept
+{
+	heapComponents = entity.heapComponents;
+	count = entity.count;
+	capacity = entity.capacity;
+	if (!heapComponents)
+		memcpy(inlineComponents, entity.inlineComponents, count * sizeof(ComponentData));
+	entity.heapComponents = nullptr;
+	entity.count = 0;
+	entity.capacity = inlineCapacity;
+}
+Entity& Entity::operator=(Entity&& entity) noexcept
+{
+	if (this == &entity)
+		return *this;
+
+	if (heapComponents)
+		deallocateComponents(heapComponents, capacity);
+	heapComponents = entity.heapComponents;
+	count = entity.count;
+	capacity = entity.capacity;
+	if (!heapComponents)
+		memcpy(inlineComponents, entity.inlineComponents, count * sizeof(ComponentData));
+	entity.heapComponents = nullptr;
+	entity.count = 0;
+	entity.capacity = inlineCapacity;
+	return *this;
+}
+
+// Heap component array is prefixed with its memory resource, so entity does not store it.
+static constexpr size_t componentsHeaderSize = 
+	std::max(sizeof(std::pmr::memory_resource*), alignof(Entity::ComponentData));
+
+void Entity::deallocateComponents(ComponentData* components, uint32_t capacity) noexcept
 {
-	for (const auto& component : components)
+	auto memory = (uint8_t*)components - componentsHeaderSize;
+	auto memoryResource = *(std::pmr::memory_resource**)memory;
+	memoryResource->deallocate(memory, componentsHeaderSize + capacity * sizeof(ComponentData),
+		alignof(ComponentData));
+}
+void Entity::reallocateComponents(uint32_t capacity, std::pmr::memory_resource* memoryResource)
+{
+	assert(capacity > count);
+	if (heapComponents)
+		memoryResource = *(std::pmr::memory_resource**)((uint8_t*)heapComponents - componentsHeaderSize);
+
+	auto memory = (uint8_t*)memoryResource->allocate(componentsHeaderSize + 
+		capacity * sizeof(ComponentData), alignof(ComponentData));
+	*(std::pmr::memory_resource**)memory = memoryResource;
+	auto newComponents = (ComponentData*)(memory + componentsHeaderSize);
+	std::uninitialized_default_construct_n(newComponents, capacity);
+	memcpy(newComponents, getData(), count * sizeof(ComponentData));
+
+	if (heapComponents)
+		deallocateComponents(heapComponents, this->capacity);
+	heapComponents = newComponents;
+	this->capacity = capacity;
+}
+
+void Entity::reserveComponents(uint32_t capacity, std::pmr::memory_resource* memoryResource)
+{
+	if (capacity > this->capacity)
+		reallocateComponents(capacity, memoryResource);
+}
+bool Entity::addComponent(uint32_t type, System* system, ID<Component> instance, 
+	std::pmr::memory_resource* memoryResource)
+{
+	auto components = getData();
+	auto end = components + count;
+	auto result = std::lower_bound(components, end, type,
+		[](const ComponentData& a, uint32_t b) noexcept { return a.type < b; });
+	if (result != end && result->type == type)
+		return false;
+
+	auto position = (uint32_t)(result - components);
+	if (count == capacity)
 	{
-		auto pair = component.second;
-		pair.first->destroyComponent(pair.second);
+		reallocateComponents(capacity * 2, memoryResource);
+		components = heapComponents;
 	}
-	components.clear();
+
+	if (position < count)
+		memmove(components + position + 1, components + position, (count - position) * sizeof(ComponentData));
+
+	auto& component = components[position];
+	component.system = system;
+	component.instance = instance;
+	component.type = type;
+	component.isGarbage = 0;
+	count++;
+	return true;
+}
+bool Entity::removeComponent(uint32_t type) noexcept
+{
+	auto component = findComponent(type);
+	if (!component)
+		return false;
+
+	auto components = getData();
+	auto position = (uint32_t)(component - components);
+	count--;
+
+	if (position < count)
+		memmove(components + position, components + position + 1, (count - position) * sizeof(ComponentData));
 	return true;
 }
 
+bool Entity::destroy()
+{
+	if (count == 0)
+		return true;
+
+	auto components = getData();
+	auto manager = components[0].system->manager;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const auto& component = components[i];
+		component.system->destroyComponent(component.instance);
+		manager->addGarbageSystem(component.system);
+	}
+	count = 0;
+
+	// Entity slot is kept until its components are disposed by the systems, to not reuse it.
+	return !manager->keepDestroyedEntities;
+}
+
 //**********************************************************************************************************************
-Manager::Manager(bool setSingleton) : Singleton(setSingleton)
+Manager::Manager(bool setSingleton, std::pmr::memory_resource* memoryResource) : Singleton(setSingleton),
+	memoryResource(memoryResource), systems(memoryResource), componentTypes(memoryResource),
+	componentNames(memoryResource), entities(memoryResource), events(memoryResource), eventSlots(memoryResource),
+	orderedEvents(memoryResource), garbageComponents(memoryResource), garbageSystems(memoryResource),
+	addedComponents(memoryResource),
+	removedComponents(memoryResource), batchComponents(memoryResource), staticComponentTypes(memoryResource),
+	staticSystemTypes(memoryResource), queries(memoryResource), typeQueries(memoryResource),
+	instanceIndex(++managerInstanceCount)
 {
-	auto name = "PreInit"; events.emplace(std::move(name), new Event(name));
-	name = "Init"; events.emplace(std::move(name), new Event(name));
-	name = "PostInit"; events.emplace(std::move(name), new Event(name));
-	name = "Update"; events.emplace(std::move(name), new Event(name));
-	name = "PreDeinit"; events.emplace(std::move(name), new Event(name));
-	name = "Deinit"; events.emplace(std::move(name), new Event(name));
-	name = "PostDeinit"; events.emplace(std::move(name), new Event(name));
-	orderedEvents.push_back(events["Update"]);
+	assert(memoryResource);
+
+	preInitEvent = addEvent("PreInit", true)->id;
+	initEvent = addEvent("Init", true)->id;
+	postInitEvent = addEvent("PostInit", true)->id;
+	orderedEvents.push_back(addEvent("Update", true));
+	preDeinitEvent = addEvent("PreDeinit", true)->id;
+	deinitEvent = addEvent("Deinit", true)->id;
+	postDeinitEvent = addEvent("PostDeinit", true)->id;
 }
 Manager::~Manager()
 {
+	auto previousInstance = currentInstance != this ? currentInstance : nullptr;
+	currentInstance = this;
+
 	if (initialized)
 	{
-		runEvent("PreDeinit");
-		runEvent("Deinit");
-		runEvent("PostDeinit");
+		runEvent(preDeinitEvent);
+		runEvent(deinitEvent);
+		runEvent(postDeinitEvent);
 	}
 
 	entities.clear(false);
@@ -92,18 +310,25 @@ Manager::~Manager()
 		delete pair.second;
 	for (const auto& pair : events)
 		delete pair.second;
+	for (auto query : queries)
+		delete query;
 
 	#ifndef NDEBUG
 	isChanging = false;
 	#endif
 
+	currentInstance = previousInstance;
 	unsetSingleton();
 }
 
-void Manager::addSystem(System* system, std::type_index type)
+Manager* Manager::getThreadCurrent() noexcept { return currentInstance; }
+void Manager::setThreadCurrent(Manager* manager) noexcept { currentInstance = manager; }
+
+void Manager::addSystem(System* system, TypeIndex type, uint32_t staticTypeID)
 {
+	system->manager = this;
 	auto componentType = system->getComponentType();
-	if (componentType != typeid(Component))
+	if (componentType != getTypeIndex<Component>())
 	{
 		if (!componentTypes.emplace(componentType, system).second)
 		{
@@ -111,6 +336,16 @@ void Manager::addSystem(System* system, std::type_index type)
 				"componentType: " + typeToString(componentType) + ", "
 				"thisSystem: " + typeToString(type) + ")");
 		}
+		system->componentTypeID = componentTypeCount++;
+		system->setComponentChangeVersion(frameIndex);
+
+		auto staticTypeID = system->getComponentStaticTypeID();
+		if (staticTypeID != UINT32_MAX)
+		{
+			if (staticTypeID >= staticComponentTypes.size())
+				staticComponentTypes.resize(staticTypeID + 1);
+			staticComponentTypes[staticTypeID] = system;
+		}
 	}
 
 	const auto& componentName = system->getComponentName();
@@ -127,17 +362,23 @@ void Manager::addSystem(System* system, std::type_index type)
 	if (!systems.emplace(type, system).second)
 		throw EcsmError("System is already created. (name: " + typeToString(type) + ")");
 
+	if (staticTypeID >= staticSystemTypes.size())
+		staticSystemTypes.resize(staticTypeID + 1);
+	staticSystemTypes[staticTypeID] = system;
+	system->staticTypeID = staticTypeID;
+
 	if (isRunning)
 	{
-		runEvent("PreInit");
-		runEvent("Init");
-		runEvent("PostInit");
+		runEvent(preInitEvent);
+		runEvent(initEvent);
+		runEvent(postInitEvent);
 	}
 }
 
 //**********************************************************************************************************************
-void Manager::destroySystem(std::type_index type)
+void Manager::destroySystem(TypeIndex type)
 {
+	checkWriteAccess();
 	#ifndef NDEBUG
 	if (isChanging)
 		throw EcsmError("Destruction of the system inside other create/destroy is not allowed.");
@@ -148,15 +389,19 @@ void Manager::destroySystem(std::type_index type)
 	if (searchResult == systems.end())
 		throw EcsmError("System is not created. (type: " + typeToString(type) + ")");
 
+	CurrentScope currentScope(this);
 	if (isRunning)
 	{
-		runEvent("PreDeinit");
-		runEvent("Deinit");
-		runEvent("PostDeinit");
+		runEvent(preDeinitEvent);
+		runEvent(deinitEvent);
+		runEvent(postDeinitEvent);
 	}
 
 	auto system = searchResult->second;
 	systems.erase(searchResult);
+	if (system->isGarbageQueued)
+		garbageSystems.erase(std::find(garbageSystems.begin(), garbageSystems.end(), system));
+	staticSystemTypes[system->staticTypeID] = nullptr;
 	
 	const auto& componentName = system->getComponentName();
 	if (!componentName.empty())
@@ -171,7 +416,7 @@ void Manager::destroySystem(std::type_index type)
 	}
 
 	auto componentType = system->getComponentType();
-	if (componentType != typeid(Component))
+	if (componentType != getTypeIndex<Component>())
 	{
 		auto eraseResult = componentTypes.erase(componentType);
 		if (eraseResult != 1)
@@ -180,6 +425,11 @@ void Manager::destroySystem(std::type_index type)
 				"componentType: " + typeToString(componentType) + ", "
 				"systemType: " + typeToString(type) + ")");
 		}
+		destroyQueries(system->componentTypeID);
+
+		auto staticTypeID = system->getComponentStaticTypeID();
+		if (staticTypeID < staticComponentTypes.size())
+			staticComponentTypes[staticTypeID] = nullptr;
 	}
 
 	delete system;
@@ -188,346 +438,1099 @@ void Manager::destroySystem(std::type_index type)
 	isChanging = false;
 	#endif
 }
-bool Manager::tryDestroySystem(std::type_index type)
+bool Manager::tryDestroySystem(TypeIndex type)
 {
-	#ifndef NDEBUG
-	if (isChanging)
-		throw EcsmError("Destruction of the system inside other create/destroy is not allowed.");
-	isChanging = true;
-	#endif
+	if (systems.find(type) == systems.end())
+		return false;
+	destroySystem(type);
+	return true;
+}
 
-	auto result = systems.find(type);
-	if (result != systems.end())
+//**********************************************************************************************************************
+void Manager::destroy(const ID<Entity>* instances, uint32_t count)
+{
+	assert(instances || count == 0);
+	checkWriteAccess();
+	if (!queries.empty())
 	{
-		#ifndef NDEBUG
-		isChanging = false;
-		#endif
-		return false;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (instances[i])
+				removeQueriesEntity(instances[i]);
+		}
 	}
 
-	auto system = result->second;
-	systems.erase(result);
-	delete system;
+	if (trackChanges)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			addRemovedComponents(instances[i]);
+	}
 
-	#ifndef NDEBUG
-	isChanging = false;
-	#endif
-	return true;
+	for (uint32_t i = 0; i < count; i++)
+		entities.destroy(instances[i]);
 }
 
 //**********************************************************************************************************************
-View<Component> Manager::add(ID<Entity> entity, std::type_index componentType)
+View<Component> Manager::addComponent(ID<Entity> entity, System* system, TypeIndex componentType)
 {
 	assert(entity);
+	checkWriteAccess();
+	if (!entities.isValid(entity))
+		throw EcsmError("Stale entity instance. (entity: " + std::to_string(*entity) + ")");
 
-	auto result = componentTypes.find(componentType);
-	if (result == componentTypes.end())
+	if (!system)
 	{
 		throw EcsmError("Component is not registered by any system. ("
 			"type: " + typeToString(componentType) +
 			"entity:" + std::to_string(*entity) + ")");
 	}
+	auto existingComponent = entities.get(entity)->findComponent(system->componentTypeID);
+	if (existingComponent)
+	{
+		if (!existingComponent->isGarbage)
+		{
+			throw EcsmError("Component is already added to the entity. ("
+				"type: " + typeToString(componentType) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		disposeGarbageComponent(entity, componentType);
+	}
 
-	auto system = result->second;
 	auto component = system->createComponent(entity);
 	auto componentView = system->getComponent(component);
 	componentView->entity = entity;
 
 	auto entityView = entities.get(entity);
-	if (!entityView->components.emplace(componentType, std::make_pair(system, component)).second)
+	entityView->addComponent(system->componentTypeID, system, component, memoryResource);
+	updateQueries(entity, system->componentTypeID);
+	if (trackChanges)
+		addedComponents.emplace_back(componentType, entity);
+	return componentView;
+}
+void Manager::addComponents(const ID<Entity>* entities, uint32_t count, System* system, TypeIndex componentType)
+{
+	assert(entities || count == 0);
+	checkWriteAccess();
+	if (count == 0)
+		return;
+
+	if (!system)
 	{
-		throw EcsmError("Component is already added to the entity. ("
+		throw EcsmError("Component is not registered by any system. ("
 			"type: " + typeToString(componentType) +
-			"entity:" + std::to_string(*entity) + ")");
+			"entity:" + std::to_string(*entities[0]) + ")");
 	}
 
-	return componentView;
+	auto componentTypeID = system->componentTypeID;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		assert(entities[i]);
+		if (!this->entities.isValid(entities[i]))
+			throw EcsmError("Stale entity instance. (entity: " + std::to_string(*entities[i]) + ")");
+		auto existingComponent = this->entities.get(entities[i])->findComponent(componentTypeID);
+		if (existingComponent)
+		{
+			if (!existingComponent->isGarbage)
+			{
+				throw EcsmError("Component is already added to the entity. ("
+					"type: " + typeToString(componentType) +
+					"entity:" + std::to_string(*entities[i]) + ")");
+			}
+			disposeGarbageComponent(entities[i], componentType);
+		}
+	}
+
+	batchComponents.resize(count);
+	system->createComponents(entities, count, batchComponents.data());
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto entity = entities[i];
+		if (!this->entities.get(entity)->addComponent(componentTypeID, system, batchComponents[i], memoryResource))
+		{
+			for (uint32_t j = i; j < count; j++) // Duplicate entity, rest of the components are not added.
+				system->destroyComponent(batchComponents[j]);
+			addGarbageSystem(system);
+			throw EcsmError("Component is already added to the entity. ("
+				"type: " + typeToString(componentType) +
+				"entity:" + std::to_string(*entity) + ")");
+		}
+		updateQueries(entity, componentTypeID);
+		if (trackChanges)
+			addedComponents.emplace_back(componentType, entity);
+	}
 }
-void Manager::remove(ID<Entity> entity, std::type_index componentType)
+void Manager::remove(ID<Entity> entity, TypeIndex componentType)
 { 
 	assert(entity);
-	auto entityView = entities.get(entity);
-	const auto& components = entityView->components;
-	auto iterator = components.find(componentType);
+	checkWriteAccess();
+	if (!entities.isValid(entity))
+		throw EcsmError("Stale entity instance. (entity: " + std::to_string(*entity) + ")");
 
-	if (iterator == components.end())
+	auto system = findComponentSystem(componentType);
+	auto component = system ? entities.get(entity)->findComponentData(system->componentTypeID) : nullptr;
+	if (!component)
 	{
 		throw EcsmError("Component is not added. ("
 			"type: " + typeToString(componentType) +
 			"entity:" + std::to_string(*entity) + ")");
 	}
-
-	auto result = garbageComponents.emplace(make_pair(componentType, entity));
-	if (!result.second)
+	if (component->isGarbage)
 	{
 		throw EcsmError("Already removed component. ("
 			"type: " + typeToString(componentType) + 
 			"entity: " + std::to_string(*entity) + ")");
 	}
+
+	component->isGarbage = 1;
+	garbageComponents.emplace_back(componentType, entity);
+	updateQueries(entity, system->componentTypeID);
 }
-void Manager::copy(ID<Entity> source, ID<Entity> destination, std::type_index componentType)
+void Manager::copy(ID<Entity> source, ID<Entity> destination, TypeIndex componentType)
 {
 	assert(source);
 	assert(destination);
+	checkWriteAccess();
 
-	const auto sourceView = entities.get(source);
-	auto destinationView = entities.get(destination);
-	auto sourceIter = sourceView->components.find(componentType);
-	auto destinationIter = destinationView->components.find(componentType);
+	auto sourceComponent = findComponent(source, componentType);
+	auto destinationComponent = findComponent(destination, componentType);
 
-	if (sourceIter == sourceView->components.end())
+	if (!sourceComponent)
 	{
 		throw EcsmError("Source component is not added. ("
 			"type: " + typeToString(componentType) +
 			"entity:" + std::to_string(*source) + ")");
 	}
-	if (destinationIter == destinationView->components.end())
+	if (!destinationComponent)
 	{
 		throw EcsmError("Destination component is not added. ("
 			"type: " + typeToString(componentType) +
 			"entity:" + std::to_string(*destination) + ")");
 	}
 
-	auto system = sourceIter->second.first;
-	auto sourceComponent = system->getComponent(sourceIter->second.second);
-	auto destinationComponent = system->getComponent(destinationIter->second.second);
-	system->copyComponent(sourceComponent, destinationComponent);
+	auto system = sourceComponent->system;
+	auto sourceView = system->getComponent(sourceComponent->instance);
+	auto destinationView = system->getComponent(destinationComponent->instance);
+	system->copyComponent(sourceView, destinationView);
+	destinationView->entity = destination;
+	system->markComponentChanged(destinationComponent->instance);
+}
+
+//**********************************************************************************************************************
+Manager::Prefab Manager::createPrefab(ID<Entity> entity) const
+{
+	assert(entity);
+
+	auto doNotDuplicate = findComponent(entity, getTypeIndex<DoNotDuplicateComponent>());
+	if (doNotDuplicate && !doNotDuplicate->isGarbage)
+		throw EcsmError("Entity should not be duplicated. (entity: " + std::to_string(*entity) + ")");
+
+	Prefab prefab;
+	prefab.entity = entity;
+
+	auto entityView = entities.get(entity);
+	auto components = entityView->getComponents();
+	auto componentCount = entityView->getComponentCount();
+	prefab.components.reserve(componentCount);
+
+	for (uint32_t i = 0; i < componentCount; i++)
+	{
+		if (!components[i].isGarbage)
+			prefab.components.push_back(components[i]);
+	}
+	return prefab;
+}
+void Manager::instantiate(const Prefab& prefab, ID<Entity>* instances, uint32_t count)
+{
+	assert(instances || count == 0);
+	assert(prefab.entity);
+	checkWriteAccess();
+
+	entities.createMany(instances, count);
+	if (count == 0 || prefab.components.empty())
+		return;
+
+	auto componentCount = (uint32_t)prefab.components.size();
+	if (componentCount > Entity::inlineCapacity)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			entities.get(instances[i])->reserveComponents(componentCount, memoryResource);
+	}
+
+	batchComponents.resize(count);
+	for (const auto& component : prefab.components)
+	{
+		auto system = component.system;
+		system->createComponents(instances, count, batchComponents.data());
+		system->copyComponents(component.instance, batchComponents.data(), count);
+
+		for (uint32_t i = 0; i < count; i++) // Prefab components are sorted, so they are appended.
+			entities.get(instances[i])->addComponent(component.type, system, batchComponents[i], memoryResource);
+
+		if (trackChanges)
+		{
+			auto componentType = system->getComponentType();
+			for (uint32_t i = 0; i < count; i++)
+				addedComponents.emplace_back(componentType, instances[i]);
+		}
+	}
+
+	if (!queries.empty())
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			for (const auto& component : prefab.components)
+				updateQueries(instances[i], component.type);
+		}
+	}
 }
 ID<Entity> Manager::duplicate(ID<Entity> entity)
 {
+	checkWriteAccess();
 	auto duplicateEntity = entities.create();
-	auto entityView = entities.get(entity);
-	const auto& components = entityView->components;
+	auto componentCount = entities.get(entity)->count;
 
-	for (const auto& pair : components)
+	for (uint32_t i = 0; i < componentCount; i++)
 	{
-		auto system = pair.second.first;
+		auto component = entities.get(entity)->getData()[i]; // Do not optimize/move getter here!
+		auto system = component.system;
 		auto duplicateComponent = system->createComponent(duplicateEntity);
-		auto sourceView = system->getComponent(pair.second.second);
+		auto sourceView = system->getComponent(component.instance);
 		auto destinationView = system->getComponent(duplicateComponent);
-		destinationView->entity = duplicateEntity;
-
 		system->copyComponent(sourceView, destinationView);
+		destinationView->entity = duplicateEntity;
 
 		auto duplicateView = entities.get(duplicateEntity); // Do not optimize/move getter here!
-		if (!duplicateView->components.emplace(pair.first, std::make_pair(system, duplicateComponent)).second)
+		if (!duplicateView->addComponent(component.type, system, duplicateComponent, memoryResource))
 		{
 			throw EcsmError("Component is already added to the entity. ("
-				"type: " + typeToString(pair.first) +
+				"type: " + typeToString(system->getComponentType()) +
 				"entity:" + std::to_string(*entity) + ")");
 		}
+		if (trackChanges)
+			addedComponents.emplace_back(system->getComponentType(), duplicateEntity);
 	}
 
+	if (!queries.empty())
+	{
+		auto duplicateView = entities.get(duplicateEntity);
+		auto components = duplicateView->getData();
+		for (uint32_t i = 0; i < componentCount; i++)
+			updateQueries(duplicateEntity, components[i].type);
+	}
 	return duplicateEntity;
 }
 
 //**********************************************************************************************************************
-void Manager::registerEvent(const std::string& name)
-{
-	assert(!name.empty());
-	if (!events.emplace(name, new Event(name, false)).second)
-		throw EcsmError("Event is already registered. (name: " + name + ")");
-}
-bool Manager::tryRegisterEvent(const std::string& name)
+Manager::Query& Manager::getQuery(const TypeIndex* includeTypes, uint32_t includeCount,
+	const TypeIndex* excludeTypes, uint32_t excludeCount)
 {
-	assert(!name.empty());
-	return events.emplace(name, new Event(name, false)).second;
-}
+	assert(includeTypes);
+	assert(includeCount > 0);
 
-void Manager::registerEventBefore(const std::string& newEvent, const std::string& beforeEvent)
-{
-	assert(!newEvent.empty());
-	assert(!beforeEvent.empty());
+	constexpr uint32_t maxTypeCount = 32;
+	if (includeCount > maxTypeCount || excludeCount > maxTypeCount)
+		throw EcsmError("Too many query component types. (maxCount: " + std::to_string(maxTypeCount) + ")");
 
-	auto result = events.emplace(newEvent, new Event(newEvent));
-	if (!result.second)
-		throw EcsmError("Event is already registered. (newEvent: " + newEvent + ")");
+	System* includeSystems[maxTypeCount];
+	System* excludeSystems[maxTypeCount];
 
-	for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+	for (uint32_t i = 0; i < includeCount + excludeCount; i++)
 	{
-		if ((*i)->name != beforeEvent)
-			continue;
-		orderedEvents.insert(i, result.first->second);
-		return;
-	}
-
-	throw EcsmError("Before event is not registered. ("
-		"newEvent: " + newEvent + ", beforeEvent: " + beforeEvent + ")");
-}
-void Manager::registerEventAfter(const std::string& newEvent, const std::string& afterEvent)
-{
-	assert(!newEvent.empty());
-	assert(!afterEvent.empty());
+		auto componentType = i < includeCount ? includeTypes[i] : excludeTypes[i - includeCount];
+		auto system = findComponentSystem(componentType);
+		if (!system)
+		{
+			throw EcsmError("Component is not registered by any system. ("
+				"type: " + typeToString(componentType) + ")");
+		}
 
-	auto result = events.emplace(newEvent, new Event(newEvent));
-	if (!result.second)
-		throw EcsmError("Event is already registered. (newEvent: " + newEvent + ")");
+		if (i < includeCount)
+			includeSystems[i] = system;
+		else
+			excludeSystems[i - includeCount] = system;
+	}
 
-	for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+	for (auto query : queries)
 	{
-		if ((*i)->name != afterEvent)
+		if (query->includeSystems.size() != includeCount || query->excludeSystems.size() != excludeCount ||
+			!std::equal(includeSystems, includeSystems + includeCount, query->includeSystems.begin()) ||
+			!std::equal(excludeSystems, excludeSystems + excludeCount, query->excludeSystems.begin()))
+		{
 			continue;
-		orderedEvents.insert(i + 1, result.first->second);
-		return;
+		}
+		return *query;
 	}
 
-	throw EcsmError("After event is not registered. ("
-		"newEvent: " + newEvent + ", afterEvent: " + afterEvent + ")");
-}
+	// Query is created on the first call, it changes query arrays read by the other threads.
+	if (readerCount.load(std::memory_order_relaxed) != 0)
+		throw EcsmError("Query creation inside the read phase is not allowed, call prepareQuery() before it.");
 
-//**********************************************************************************************************************
-void Manager::unregisterEvent(const std::string& name)
-{
-	assert(!name.empty());
-	auto iterator = events.find(name);
-	if (iterator == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
-		
-	auto event = iterator->second;
-	events.erase(iterator);
+	auto query = new Query();
+	query->includeSystems.assign(includeSystems, includeSystems + includeCount);
+	query->excludeSystems.assign(excludeSystems, excludeSystems + excludeCount);
+	query->includeTypes.resize(includeCount);
+	query->excludeTypes.resize(excludeCount);
+	queries.push_back(query);
 
-	if (event->isOrdered)
+	if (typeQueries.size() < componentTypeCount)
+		typeQueries.resize(componentTypeCount);
+
+	System* smallestSystem = nullptr;
+	auto smallestCount = UINT32_MAX;
+
+	for (uint32_t i = 0; i < includeCount; i++)
 	{
-		bool isEventFound = false;
-		for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+		auto system = includeSystems[i];
+		query->includeTypes[i] = system->componentTypeID;
+		typeQueries[system->componentTypeID].push_back(query);
+
+		auto componentCount = system->getComponentCount();
+		if (componentCount < smallestCount)
 		{
-			if (*i != event)
-				continue;
-			orderedEvents.erase(i);
-			isEventFound = true;
-			break;
+			smallestSystem = system;
+			smallestCount = componentCount;
 		}
-
-		if (!isEventFound)
-			throw EcsmError("Ordered event is not found. (name: " + name + ")");
 	}
-		
-	delete event;
-}
-bool Manager::tryUnregisterEvent(const std::string& name)
-{
-	assert(!name.empty());
-	auto iterator = events.find(name);
-	if (iterator == events.end())
-		return false;
+	for (uint32_t i = 0; i < excludeCount; i++)
+	{
+		auto system = excludeSystems[i];
+		query->excludeTypes[i] = system->componentTypeID;
+		typeQueries[system->componentTypeID].push_back(query);
+	}
 
-	auto event = iterator->second;
-	events.erase(iterator);
+	if (smallestSystem)
+	{
+		std::vector<ID<Entity>> candidates;
+		candidates.reserve(smallestCount);
+		smallestSystem->getComponentEntities(candidates);
 
-	if (event->isOrdered)
+		for (auto entity : candidates)
+		{
+			if (!query->isMatch(entity) && isQueryMatch(query, entity))
+				addQueryEntity(query, entity);
+		}
+	}
+	else
 	{
-		bool isEventFound = false;
-		for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+		for (const auto& entityData : entities)
 		{
-			if (*i != event)
-				continue;
-			orderedEvents.erase(i);
-			isEventFound = true;
-			break;
+			auto entity = entities.getID(&entityData);
+			if (isQueryMatch(query, entity))
+				addQueryEntity(query, entity);
 		}
+	}
+
+	return *query;
+}
+
+bool Manager::isQueryMatch(const Query* query, ID<Entity> entity) const noexcept
+{
+	assert(query);
+	assert(entity);
 
-		if (!isEventFound)
+	if (!entities.isLive(entity))
+		return false;
+
+	auto entityView = entities.get(entity);
+	for (auto type : query->includeTypes)
+	{
+		auto component = entityView->findComponent(type);
+		if (!component || component->isGarbage)
+			return false;
+	}
+	for (auto type : query->excludeTypes)
+	{
+		auto component = entityView->findComponent(type);
+		if (component && !component->isGarbage)
 			return false;
 	}
-		
-	delete event;
 	return true;
 }
 
 //**********************************************************************************************************************
-bool Manager::isEventOrdered(const std::string& name) const
-{
-	assert(!name.empty());
-	auto result = events.find(name);
-	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
-	return result->second->isOrdered;
-}
-const Manager::Event::Subscribers& Manager::getEventSubscribers(const std::string& name) const
+void Manager::addQueryEntity(Query* query, ID<Entity> entity)
 {
-	assert(!name.empty());
+	assert(query);
+	assert(entity);
+
+	#ifndef NDEBUG
+	if (query->isIterating)
+		throw EcsmError("Addition of the query entity inside query iteration is not allowed.");
+	#endif
+
+	auto index = *entity - 1;
+	if (index >= query->positions.size())
+		query->positions.resize(index + 1, UINT32_MAX);
+	query->positions[index] = (uint32_t)query->entities.size();
+	query->entities.push_back(entity);
+
+	auto entityView = entities.get(entity);
+	for (auto type : query->includeTypes)
+	{
+		auto component = entityView->findComponent(type);
+		assert(component);
+		query->components.push_back(component->instance);
+	}
+}
+void Manager::removeQueryEntity(Query* query, ID<Entity> entity)
+{
+	assert(query);
+	assert(entity);
+
+	#ifndef NDEBUG
+	if (query->isIterating)
+		throw EcsmError("Removal of the query entity inside query iteration is not allowed.");
+	#endif
+
+	auto index = *entity - 1;
+	auto position = query->positions[index];
+	auto lastPosition = (uint32_t)query->entities.size() - 1;
+	auto typeCount = query->includeTypes.size();
+
+	if (position != lastPosition)
+	{
+		auto lastEntity = query->entities[lastPosition];
+		query->entities[position] = lastEntity;
+		query->positions[*lastEntity - 1] = position;
+
+		auto components = query->components.data();
+		for (size_t i = 0; i < typeCount; i++)
+			components[position * typeCount + i] = components[lastPosition * typeCount + i];
+	}
+
+	query->positions[index] = UINT32_MAX;
+	query->entities.pop_back();
+	query->components.resize(query->components.size() - typeCount);
+}
+
+//**********************************************************************************************************************
+void Manager::updateQueries(ID<Entity> entity, uint32_t componentType)
+{
+	if (componentType >= typeQueries.size())
+		return;
+
+	for (auto query : typeQueries[componentType])
+	{
+		auto isMatch = isQueryMatch(query, entity);
+		if (isMatch == query->isMatch(entity))
+			continue;
+
+		if (isMatch)
+			addQueryEntity(query, entity);
+		else
+			removeQueryEntity(query, entity);
+	}
+}
+void Manager::removeQueriesEntity(ID<Entity> entity)
+{
+	for (auto query : queries)
+	{
+		if (query->isMatch(entity))
+			removeQueryEntity(query, entity);
+	}
+}
+void Manager::destroyQueries(uint32_t componentType)
+{
+	if (componentType >= typeQueries.size() || typeQueries[componentType].empty())
+		return;
+
+	auto destroyedQueries = std::move(typeQueries[componentType]);
+	typeQueries[componentType].clear();
+
+	for (auto query : destroyedQueries)
+	{
+		for (auto& otherQueries : typeQueries)
+		{
+			auto result = std::find(otherQueries.begin(), otherQueries.end(), query);
+			if (result != otherQueries.end())
+				otherQueries.erase(result);
+		}
+
+		queries.erase(std::find(queries.begin(), queries.end(), query));
+		delete query;
+	}
+}
+
+//**********************************************************************************************************************
+Manager::Event* Manager::addEvent(std::string_view name, bool isOrdered)
+{
+	assert(!name.empty());
+	if (events.find(name) != events.end())
+		return nullptr;
+
+	auto event = new Event(name, isOrdered);
+	eventSlots.push_back(event);
+	*event->id = (uint32_t)eventSlots.size();
+	events.emplace(event->name, event); // Key is pointing to the event name memory.
+	return event;
+}
+void Manager::removeEvent(Event* event)
+{
+	eventSlots[*event->id - 1] = nullptr;
+	events.erase(event->name);
+	delete event;
+}
+
+ID<Manager::Event> Manager::registerEvent(std::string_view name)
+{
+	auto event = addEvent(name, false);
+	if (!event)
+		throw EcsmError("Event is already registered. (name: " + std::string(name) + ")");
+	return event->id;
+}
+bool Manager::tryRegisterEvent(std::string_view name)
+{
+	return addEvent(name, false);
+}
+
+ID<Manager::Event> Manager::registerEventBefore(std::string_view newEvent, std::string_view beforeEvent)
+{
+	assert(!beforeEvent.empty());
+	auto event = addEvent(newEvent, true);
+	if (!event)
+		throw EcsmError("Event is already registered. (newEvent: " + std::string(newEvent) + ")");
+
+	for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+	{
+		if ((*i)->name != beforeEvent)
+			continue;
+		orderedEvents.insert(i, event);
+		isScheduleDirty = true;
+		return event->id;
+	}
+
+	removeEvent(event);
+	throw EcsmError("Before event is not registered. ("
+		"newEvent: " + std::string(newEvent) + ", beforeEvent: " + std::string(beforeEvent) + ")");
+}
+ID<Manager::Event> Manager::registerEventAfter(std::string_view newEvent, std::string_view afterEvent)
+{
+	assert(!afterEvent.empty());
+	auto event = addEvent(newEvent, true);
+	if (!event)
+		throw EcsmError("Event is already registered. (newEvent: " + std::string(newEvent) + ")");
+
+	for (auto i = orderedEvents.begin(); i != orderedEvents.end(); i++)
+	{
+		if ((*i)->name != afterEvent)
+			continue;
+		orderedEvents.insert(i + 1, event);
+		isScheduleDirty = true;
+		return event->id;
+	}
+
+	removeEvent(event);
+	throw EcsmError("After event is not registered. ("
+		"newEvent: " + std::string(newEvent) + ", afterEvent: " + std::string(afterEvent) + ")");
+}
+
+//**********************************************************************************************************************
+void Manager::unregisterEvent(std::string_view name)
+{
+	assert(!name.empty());
+	auto iterator = events.find(name);
+	if (iterator == events.end())
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
+		
+	auto event = iterator->second;
+	if (event->isOrdered)
+	{
+		auto result = std::find(orderedEvents.begin(), orderedEvents.end(), event);
+		if (result != orderedEvents.end())
+		{
+			orderedEvents.erase(result);
+			isScheduleDirty = true;
+		}
+	}
+		
+	removeEvent(event);
+}
+bool Manager::tryUnregisterEvent(std::string_view name)
+{
+	assert(!name.empty());
+	auto iterator = events.find(name);
+	if (iterator == events.end())
+		return false;
+
+	auto event = iterator->second;
+	if (event->isOrdered)
+	{
+		auto result = std::find(orderedEvents.begin(), orderedEvents.end(), event);
+		if (result != orderedEvents.end())
+		{
+			orderedEvents.erase(result);
+			isScheduleDirty = true;
+		}
+	}
+		
+	removeEvent(event);
+	return true;
+}
+
+//**********************************************************************************************************************
+bool Manager::isEventOrdered(std::string_view name) const
+{
+	assert(!name.empty());
 	auto result = events.find(name);
 	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
+	return result->second->isOrdered;
+}
+const Manager::Event::Subscribers& Manager::getEventSubscribers(std::string_view name) const
+{
+	assert(!name.empty());
+	auto result = events.find(name);
+	if (result == events.end())
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
 	return result->second->subscribers;
 }
-bool Manager::isEventHasSubscribers(const std::string& name) const
+bool Manager::isEventHasSubscribers(std::string_view name) const
 {
 	assert(!name.empty());
 	auto result = events.find(name);
 	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
 	return !result->second->subscribers.empty();
 }
 
 //**********************************************************************************************************************
-void Manager::runEvent(const std::string& name)
+void Manager::runEvent(std::string_view name)
 {
 	assert(!name.empty());
 	auto result = events.find(name);
 	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
 
-	const auto& subscribers = result->second->subscribers;
-	for (const auto& onEvent : subscribers)
-		onEvent();
+	runSubscribers(result->second);
 }
-bool Manager::tryRunEvent(const std::string& name)
+bool Manager::tryRunEvent(std::string_view name)
 {
 	assert(!name.empty());
 	auto result = events.find(name);
 	if (result == events.end())
 		return false;
 
-	const auto& subscribers = result->second->subscribers;
-	for (const auto& onEvent : subscribers)
-		onEvent();
+	runSubscribers(result->second);
 	return true;
 }
 void Manager::runOrderedEvents()
 {
 	for (auto event : orderedEvents)
+		runSubscribers(event);
+}
+
+void Manager::runSubscribers(const Event* event)
+{
+	CurrentScope currentScope(this);
+	if (!profiler)
+	{
+		runEventSubscribers(event);
+		return;
+	}
+
+	auto beginTime = profiler->getTime();
+	runEventSubscribers(event);
+	profiler->addSample(event->name, "Event", beginTime, profiler->getTime());
+}
+void Manager::runSubscriber(const Event* event, uint32_t index)
+{
+	if (!profiler)
+	{
+		event->subscribers[index]();
+		return;
+	}
+
+	auto beginTime = profiler->getTime();
+	event->subscribers[index]();
+	profiler->addSample(event->name + " #" + std::to_string(index), "Subscriber", beginTime, profiler->getTime());
+}
+void Manager::runEventSubscribers(const Event* event)
+{
+	const auto& subscribers = event->subscribers;
+	if (!threadPool)
+	{
+		for (uint32_t i = 0; i < (uint32_t)subscribers.size(); i++)
+			runSubscriber(event, i);
+		return;
+	}
+
+	// Groups consecutive non-conflicting subscribers, conflicting ones are still executed in the subscription order.
+	const auto& accesses = event->accesses;
+	auto subscriberCount = (uint32_t)subscribers.size();
+	uint32_t batchBegin = 0;
+
+	while (batchBegin < subscriberCount)
+	{
+		auto batchEnd = batchBegin + 1;
+		if (!accesses[batchBegin].isExclusive)
+		{
+			for (; batchEnd < subscriberCount; batchEnd++)
+			{
+				const auto& access = accesses[batchEnd];
+				auto isConflicting = false;
+				for (uint32_t i = batchBegin; i < batchEnd; i++)
+				{
+					if (!access.isConflicting(accesses[i]))
+						continue;
+					isConflicting = true;
+					break;
+				}
+
+				if (isConflicting)
+					break;
+			}
+		}
+
+		if (batchEnd - batchBegin == 1)
+		{
+			runSubscriber(event, batchBegin);
+		}
+		else
+		{
+			threadPool->parallelFor(batchEnd - batchBegin, [this, event, batchBegin](uint32_t begin, uint32_t end)
+			{
+				CurrentScope currentScope(this);
+				for (uint32_t i = begin; i < end; i++)
+					runSubscriber(event, batchBegin + i);
+			}, 1);
+		}
+
+		batchBegin = batchEnd;
+	}
+}
+
+//**********************************************************************************************************************
+void Manager::buildSchedule()
+{
+	scheduleNodes.clear();
+	scheduleEdges.clear();
+	scheduleOrder.clear();
+
+	for (auto event : orderedEvents)
+	{
+		auto subscriberCount = (uint32_t)event->subscribers.size();
+		for (uint32_t i = 0; i < subscriberCount; i++)
+		{
+			ScheduleNode node;
+			node.event = event;
+			node.subscriber = i;
+			scheduleNodes.push_back(std::move(node));
+		}
+	}
+
+	auto nodeCount = (uint32_t)scheduleNodes.size();
+	auto addEdge = [this](uint32_t from, uint32_t to, std::string&& reason)
+	{
+		if (from == UINT32_MAX || from == to)
+			return;
+		auto& successors = scheduleNodes[from].successors;
+		if (std::find(successors.begin(), successors.end(), to) != successors.end())
+			return;
+		successors.push_back(to);
+		scheduleNodes[to].dependencyCount++;
+		scheduleEdges.push_back({ from, to, std::move(reason) });
+	};
+
+	struct ComponentState final
+	{
+		uint32_t lastWriter = UINT32_MAX;
+		std::vector<uint32_t> readers;
+	};
+
+	// Each subscriber depends only on the last writer and the readers after it, remaining order is transitive.
+	std::unordered_map<TypeIndex, ComponentState> componentStates;
+	std::unordered_map<TypeIndex, std::vector<uint32_t>> systemNodes;
+	std::vector<uint32_t> sharedNodes;
+	auto lastExclusive = UINT32_MAX;
+
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		const auto& node = scheduleNodes[i];
+		const auto& access = node.event->accesses[node.subscriber];
+		if (access.system != getTypeIndex<System>())
+			systemNodes[access.system].push_back(i);
+
+		if (access.isExclusive)
+		{
+			if (lastExclusive != UINT32_MAX && sharedNodes.empty())
+				addEdge(lastExclusive, i, "exclusive");
+			for (auto sharedNode : sharedNodes)
+				addEdge(sharedNode, i, "exclusive");
+
+			componentStates.clear();
+			sharedNodes.clear();
+			lastExclusive = i;
+			continue;
+		}
+
+		addEdge(lastExclusive, i, "exclusive");
+		for (const auto& type : access.readComponents)
+		{
+			auto& state = componentStates[type];
+			addEdge(state.lastWriter, i, "read " + typeToString(type));
+		}
+		for (const auto& type : access.writeComponents)
+		{
+			auto& state = componentStates[type];
+			addEdge(state.lastWriter, i, "write " + typeToString(type));
+			for (auto reader : state.readers)
+				addEdge(reader, i, "write " + typeToString(type));
+		}
+
+		for (const auto& type : access.readComponents)
+			componentStates[type].readers.push_back(i);
+		for (const auto& type : access.writeComponents)
+		{
+			auto& state = componentStates[type];
+			state.lastWriter = i;
+			state.readers.clear();
+		}
+		sharedNodes.push_back(i);
+	}
+
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		const auto& node = scheduleNodes[i];
+		const auto& access = node.event->accesses[node.subscriber];
+		for (const auto& system : access.afterSystems)
+		{
+			auto result = systemNodes.find(system);
+			if (result == systemNodes.end())
+				continue;
+			for (auto dependency : result->second)
+				addEdge(dependency, i, "after " + typeToString(system));
+		}
+	}
+
+	// Kahn topological sort, ready nodes are taken in the subscription order to keep sequential semantics.
+	std::vector<uint32_t> dependencyCounts(nodeCount);
+	std::vector<uint32_t> readyNodes;
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		dependencyCounts[i] = scheduleNodes[i].dependencyCount;
+		if (dependencyCounts[i] == 0)
+			readyNodes.push_back(i);
+	}
+	std::make_heap(readyNodes.begin(), readyNodes.end(), std::greater<uint32_t>());
+
+	scheduleOrder.reserve(nodeCount);
+	while (!readyNodes.empty())
+	{
+		std::pop_heap(readyNodes.begin(), readyNodes.end(), std::greater<uint32_t>());
+		auto node = readyNodes.back();
+		readyNodes.pop_back();
+		scheduleOrder.push_back(node);
+
+		for (auto successor : scheduleNodes[node].successors)
+		{
+			if (--dependencyCounts[successor] > 0)
+				continue;
+			readyNodes.push_back(successor);
+			std::push_heap(readyNodes.begin(), readyNodes.end(), std::greater<uint32_t>());
+		}
+	}
+
+	if (scheduleOrder.size() != nodeCount)
+	{
+		scheduleNodes.clear();
+		scheduleEdges.clear();
+		scheduleOrder.clear();
+		throw EcsmError("Schedule graph has dependency cycle.");
+	}
+
+	scheduleCounters = std::make_unique<std::atomic<uint32_t>[]>(nodeCount);
+	isScheduleDirty = false;
+}
+
+void Manager::runScheduleNode(uint32_t node)
+{
+	auto& scheduleNode = scheduleNodes[node];
+	CurrentScope currentScope(this);
+	auto startTime = std::chrono::steady_clock::now();
+	scheduleNode.event->subscribers[scheduleNode.subscriber]();
+	auto elapsedTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime);
+
+	auto cost = elapsedTime.count();
+	scheduleNode.cost = scheduleNode.cost == 0.0 ? cost : scheduleNode.cost * 0.9 + cost * 0.1;
+
+	if (profiler)
+	{
+		auto endTime = profiler->getTime();
+		profiler->addSample(scheduleNode.event->name + " #" + std::to_string(scheduleNode.subscriber),
+			"Subscriber", endTime - (Profiler::Time)cost, endTime);
+	}
+}
+void Manager::runSchedule()
+{
+	if (isScheduleDirty)
+		buildSchedule();
+
+	if (!threadPool)
+	{
+		for (auto node : scheduleOrder)
+			runScheduleNode(node);
+		return;
+	}
+
+	auto nodeCount = (uint32_t)scheduleNodes.size();
+	for (auto i = scheduleOrder.rbegin(); i != scheduleOrder.rend(); i++)
+	{
+		auto& node = scheduleNodes[*i];
+		auto successorPriority = 0.0;
+		for (auto successor : node.successors)
+			successorPriority = std::max(successorPriority, scheduleNodes[successor].priority);
+		node.priority = std::max(node.cost, 1.0) + successorPriority;
+	}
+
+	std::mutex readyMutex;
+	std::vector<uint32_t> readyNodes;
+	ThreadPool::TaskGroup group;
+
+	auto isLowerPriority = [this](uint32_t a, uint32_t b)
+	{
+		return scheduleNodes[a].priority < scheduleNodes[b].priority;
+	};
+
+	// Each ready node spawns one task, and each task runs the highest priority ready node. (Critical path first)
+	std::function<void(uint32_t)> pushReadyNode = [&](uint32_t node)
+	{
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			readyNodes.push_back(node);
+			std::push_heap(readyNodes.begin(), readyNodes.end(), isLowerPriority);
+		}
+
+		threadPool->addTask([&]()
+		{
+			uint32_t readyNode;
+			{
+				std::lock_guard<std::mutex> lock(readyMutex);
+				std::pop_heap(readyNodes.begin(), readyNodes.end(), isLowerPriority);
+				readyNode = readyNodes.back();
+				readyNodes.pop_back();
+			}
+
+			runScheduleNode(readyNode);
+
+			for (auto successor : scheduleNodes[readyNode].successors)
+			{
+				if (scheduleCounters[successor].fetch_sub(1) == 1)
+					pushReadyNode(successor);
+			}
+		}, group);
+	};
+
+	for (uint32_t i = 0; i < nodeCount; i++)
+		scheduleCounters[i].store(scheduleNodes[i].dependencyCount);
+	for (uint32_t i = 0; i < nodeCount; i++)
+	{
+		if (scheduleNodes[i].dependencyCount == 0)
+			pushReadyNode(i);
+	}
+
+	threadPool->wait(group);
+}
+
+std::string Manager::getScheduleGraph()
+{
+	if (isScheduleDirty)
+		buildSchedule();
+
+	std::string graph = "digraph Schedule {\n";
+	for (uint32_t i = 0; i < (uint32_t)scheduleNodes.size(); i++)
+	{
+		const auto& node = scheduleNodes[i];
+		const auto& access = node.event->accesses[node.subscriber];
+		graph += "\tn" + std::to_string(i) + " [label=\"" + node.event->name + 
+			" #" + std::to_string(node.subscriber);
+		if (access.system != getTypeIndex<System>())
+			graph += "\\n" + typeToString(access.system);
+		if (access.isExclusive)
+			graph += "\\n(exclusive)";
+		graph += "\\ncost: " + std::to_string((uint64_t)node.cost) + " ns\"];\n";
+	}
+	for (const auto& edge : scheduleEdges)
+	{
+		graph += "\tn" + std::to_string(edge.from) + " -> n" + std::to_string(edge.to) + 
+			" [label=\"" + edge.reason + "\"];\n";
+	}
+	graph += "}\n";
+	return graph;
+}
+
+//**********************************************************************************************************************
+void Manager::addSubscriber(Event* event, Delegate onEvent, const ComponentAccess& access)
+{
+	event->subscribers.push_back(onEvent);
+	event->accesses.push_back(access);
+	isScheduleDirty = true;
+}
+bool Manager::removeSubscriber(Event* event, Delegate onEvent)
+{
+	auto& subscribers = event->subscribers;
+	auto result = std::find(subscribers.begin(), subscribers.end(), onEvent);
+	if (result == subscribers.end())
+		return false;
+
+	auto& accesses = event->accesses;
+	accesses.erase(accesses.begin() + (result - subscribers.begin()));
+	subscribers.erase(result);
+
+	auto& functions = event->functions;
+	for (auto i = functions.begin(); i != functions.end(); i++)
 	{
-		const auto& subscribers = event->subscribers;
-		for (const auto& onEvent : subscribers)
-			onEvent();
+		if (i->get() != onEvent.getInstance())
+			continue;
+		functions.erase(i);
+		break;
 	}
+
+	isScheduleDirty = true;
+	return true;
 }
 
 //**********************************************************************************************************************
-void Manager::subscribeToEvent(const std::string& name, const std::function<void()>& onEvent)
+void Manager::subscribeToEvent(std::string_view name, Delegate onEvent, const ComponentAccess& access)
 {
 	assert(!name.empty());
 	assert(onEvent);
 
 	auto result = events.find(name);
 	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
-	result->second->subscribers.push_back(onEvent);
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
+	addSubscriber(result->second, onEvent, access);
 }
-void Manager::unsubscribeFromEvent(const std::string& name, const std::function<void()>& onEvent)
+Delegate Manager::subscribeToEvent(std::string_view name, 
+	const std::function<void()>& onEvent, const ComponentAccess& access)
 {
 	assert(!name.empty());
 	assert(onEvent);
 
 	auto result = events.find(name);
 	if (result == events.end())
-		throw EcsmError("Event is not registered. (name: " + name + ")");
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
 
-	auto& subscribers = result->second->subscribers;
-	for (auto i = subscribers.begin(); i != subscribers.end(); i++)
-	{
-		if (i->target_type() != onEvent.target_type())
-			continue;
-		subscribers.erase(i);
-		return;
-	}
+	auto event = result->second;
+	auto function = event->functions.emplace_back(std::make_unique<std::function<void()>>(onEvent)).get();
+	auto delegate = Delegate::create<&std::function<void()>::operator()>(function);
+	addSubscriber(event, delegate, access);
+	return delegate;
+}
+void Manager::unsubscribeFromEvent(std::string_view name, Delegate onEvent)
+{
+	assert(!name.empty());
+	assert(onEvent);
 
-	throw EcsmError("Event subscriber not found. (name: " + name + ")");
+	auto result = events.find(name);
+	if (result == events.end())
+		throw EcsmError("Event is not registered. (name: " + std::string(name) + ")");
+	if (!removeSubscriber(result->second, onEvent))
+		throw EcsmError("Event subscriber not found. (name: " + std::string(name) + ")");
 }
 
 //**********************************************************************************************************************
-bool Manager::trySubscribeToEvent(const std::string& name, const std::function<void()>& onEvent)
+bool Manager::trySubscribeToEvent(std::string_view name, Delegate onEvent, const ComponentAccess& access)
 {
 	assert(!name.empty());
 	assert(onEvent);
@@ -536,10 +1539,10 @@ bool Manager::trySubscribeToEvent(const std::string& name, const std::function<v
 	if (result == events.end())
 		return false;
 
-	result->second->subscribers.push_back(onEvent);
+	addSubscriber(result->second, onEvent, access);
 	return true;
 }
-bool Manager::tryUnsubscribeFromEvent(const std::string& name, const std::function<void()>& onEvent)
+bool Manager::tryUnsubscribeFromEvent(std::string_view name, Delegate onEvent)
 {
 	assert(!name.empty());
 	assert(onEvent);
@@ -547,17 +1550,7 @@ bool Manager::tryUnsubscribeFromEvent(const std::string& name, const std::functi
 	auto result = events.find(name);
 	if (result == events.end())
 		return false;
-
-	auto& subscribers = result->second->subscribers;
-	for (auto i = subscribers.begin(); i != subscribers.end(); i++)
-	{
-		if (i->target_type() != onEvent.target_type())
-			continue;
-		subscribers.erase(i);
-		return true;
-	}
-
-	return false;
+	return removeSubscriber(result->second, onEvent);
 }
 
 //**********************************************************************************************************************
@@ -566,9 +1559,9 @@ void Manager::initialize()
 	if (initialized)
 		throw EcsmError("Manager is already initialized.");
 
-	runEvent("PreInit");
-	runEvent("Init");
-	runEvent("PostInit");
+	runEvent(preInitEvent);
+	runEvent(initEvent);
+	runEvent(postInitEvent);
 	initialized = true;
 }
 
@@ -577,10 +1570,70 @@ void Manager::update()
 	if (!initialized)
 		throw EcsmError("Manager is not initialized.");
 
-	runOrderedEvents();
-	disposeGarbageComponents();
-	disposeEntities();
-	disposeSystemComponents();
+	CurrentScope currentScope(this);
+	if (!profiler)
+	{
+		if (scheduleEnabled)
+			runSchedule();
+		else
+			runOrderedEvents();
+		executeCommands();
+		disposeGarbage(disposeCountBudget, disposeTimeBudget);
+		advanceFrame();
+		return;
+	}
+
+	auto frameBeginTime = profiler->getTime();
+	auto beginTime = frameBeginTime;
+	auto endPhase = [this, &beginTime](const char* name)
+	{
+		auto endTime = profiler->getTime();
+		profiler->addSample(name, "Manager", beginTime, endTime);
+		beginTime = endTime;
+	};
+
+	if (scheduleEnabled)
+		runSchedule();
+	else
+		runOrderedEvents();
+	endPhase("Run Events");
+	executeCommands();
+	endPhase("Execute Commands");
+	if (disposeCountBudget == 0 && disposeTimeBudget == 0)
+	{
+		disposeGarbageComponents();
+		endPhase("Dispose Garbage Components");
+		disposeEntities();
+		endPhase("Dispose Entities");
+		disposeSystemComponents();
+		endPhase("Dispose System Components");
+	}
+	else
+	{
+		disposeGarbage(disposeCountBudget, disposeTimeBudget);
+		endPhase("Dispose Garbage");
+	}
+
+	profiler->addSample("Frame", "Manager", frameBeginTime, profiler->getTime());
+	addPoolCounters();
+	advanceFrame();
+}
+void Manager::advanceFrame()
+{
+	frameIndex++;
+	for (const auto& pair : componentTypes)
+		pair.second->setComponentChangeVersion(frameIndex);
+}
+void Manager::addPoolCounters()
+{
+	auto time = profiler->getTime();
+	profiler->addCounter("Entities", time, entities.getCount(), entities.getCapacity());
+	for (const auto& pair : componentTypes)
+	{
+		auto system = pair.second;
+		profiler->addCounter(typeToString(pair.first), time,
+			system->getComponentCount(), system->getComponentCapacity());
+	}
 }
 void Manager::start()
 {
@@ -593,24 +1646,442 @@ void Manager::start()
 		update();
 }
 
+void Manager::disposeGarbageComponent(const GarbageComponent& garbageComponent)
+{
+	auto system = findComponentSystem(garbageComponent.first);
+	assert(system); // Corrupted system destruction order.
+	auto entityView = entities.get(garbageComponent.second);
+	auto component = entityView->findComponent(system->componentTypeID);
+	assert(component); // Corrupted entity component destruction order.
+	system->destroyComponent(component->instance);
+	entityView->removeComponent(system->componentTypeID);
+	addGarbageSystem(system);
+	if (trackChanges)
+		removedComponents.push_back(garbageComponent);
+}
+void Manager::disposeGarbageComponent(ID<Entity> entity, TypeIndex componentType)
+{
+	// Removed component is still waiting for the dispose, for example with dispose budget.
+	auto result = std::find(garbageComponents.begin(), garbageComponents.end(), GarbageComponent(componentType, entity));
+	assert(result != garbageComponents.end()); // Corrupted garbage component state.
+	auto garbageComponent = *result;
+	garbageComponents.erase(result);
+	disposeGarbageComponent(garbageComponent);
+}
 void Manager::disposeGarbageComponents()
 {
-	for (const auto& garbagePair : garbageComponents)
+	checkWriteAccess();
+	for (size_t i = 0; i < garbageComponents.size(); i++)
 	{
-		auto entityView = entities.get(garbagePair.second);
-		auto& components = entityView->components;
-		auto iterator = components.find(garbagePair.first);
-		assert(iterator != components.end()); // Corrupted entity component destruction order.
-		auto pair = iterator->second;
-		pair.first->destroyComponent(pair.second);
-		components.erase(iterator);
+		auto garbageComponent = garbageComponents[i]; // Do not use reference, array can be reallocated!
+		disposeGarbageComponent(garbageComponent);
 	}
 	garbageComponents.clear();
 }
 void Manager::disposeSystemComponents()
 {
+	checkWriteAccess();
+
+	// Systems which kept some garbage are queued again, they are disposed on the next call.
+	auto systemCount = garbageSystems.size();
+	for (size_t i = 0; i < systemCount; i++)
+	{
+		auto system = garbageSystems[i];
+		system->isGarbageQueued = false;
+		system->disposeComponents(UINT32_MAX);
+	}
+	garbageSystems.erase(garbageSystems.begin(), garbageSystems.begin() + systemCount);
+}
+bool Manager::disposeGarbage(uint32_t maxCount, int64_t maxTime)
+{
+	checkWriteAccess();
+	if (maxCount == 0 && maxTime == 0)
+	{
+		disposeGarbageComponents();
+		entities.dispose();
+		disposeSystemComponents();
+		return !hasPendingGarbage();
+	}
+
+	static constexpr uint32_t batchSize = 64;
+	auto endTime = std::chrono::steady_clock::now() + std::chrono::nanoseconds(maxTime);
+	auto countBudget = maxCount > 0 ? maxCount : UINT32_MAX;
+	auto isOverBudget = [&]()
+	{
+		return countBudget == 0 || (maxTime > 0 && std::chrono::steady_clock::now() >= endTime);
+	};
+
+	size_t disposedCount = 0;
+	while (disposedCount < garbageComponents.size())
+	{
+		auto garbageComponent = garbageComponents[disposedCount++]; // Do not use reference, array can be reallocated!
+		disposeGarbageComponent(garbageComponent);
+		countBudget--;
+		if (isOverBudget())
+			break;
+	}
+	garbageComponents.erase(garbageComponents.begin(), garbageComponents.begin() + disposedCount);
+
+	// Entity destruction disposes all its components, including garbage ones, so remove them first.
+	keepDestroyedEntities = true;
+	while (true)
+	{
+		// Systems which are over the budget or kept some garbage are queued again by themselves.
+		auto systemCount = garbageSystems.size();
+		size_t systemIndex = 0;
+		while (systemIndex < systemCount && !isOverBudget())
+		{
+			auto system = garbageSystems[systemIndex++];
+			system->isGarbageQueued = false;
+
+			while (true)
+			{
+				auto disposeCount = maxTime > 0 ? std::min(countBudget, batchSize) : countBudget;
+				auto systemDisposedCount = system->disposeComponents(disposeCount);
+				countBudget -= systemDisposedCount;
+				if (systemDisposedCount < disposeCount || isOverBudget())
+					break;
+			}
+		}
+		garbageSystems.erase(garbageSystems.begin(), garbageSystems.begin() + systemIndex);
+
+		if (!garbageComponents.empty() || !garbageSystems.empty() ||
+			entities.getCount() == entities.getLiveCount() || isOverBudget())
+		{
+			break;
+		}
+
+		// Destroyed entity components are queued to the systems, and entity slot is freed on the next pass.
+		while (garbageSystems.empty() && entities.getCount() != entities.getLiveCount() && !isOverBudget())
+		{
+			auto disposeCount = std::min(countBudget, batchSize);
+			entities.dispose(disposeCount);
+			countBudget -= disposeCount;
+		}
+	}
+	keepDestroyedEntities = false;
+
+	return !hasPendingGarbage();
+}
+
+//**********************************************************************************************************************
+Manager::CommandBuffer& Manager::getCommandBuffer()
+{
+	struct CachedBuffer final
+	{
+		uint64_t managerIndex = 0;
+		CommandBuffer* buffer = nullptr;
+	};
+	thread_local CachedBuffer cachedBuffer; // Manager index is unique, so destroyed manager is never matched.
+
+	if (cachedBuffer.managerIndex == instanceIndex)
+		return *cachedBuffer.buffer;
+
+	auto threadID = std::this_thread::get_id();
+	std::lock_guard lock(commandBufferLocker);
+
+	CommandBuffer* buffer = nullptr;
+	for (const auto& commandBuffer : commandBuffers)
+	{
+		if (commandBuffer->threadID == threadID)
+		{
+			buffer = commandBuffer.get();
+			break;
+		}
+	}
+
+	if (!buffer)
+	{
+		commandBuffers.emplace_back(new CommandBuffer(threadID));
+		buffer = commandBuffers.back().get();
+	}
+
+	cachedBuffer.managerIndex = instanceIndex;
+	cachedBuffer.buffer = buffer;
+	return *buffer;
+}
+
+//**********************************************************************************************************************
+void Manager::executeCommands()
+{
+	checkWriteAccess();
+	uint32_t commandCount = 0, createdCount = 0;
+	for (const auto& buffer : commandBuffers)
+	{
+		commandCount += (uint32_t)buffer->commands.size();
+		createdCount += buffer->createdCount;
+	}
+	if (commandCount == 0)
+		return;
+
+	commandOrder.clear();
+	commandOrder.reserve(commandCount);
+
+	auto bufferCount = (uint32_t)commandBuffers.size();
+	for (uint32_t i = 0; i < bufferCount; i++)
+	{
+		auto count = (uint32_t)commandBuffers[i]->commands.size();
+		for (uint32_t j = 0; j < count; j++)
+			commandOrder.emplace_back(i, j);
+	}
+
+	std::stable_sort(commandOrder.begin(), commandOrder.end(), 
+		[this](std::pair<uint32_t, uint32_t> a, std::pair<uint32_t, uint32_t> b)
+	{
+		return commandBuffers[a.first]->commands[a.second].sortKey < 
+			commandBuffers[b.first]->commands[b.second].sortKey;
+	});
+
+	try
+	{
+		if (createdCount > 0)
+		{
+			commandEntities.resize(createdCount);
+			entities.createMany(commandEntities.data(), createdCount);
+
+			for (const auto& buffer : commandBuffers)
+				buffer->createdEntities.resize(buffer->createdCount);
+
+			auto createdEntity = commandEntities.data();
+			for (auto order : commandOrder)
+			{
+				auto buffer = commandBuffers[order.first].get();
+				const auto& command = buffer->commands[order.second];
+				if (command.type == CommandBuffer::CommandType::CreateEntity)
+					buffer->createdEntities[command.target.createdIndex - 1] = *createdEntity++;
+			}
+		}
+
+		for (auto order : commandOrder)
+		{
+			auto buffer = commandBuffers[order.first].get();
+			auto command = buffer->commands[order.second]; // Do not use reference, initializer can add commands!
+			if (command.type == CommandBuffer::CommandType::CreateEntity)
+				continue;
+
+			auto entity = buffer->getEntity(command.target);
+
+			if (command.type == CommandBuffer::CommandType::Destroy)
+			{
+				destroy(entity);
+			}
+			else if (command.type == CommandBuffer::CommandType::Add)
+			{
+				auto component = add(entity, command.componentType);
+				if (command.initializer)
+					buffer->initializers[command.initializer - 1](component);
+			}
+			else if (command.type == CommandBuffer::CommandType::Remove)
+			{
+				remove(entity, command.componentType);
+			}
+			else if (command.type == CommandBuffer::CommandType::Copy)
+			{
+				copy(buffer->getEntity(command.source), entity, command.componentType);
+			}
+		}
+	}
+	catch (...)
+	{
+		for (const auto& buffer : commandBuffers)
+			buffer->clear();
+		throw;
+	}
+
+	for (const auto& buffer : commandBuffers)
+		buffer->clear();
+}
+
+//**********************************************************************************************************************
+void Manager::reserveComponents(TypeIndex componentType, uint32_t count)
+{
+	checkWriteAccess();
+	auto system = findComponentSystem(componentType);
+	if (!system)
+	{
+		throw EcsmError("Component is not registered by any system. ("
+			"type: " + typeToString(componentType) + ")");
+	}
+	system->reserveComponents(count);
+}
+void Manager::shrinkToFit()
+{
+	checkWriteAccess();
+	entities.shrinkToFit();
 	for (const auto& pair : systems)
-		pair.second->disposeComponents();
+		pair.second->shrinkComponents();
+
+	garbageComponents.shrink_to_fit();
+	batchComponents.clear();
+	batchComponents.shrink_to_fit();
+}
+
+//**********************************************************************************************************************
+void Manager::addRemovedComponents(ID<Entity> entity)
+{
+	if (!entity || !entities.isLive(entity))
+		return;
+
+	auto entityView = entities.get(entity);
+	auto components = entityView->getComponents();
+	auto componentCount = entityView->getComponentCount();
+	for (uint32_t i = 0; i < componentCount; i++)
+	{
+		const auto& component = components[i];
+		if (!component.isGarbage) // Garbage components are recorded on dispose.
+			removedComponents.emplace_back(component.system->getComponentType(), entity);
+	}
+}
+void Manager::markChanged(ID<Entity> entity, TypeIndex componentType)
+{
+	assert(entity);
+	checkWriteAccess();
+
+	auto component = findComponent(entity, componentType);
+	if (!component)
+	{
+		throw EcsmError("Component is not added. ("
+			"type: " + typeToString(componentType) + ", "
+			"entity: " + std::to_string(*entity) + ")");
+	}
+	component->system->markComponentChanged(component->instance);
+}
+void Manager::getChangedEntities(TypeIndex componentType,
+	uint64_t sinceFrame, std::vector<ID<Entity>>& entities) const
+{
+	auto system = findComponentSystem(componentType);
+	if (!system)
+		throw EcsmError("Component is not registered by any system. (type: " + typeToString(componentType) + ")");
+	system->getChangedEntities(sinceFrame, entities);
+}
+
+//**********************************************************************************************************************
+static constexpr uint32_t snapshotMagic = 0x4D534345; // "ECSM"
+static constexpr uint32_t snapshotVersion = 1;
+
+void Manager::writeSnapshot(SnapshotWriter& writer) const
+{
+	if (hasPendingGarbage())
+		throw EcsmError("Manager has pending garbage entities or components, write snapshot after the update().");
+
+	std::vector<System*> snapshotSystems;
+	std::vector<uint32_t> systemIndices(componentTypeCount, UINT32_MAX);
+	for (const auto& pair : componentNames)
+	{
+		auto system = pair.second;
+		if (system->componentTypeID == UINT32_MAX)
+			continue;
+		systemIndices[system->componentTypeID] = (uint32_t)snapshotSystems.size();
+		snapshotSystems.push_back(system);
+	}
+
+	writer.write(snapshotMagic);
+	writer.write(snapshotVersion);
+	writer.write((uint32_t)snapshotSystems.size());
+	for (auto system : snapshotSystems)
+		writer.writeString(system->getComponentName());
+
+	entities.writeSnapshot(writer);
+	for (const auto& entity : entities)
+	{
+		auto components = entity.getComponents();
+		auto componentCount = entity.getComponentCount();
+		writer.write(componentCount);
+
+		for (uint32_t i = 0; i < componentCount; i++)
+		{
+			const auto& component = components[i];
+			auto systemIndex = systemIndices[component.type];
+			if (systemIndex == UINT32_MAX)
+			{
+				throw EcsmError("Component system without name can not be written to the snapshot. ("
+					"componentType: " + typeToString(component.system->getComponentType()) + ")");
+			}
+			writer.write(systemIndex);
+			writer.write(component.instance);
+		}
+	}
+
+	for (auto system : snapshotSystems)
+		system->writeComponents(writer);
+}
+void Manager::readSnapshot(SnapshotReader& reader)
+{
+	checkWriteAccess();
+
+	if (reader.read<uint32_t>() != snapshotMagic)
+		throw EcsmError("Bad manager snapshot format.");
+	auto version = reader.read<uint32_t>();
+	if (version != snapshotVersion)
+		throw EcsmError("Unsupported manager snapshot version. (version: " + std::to_string(version) + ")");
+
+	auto systemCount = reader.read<uint32_t>();
+	std::vector<System*> snapshotSystems(systemCount);
+	for (uint32_t i = 0; i < systemCount; i++)
+	{
+		auto componentName = reader.readString();
+		auto result = componentNames.find(std::string(componentName));
+		if (result == componentNames.end() || result->second->componentTypeID == UINT32_MAX)
+		{
+			throw EcsmError("Snapshot component system is not created. ("
+				"componentName: " + std::string(componentName) + ")");
+		}
+		snapshotSystems[i] = result->second;
+	}
+
+	uint32_t componentSystemCount = 0;
+	for (const auto& pair : componentNames)
+	{
+		if (pair.second->componentTypeID != UINT32_MAX)
+			componentSystemCount++;
+	}
+	if (componentSystemCount != systemCount)
+		throw EcsmError("Snapshot has different component system set.");
+
+	// Pending garbage and change records belong to the replaced world.
+	garbageComponents.clear();
+	for (auto system : garbageSystems)
+		system->isGarbageQueued = false;
+	garbageSystems.clear();
+	addedComponents.clear();
+	removedComponents.clear();
+
+	entities.readSnapshot(reader);
+
+	for (auto& entity : entities)
+	{
+		auto componentCount = reader.read<uint32_t>();
+		entity.reserveComponents(componentCount, memoryResource);
+
+		for (uint32_t i = 0; i < componentCount; i++)
+		{
+			auto systemIndex = reader.read<uint32_t>();
+			auto instance = reader.read<ID<Component>>();
+			if (systemIndex >= systemCount)
+				throw EcsmError("Bad manager snapshot entity component.");
+
+			auto system = snapshotSystems[systemIndex];
+			if (!entity.addComponent(system->componentTypeID, system, instance, memoryResource))
+				throw EcsmError("Bad manager snapshot entity component.");
+		}
+	}
+
+	for (auto system : snapshotSystems)
+		system->readComponents(reader);
+
+	for (auto query : queries)
+	{
+		query->entities.clear();
+		query->components.clear();
+		query->positions.clear();
+
+		for (const auto& entityData : entities)
+		{
+			auto entity = entities.getID(&entityData);
+			if (isQueryMatch(query, entity))
+				addQueryEntity(query, entity);
+		}
+	}
 }
 
 //**********************************************************************************************************************
@@ -0,0 +1,166 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "profiler.hpp"
+#include <algorithm>
+
+using namespace ecsm;
+
+//**********************************************************************************************************************
+Profiler::Profiler(uint32_t maxSampleCount) :
+	startTime(std::chrono::steady_clock::now()), maxSampleCount(maxSampleCount) { }
+
+uint32_t Profiler::getThreadIndex()
+{
+	auto threadID = std::this_thread::get_id();
+	auto result = std::find(threads.begin(), threads.end(), threadID);
+	if (result != threads.end())
+		return (uint32_t)(result - threads.begin());
+	threads.push_back(threadID);
+	return (uint32_t)threads.size() - 1;
+}
+
+//**********************************************************************************************************************
+void Profiler::addSample(std::string name, std::string_view category, Time begin, Time end)
+{
+	auto duration = end - begin;
+	std::lock_guard lock(locker);
+
+	auto result = stats.find(name);
+	if (result == stats.end())
+		result = stats.emplace(name, Stats()).first;
+
+	auto& sampleStats = result->second;
+	sampleStats.count++;
+	sampleStats.totalTime += duration;
+	sampleStats.minTime = std::min(sampleStats.minTime, duration);
+	sampleStats.maxTime = std::max(sampleStats.maxTime, duration);
+	sampleStats.lastTime = duration;
+
+	if (samples.size() < maxSampleCount)
+		samples.push_back({ std::move(name), category, begin, duration, getThreadIndex() });
+}
+void Profiler::addCounter(std::string name, Time time, uint64_t count, uint64_t capacity)
+{
+	std::lock_guard lock(locker);
+
+	auto isGrown = false;
+	auto result = capacities.find(name);
+	if (result == capacities.end())
+	{
+		capacities.emplace(name, capacity);
+	}
+	else if (result->second != capacity)
+	{
+		isGrown = capacity > result->second;
+		result->second = capacity;
+	}
+
+	if (isGrown)
+		growthCount++;
+	if (counters.size() < maxSampleCount)
+		counters.push_back({ std::move(name), time, count, capacity, isGrown });
+}
+
+const Profiler::Stats* Profiler::getStats(std::string_view name) const
+{
+	std::lock_guard lock(locker);
+	auto result = stats.find(name);
+	return result != stats.end() ? &result->second : nullptr;
+}
+void Profiler::clear()
+{
+	std::lock_guard lock(locker);
+	samples.clear();
+	counters.clear();
+	stats.clear();
+	growthCount = 0;
+}
+
+//**********************************************************************************************************************
+static void appendJsonString(std::string& json, std::string_view value)
+{
+	json += '"';
+	for (auto c : value)
+	{
+		if (c == '"' || c == '\\')
+		{
+			json += '\\';
+			json += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			json += ' ';
+		}
+		else
+		{
+			json += c;
+		}
+	}
+	json += '"';
+}
+static void appendMicroseconds(std::string& json, Profiler::Time time)
+{
+	json += std::to_string(time / 1000);
+	json += '.';
+	auto fraction = std::to_string(time % 1000);
+	json.append(3 - fraction.size(), '0');
+	json += fraction;
+}
+
+std::string Profiler::getChromeTrace() const
+{
+	std::lock_guard lock(locker);
+
+	std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	auto isFirst = true;
+
+	for (const auto& sample : samples)
+	{
+		json += isFirst ? "\n" : ",\n";
+		isFirst = false;
+		json += "{\"name\":";
+		appendJsonString(json, sample.name);
+		json += ",\"cat\":";
+		appendJsonString(json, sample.category);
+		json += ",\"ph\":\"X\",\"pid\":0,\"tid\":" + std::to_string(sample.thread) + ",\"ts\":";
+		appendMicroseconds(json, sample.begin);
+		json += ",\"dur\":";
+		appendMicroseconds(json, sample.duration);
+		json += "}";
+	}
+	for (const auto& counter : counters)
+	{
+		json += isFirst ? "\n" : ",\n";
+		isFirst = false;
+		json += "{\"name\":";
+		appendJsonString(json, counter.name);
+		json += ",\"cat\":\"Pool\",\"ph\":\"C\",\"pid\":0,\"ts\":";
+		appendMicroseconds(json, counter.time);
+		json += ",\"args\":{\"count\":" + std::to_string(counter.count) +
+			",\"capacity\":" + std::to_string(counter.capacity) + "}}";
+
+		if (!counter.isGrown)
+			continue;
+
+		json += ",\n{\"name\":";
+		appendJsonString(json, counter.name + " Growth");
+		json += ",\"cat\":\"Pool\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":";
+		appendMicroseconds(json, counter.time);
+		json += ",\"args\":{\"capacity\":" + std::to_string(counter.capacity) + "}}";
+	}
+
+	json += "\n]}\n";
+	return json;
+}
@@ -16,18 +16,19 @@
 #include "ecsm.hpp"
 
 //**********************************************************************************************************************
-void* ecsm::getManagerSystem(std::type_index type)
+void* ecsm::getManagerSystem(TypeIndex type, uint32_t staticTypeID)
 {
 	auto manager = Manager::Instance::get();
-	return manager->get(type);
+	auto system = manager->findSystem(staticTypeID);
+	return system ? system : manager->get(type);
 }
-bool ecsm::hasManagerSystem(std::type_index type)
+bool ecsm::hasManagerSystem(uint32_t staticTypeID)
 {
 	auto manager = Manager::Instance::get();
-	return manager->has(type);
+	return manager->findSystem(staticTypeID);
 }
-void* ecsm::tryGetManagerSystem(std::type_index type)
+void* ecsm::tryGetManagerSystem(uint32_t staticTypeID)
 {
 	auto manager = Manager::Instance::get();
-	return manager->tryGet(type);
+	return manager->findSystem(staticTypeID);
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread-pool.hpp"
+#include <algorithm>
+
+using namespace ecsm;
+
+static thread_local const ThreadPool* currentThreadPool = nullptr;
+static thread_local uint32_t currentWorkerIndex = UINT32_MAX;
+
+//**********************************************************************************************************************
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	workerCount = threadCount;
+	workers = std::make_unique<Worker[]>(threadCount);
+	threads.reserve(threadCount);
+
+	for (uint32_t i = 0; i < threadCount; i++)
+		threads.emplace_back(&ThreadPool::runWorker, this, i);
+}
+ThreadPool::~ThreadPool()
+{
+	try { waitGroup(&defaultGroup); }
+	catch (...) { } // Destructor should not throw.
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		isRunning = false;
+	}
+	sleepCondition.notify_all();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+bool ThreadPool::isWorkerThread() const noexcept
+{
+	return currentThreadPool == this;
+}
+
+//**********************************************************************************************************************
+void ThreadPool::addJob(Task&& task, Group* group)
+{
+	group->count.fetch_add(1);
+
+	auto workerIndex = currentThreadPool == this ? currentWorkerIndex : nextWorker.fetch_add(1) % workerCount;
+	auto& worker = workers[workerIndex];
+
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		queuedCount.fetch_add(1);
+		worker.jobs.push_back(Job{ std::move(task), group });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex); // Prevents lost wakeup.
+	}
+	sleepCondition.notify_one();
+}
+bool ThreadPool::runJob(uint32_t workerIndex)
+{
+	Job job;
+	auto isFound = false;
+
+	if (workerIndex != UINT32_MAX)
+	{
+		auto& worker = workers[workerIndex];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (!worker.jobs.empty())
+		{
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+			queuedCount.fetch_sub(1);
+			isFound = true;
+		}
+	}
+
+	for (uint32_t i = 1; !isFound && i <= workerCount; i++)
+	{
+		auto& worker = workers[(workerIndex + i) % workerCount];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.jobs.empty())
+			continue;
+
+		job = std::move(worker.jobs.front());
+		worker.jobs.pop_front();
+		queuedCount.fetch_sub(1);
+		isFound = true;
+	}
+
+	if (!isFound)
+		return false;
+
+	auto group = job.group;
+	try
+	{
+		job.task();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(group->mutex);
+		if (!group->exception)
+			group->exception = std::current_exception();
+	}
+
+	if (group->count.fetch_sub(1) == 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex); // Prevents lost wakeup.
+		}
+		sleepCondition.notify_all();
+	}
+	return true;
+}
+
+//**********************************************************************************************************************
+void ThreadPool::waitGroup(Group* group)
+{
+	auto workerIndex = currentThreadPool == this ? currentWorkerIndex : UINT32_MAX;
+	while (group->count.load() > 0)
+	{
+		if (runJob(workerIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this, group]()
+		{
+			return group->count.load() == 0 || queuedCount.load() > 0;
+		});
+	}
+
+	std::exception_ptr exception = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(group->mutex);
+		std::swap(exception, group->exception);
+	}
+	if (exception)
+		std::rethrow_exception(exception);
+}
+void ThreadPool::runWorker(uint32_t workerIndex)
+{
+	currentThreadPool = this;
+	currentWorkerIndex = workerIndex;
+
+	while (true)
+	{
+		if (runJob(workerIndex))
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepCondition.wait(lock, [this]() { return queuedCount.load() > 0 || !isRunning; });
+		if (!isRunning && queuedCount.load() == 0)
+			break;
+	}
+}
+
+//**********************************************************************************************************************
+void ThreadPool::parallelFor(uint32_t count, const RangeTask& function, uint32_t batchSize)
+{
+	assert(function);
+	if (count == 0)
+		return;
+
+	if (batchSize == 0)
+		batchSize = std::max(count / (workerCount * 4), 1u);
+	if (count <= batchSize)
+	{
+		function(0, count);
+		return;
+	}
+
+	Group group;
+	for (uint32_t begin = batchSize; begin < count; )
+	{
+		auto end = batchSize > count - begin ? count : begin + batchSize;
+		addJob([&function, begin, end]() { function(begin, end); }, &group);
+		begin = end;
+	}
+
+	try
+	{
+		function(0, batchSize);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(group.mutex);
+		if (!group.exception)
+			group.exception = std::current_exception();
+	}
+
+	waitGroup(&group); // Always wait, tasks are referencing the group.
+}
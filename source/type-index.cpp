@@ -0,0 +1,63 @@
+// Copyright 2022-2024 Nikita Fediuchin. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "type-index.hpp"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace ecsm;
+
+// Registries live in the library translation unit, so all modules share one instance.
+// Function local statics are used because types can be registered during the static initialization.
+static std::mutex registryMutex;
+
+static std::unordered_map<TypeIndex, uint32_t>& getStaticTypeIDs()
+{
+	static std::unordered_map<TypeIndex, uint32_t> staticTypeIDs;
+	return staticTypeIDs;
+}
+
+#ifdef ECSM_NO_RTTI
+static std::unordered_map<std::string, TypeInfo>& getTypeInfos()
+{
+	static std::unordered_map<std::string, TypeInfo> typeInfos;
+	return typeInfos;
+}
+
+//**********************************************************************************************************************
+const TypeInfo& ecsm::registerTypeInfo(const char* signature) noexcept
+{
+	std::lock_guard lock(registryMutex);
+	auto result = getTypeInfos().emplace(signature, TypeInfo());
+	if (result.second)
+		result.first->second.signature = result.first->first.c_str();
+	return result.first->second;
+}
+#endif
+
+//**********************************************************************************************************************
+uint32_t ecsm::allocateStaticTypeID(TypeIndex type) noexcept
+{
+	std::lock_guard lock(registryMutex);
+	auto& staticTypeIDs = getStaticTypeIDs();
+	auto result = staticTypeIDs.emplace(type, (uint32_t)staticTypeIDs.size());
+	return result.first->second;
+}
+uint32_t ecsm::getStaticTypeCount() noexcept
+{
+	std::lock_guard lock(registryMutex);
+	return (uint32_t)getStaticTypeIDs().size();
+}
@@ -13,6 +13,10 @@
 // limitations under the License.
 
 #include "ecsm.hpp"
+#include <atomic>
+#include <memory_resource>
+#include <chrono>
+#include <thread>
 
 using namespace std;
 using namespace ecsm;
@@ -72,17 +76,8 @@ class TestSystem final : public ComponentSystem<TestComponent>, public Singleton
 	{
 		updateCounter++;
 
-		auto componentData = components.getData();
-		auto occupancy = components.getOccupancy();
-
-		for (uint32_t i = 0; i < occupancy; i++)
-		{
-			auto componentView = &componentData[i];
-			if (componentView->ID == 0) // Skip unallocated components
-				continue;
-
-			componentView->ID++;
-		}
+		for (auto& component : components)
+			component.ID++;
 	}
 	void postUpdate()
 	{
@@ -131,7 +126,7 @@ static void testCommonFlow()
 
 	if (baseSystem->getComponentName() != "Test")
 		throw runtime_error("Bad test system component name.");
-	if (baseSystem->getComponentType() != typeid(TestComponent))
+	if (baseSystem->getComponentType() != getTypeIndex<TestComponent>())
 		throw runtime_error("Bad test system component type.");
 
 	auto testEntity = manager->createEntity();
@@ -181,13 +176,13 @@ static void testCommonFlow()
 	if (testView->ID != 2)
 		throw runtime_error("Bad test component data after destroy.");
 
-	auto componentMemory = *testView;
 	manager->disposeGarbageComponents();
 	manager->disposeSystemComponents();
 	manager->disposeEntities();
 
-	if (componentMemory->ID != 0) // WARNING! You should't do this, it's just safety check!
-		throw runtime_error("Bad test component data after dispose.");
+	// Note: disposed component slot is destructed and left uninitialized until reused.
+	if (manager->get<TestSystem>()->getComponentCount() != 0)
+		throw runtime_error("Bad test component count after dispose.");
 
 	manager->destroySystem<TestSystem>();
 
@@ -271,16 +266,2017 @@ static void testDisposeFlow()
 		throw runtime_error("Bad test component ID after remove.");
 	if (stackCounter != 1)
 		throw runtime_error("Bad stack counter after component remove.");
+	if (!manager->isGarbage<TestComponent>(entity) || manager->has<TestComponent>(entity) ||
+		manager->tryGet<TestComponent>(entity) || manager->tryGetID<TestComponent>(entity))
+	{
+		throw runtime_error("Bad component garbage state after remove.");
+	}
+	auto testSystem = manager->get<TestSystem>();
+	if (testSystem->hasComponent(entity) || testSystem->tryGetComponent(entity))
+		throw runtime_error("Bad system component garbage state after remove.");
+
+	auto isRemovedTwice = false;
+	try { manager->remove<TestComponent>(entity); }
+	catch (const EcsmError&) { isRemovedTwice = true; }
+	if (!isRemovedTwice || manager->getGarbageComponents().size() != 1)
+		throw runtime_error("Component is removed twice.");
 
 	manager->disposeGarbageComponents();
 	manager->disposeSystemComponents();
 
+	if (manager->isGarbage<TestComponent>(entity) || !manager->getGarbageComponents().empty())
+		throw runtime_error("Bad component garbage state after dispose.");
+
 	if (stackCounter != 0)
 		throw runtime_error("Bad stack counter after component dispose.");
 
 	delete manager;
 }
 
+//**********************************************************************************************************************
+template<int I>
+struct IndexedComponent final : public Component
+{
+	int value = 0;
+};
+
+template<int I>
+class IndexedSystem final : public ComponentSystem<IndexedComponent<I>, false>
+{
+	friend class ecsm::Manager;
+};
+
+template<int... I>
+static void createIndexedSystems(Manager* manager, std::integer_sequence<int, I...>)
+{
+	(manager->createSystem<IndexedSystem<I>>(), ...);
+}
+template<int... I>
+static void addIndexedComponents(Manager* manager, ID<Entity> entity, std::integer_sequence<int, I...>)
+{
+	((manager->add<IndexedComponent<I>>(entity)->value = I + 1), ...);
+}
+template<int... I>
+static bool checkIndexedComponents(Manager* manager, ID<Entity> entity, std::integer_sequence<int, I...>)
+{
+	return ((manager->get<IndexedComponent<I>>(entity)->value == I + 1) && ...);
+}
+
+static void testEntityComponents()
+{
+	constexpr int componentCount = Entity::inlineCapacity * 2 + 1;
+	auto indices = std::make_integer_sequence<int, componentCount>();
+
+	auto manager = new Manager();
+	createIndexedSystems(manager, indices);
+
+	auto entity = manager->createEntity();
+	for (uint32_t i = 0; i < 100; i++)
+		manager->createEntity(); // Reallocates entity pool.
+	addIndexedComponents(manager, entity, indices);
+
+	if (manager->getComponentCount(entity) != componentCount)
+		throw runtime_error("Bad entity component count.");
+	if (!checkIndexedComponents(manager, entity, indices))
+		throw runtime_error("Bad entity component data.");
+
+	auto entityView = manager->get(entity);
+	auto components = entityView->getComponents();
+	for (uint32_t i = 1; i < componentCount; i++)
+	{
+		if (components[i - 1].type >= components[i].type)
+			throw runtime_error("Entity components are not sorted.");
+	}
+
+	manager->remove<IndexedComponent<3>>(entity);
+	manager->disposeGarbageComponents();
+
+	if (manager->has<IndexedComponent<3>>(entity) || !manager->has<IndexedComponent<4>>(entity))
+		throw runtime_error("Bad entity component state after remove.");
+	if (manager->get<IndexedComponent<componentCount - 1>>(entity)->value != componentCount)
+		throw runtime_error("Bad entity component data after remove.");
+
+	auto duplicate = manager->duplicate(entity);
+	if (manager->getComponentCount(duplicate) != componentCount - 1)
+		throw runtime_error("Bad duplicated entity component count.");
+	if (manager->has<IndexedComponent<3>>(duplicate) || !manager->has<IndexedComponent<4>>(duplicate))
+		throw runtime_error("Bad duplicated entity components.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+struct DelayedItem final
+{
+	int destroyCalls = 0;
+	int delayCount = 0;
+
+	bool destroy()
+	{
+		return ++destroyCalls > delayCount;
+	}
+};
+
+static void testPoolDispose()
+{
+	LinearPool<DelayedItem> pool;
+	const uint32_t itemCount = 100;
+	vector<ID<DelayedItem>> items(itemCount);
+
+	for (uint32_t i = 0; i < itemCount; i++)
+	{
+		items[i] = pool.create();
+		pool.get(items[i])->delayCount = i % 2;
+	}
+	for (uint32_t i = 0; i < itemCount; i++)
+		pool.destroy(items[i]);
+
+	pool.dispose();
+
+	if (pool.getCount() != itemCount / 2)
+		throw runtime_error("Bad pool item count after first dispose.");
+	for (uint32_t i = 1; i < itemCount; i += 2)
+	{
+		if (pool.get(items[i])->destroyCalls != 1)
+			throw runtime_error("Bad delayed item state after first dispose.");
+	}
+
+	pool.dispose();
+
+	if (pool.getCount() != 0)
+		throw runtime_error("Bad pool item count after second dispose.");
+
+	for (uint32_t i = 0; i < itemCount; i++)
+		items[i] = pool.create();
+	for (uint32_t i = 0; i < itemCount; i++)
+		pool.destroy(items[i]);
+	if (pool.dispose(10) != 10 || pool.getCount() != itemCount - 10)
+		throw runtime_error("Bad pool item count after partial dispose.");
+	pool.dispose();
+
+	for (uint32_t i = 0; i < itemCount; i++)
+		pool.create();
+
+	if (pool.getOccupancy() != itemCount)
+		throw runtime_error("Pool did not reuse freed items.");
+}
+
+//**********************************************************************************************************************
+template<class Pool>
+static void testIterationDestroy()
+{
+	Pool pool;
+	vector<ID<DelayedItem>> items(4);
+	for (uint32_t i = 0; i < 4; i++)
+		items[i] = pool.create();
+	pool.get(items[2])->delayCount = 1;
+
+	vector<uint32_t> visits(4);
+	for (auto& item : pool)
+	{
+		auto index = *pool.getID(&item) - 1;
+		visits[index]++;
+		if (index == 0)
+		{
+			pool.destroy(items[0]);
+			pool.destroy(items[1]);
+		}
+	}
+	if (visits[0] != 1 || visits[1] > 1 || visits[2] != 1 || visits[3] != 1)
+		throw runtime_error("Pool iterator visited item twice after destroy.");
+	if (pool.getLiveCount() != 2 || pool.isLive(items[1]) || !pool.isLive(items[3]))
+		throw runtime_error("Bad pool live item state after destroy during iteration.");
+
+	pool.destroy(items[2]);
+	if (pool.dispose() != 2 || pool.getCount() != 2 || pool.getLiveCount() != 1)
+		throw runtime_error("Bad pool item count after dispose of destroyed during iteration items.");
+
+	uint32_t iterationCount = 0;
+	for (auto& item : pool)
+	{
+		if (pool.getID(&item) != items[3])
+			throw runtime_error("Pool iterator visited not yet disposed item.");
+		iterationCount++;
+	}
+	if (iterationCount != 1 || pool.dispose() != 1 || pool.getCount() != 1)
+		throw runtime_error("Bad pool iteration after delayed dispose.");
+}
+
+static void testPoolIteration()
+{
+	LinearPool<DelayedItem> pool;
+	const uint32_t itemCount = 64;
+	vector<ID<DelayedItem>> items(itemCount);
+
+	for (uint32_t i = 0; i < itemCount; i++)
+		items[i] = pool.create();
+	for (uint32_t i = 0; i < itemCount; i += 4)
+		pool.destroy(items[i]);
+	pool.destroy(items[0]);
+
+	if (pool.getLiveCount() != itemCount - itemCount / 4 || pool.isLive(items[4]) || !pool.isLive(items[5]))
+		throw runtime_error("Bad pool live item state after destroy.");
+
+	for (auto& item : pool)
+		item.delayCount = 1;
+	for (uint32_t i = 0; i < itemCount; i++)
+	{
+		if (pool.get(items[i])->delayCount != (i % 4 == 0 ? 0 : 1))
+			throw runtime_error("Pool iterator visited destroyed item.");
+	}
+
+	pool.dispose();
+	auto newItem = pool.create();
+
+	uint32_t iterationCount = 0;
+	for (auto i = pool.begin(); i != pool.end(); i++)
+		iterationCount++;
+
+	if (iterationCount != itemCount - itemCount / 4 + 1 || !pool.isLive(newItem))
+		throw runtime_error("Bad pool live item count after dispose.");
+
+	testIterationDestroy<LinearPool<DelayedItem>>();
+	testIterationDestroy<ChunkedPool<DelayedItem, true, 2>>();
+}
+
+static void testPoolFreePolicy()
+{
+	LinearPool<DelayedItem> pool;
+	vector<ID<DelayedItem>> items(10);
+
+	for (uint32_t i = 0; i < 10; i++)
+		items[i] = pool.create();
+	pool.destroy(items[2]);
+	pool.destroy(items[8]);
+	pool.destroy(items[5]);
+	pool.dispose();
+
+	auto reusedItem = pool.create();
+	if (*reusedItem != *items[5] || pool.isValid(items[5]) || !pool.isValid(reusedItem))
+		throw runtime_error("Pool did not reuse last freed item first.");
+
+	pool.destroy(reusedItem);
+	pool.dispose();
+	pool.setLowestFreeFirst(true);
+
+	if (*pool.create() != *items[2] || *pool.create() != *items[5] || *pool.create() != *items[8])
+		throw runtime_error("Pool did not reuse lowest free item first.");
+	if (pool.getCount() != 10 || pool.getOccupancy() != 10)
+		throw runtime_error("Bad pool item count after free item reuse.");
+}
+
+//**********************************************************************************************************************
+struct ChunkedComponent final : public Component
+{
+	uint32_t value = 0;
+};
+
+class ChunkedSystem final : public ComponentSystem<ChunkedComponent, false, ChunkedPool<ChunkedComponent, false, 4>>
+{
+	friend class ecsm::Manager;
+public:
+	const ChunkedPool<ChunkedComponent, false, 4>& getComponents() const noexcept { return components; }
+};
+
+static void testChunkedPool()
+{
+	auto manager = new Manager();
+	manager->createSystem<ChunkedSystem>();
+
+	auto firstEntity = manager->createEntity();
+	auto firstView = manager->add<ChunkedComponent>(firstEntity);
+	firstView->value = 1;
+	auto firstMemory = *firstView;
+
+	const uint32_t entityCount = 33;
+	for (uint32_t i = 1; i < entityCount; i++)
+	{
+		auto entity = manager->createEntity();
+		manager->add<ChunkedComponent>(entity)->value = i + 1;
+	}
+
+	if (*firstView != firstMemory || firstView->value != 1)
+		throw runtime_error("Chunked component memory has been relocated.");
+
+	const auto& components = manager->get<ChunkedSystem>()->getComponents();
+	if (components.getChunks().size() != 9 || components.getCount() != entityCount)
+		throw runtime_error("Bad chunked pool size.");
+
+	uint32_t valueSum = 0;
+	for (const auto& component : components)
+		valueSum += component.value;
+
+	if (valueSum != entityCount * (entityCount + 1) / 2)
+		throw runtime_error("Bad chunked pool iteration.");
+	if (components.getID(firstMemory) != manager->getID<ChunkedComponent>(firstEntity))
+		throw runtime_error("Bad chunked pool item identifier.");
+
+	ChunkedPool<DelayedItem> pool;
+	vector<ID<DelayedItem>> items(entityCount);
+	for (uint32_t i = 0; i < entityCount; i++)
+		items[i] = pool.create();
+	for (uint32_t i = 0; i < entityCount; i++)
+		pool.destroy(items[i]);
+	if (pool.dispose(10) != 10 || pool.getCount() != entityCount - 10 || pool.dispose() != entityCount - 10)
+		throw runtime_error("Bad chunked pool partial dispose.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+struct PositionComponent final : public Component
+{
+	float x = 0.0f, y = 0.0f;
+};
+struct VelocityComponent final : public Component
+{
+	float x = 0.0f, y = 0.0f;
+	int* counter = nullptr;
+
+	bool destroy()
+	{
+		if (counter)
+			*counter = *counter - 1;
+		return true;
+	}
+};
+
+class PositionSystem final : public ArchetypeSystem<PositionComponent, false>
+{
+	friend class ecsm::Manager;
+};
+class VelocitySystem final : public ArchetypeSystem<VelocityComponent>
+{
+	friend class ecsm::Manager;
+};
+
+static void testArchetypeStorage()
+{
+	auto manager = new Manager();
+	manager->createSystem<PositionSystem>();
+	manager->createSystem<VelocitySystem>();
+
+	const uint32_t entityCount = 100;
+	vector<ID<Entity>> entities(entityCount);
+	int velocityCounter = 0;
+
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		auto entity = manager->createEntity();
+		manager->add<PositionComponent>(entity)->x = (float)i;
+		if (i % 2 == 0)
+		{
+			auto velocityView = manager->add<VelocityComponent>(entity);
+			velocityView->x = 1.0f;
+			velocityView->counter = &velocityCounter;
+			velocityCounter++;
+		}
+		entities[i] = entity;
+	}
+
+	auto& archetypes = manager->getArchetypes();
+	if (archetypes.getArchetypes().size() != 2)
+		throw runtime_error("Bad archetype count.");
+
+	uint32_t movingCount = 0;
+	archetypes.each<PositionComponent, VelocityComponent>([&](ID<Entity> entity,
+		PositionComponent& position, VelocityComponent& velocity)
+	{
+		if (position.getEntity() != entity || velocity.getEntity() != entity)
+			throw runtime_error("Bad archetype component entity.");
+		position.x += velocity.x;
+		movingCount++;
+	});
+
+	if (movingCount != entityCount / 2)
+		throw runtime_error("Bad archetype iteration count.");
+
+	for (uint32_t i = 0; i < entityCount; i += 4)
+		manager->remove<VelocityComponent>(entities[i]);
+	auto velocitySystem = manager->get<VelocitySystem>();
+	if (velocitySystem->hasComponent(entities[0]) || velocitySystem->tryGetComponent(entities[0]) ||
+		!velocitySystem->hasComponent(entities[2]))
+	{
+		throw runtime_error("Bad archetype system component garbage state.");
+	}
+	manager->disposeGarbageComponents();
+	manager->disposeSystemComponents();
+
+	if (velocityCounter != entityCount / 4)
+		throw runtime_error("Bad archetype component destroy count.");
+
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		auto expectedX = (float)i + (i % 2 == 0 ? 1.0f : 0.0f);
+		if (manager->get<PositionComponent>(entities[i])->x != expectedX)
+			throw runtime_error("Bad archetype component data after move.");
+		if (manager->has<VelocityComponent>(entities[i]) != (i % 4 == 2))
+			throw runtime_error("Bad archetype component state after remove.");
+	}
+
+	auto system = manager->get<VelocitySystem>();
+	if (!system->hasComponent(entities[2]) || system->tryGetComponent(entities[4]))
+		throw runtime_error("Bad archetype system component state.");
+
+	manager->destroy(entities[2]);
+	manager->disposeEntities();
+	manager->disposeSystemComponents();
+
+	if (manager->getArchetypes().has(entities[2], system->getStorageType()))
+		throw runtime_error("Archetype component is not destroyed with entity.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testQueries()
+{
+	auto manager = new Manager();
+	createIndexedSystems(manager, std::make_integer_sequence<int, 3>());
+	manager->createSystem<PositionSystem>();
+
+	const uint32_t entityCount = 64;
+	vector<ID<Entity>> entities(entityCount);
+
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		auto entity = manager->createEntity();
+		manager->add<IndexedComponent<0>>(entity)->value = (int)i;
+		if (i % 2 == 0)
+			manager->add<IndexedComponent<1>>(entity)->value = 1;
+		if (i % 4 == 0)
+			manager->add<IndexedComponent<2>>(entity);
+		if (i % 8 == 0)
+			manager->add<PositionComponent>(entity)->x = (float)i;
+		entities[i] = entity;
+	}
+
+	auto& query = manager->query<IndexedComponent<0>, IndexedComponent<1>>(Exclude<IndexedComponent<2>>());
+	if (query.getCount() != entityCount / 4)
+		throw runtime_error("Bad query initial entity count.");
+	if (&manager->query<IndexedComponent<0>, IndexedComponent<1>>(Exclude<IndexedComponent<2>>()) != &query)
+		throw runtime_error("Query is not cached.");
+
+	uint32_t iterationCount = 0;
+	manager->each<IndexedComponent<0>, IndexedComponent<1>>([&](ID<Entity> entity,
+		IndexedComponent<0>& a, IndexedComponent<1>& b)
+	{
+		if (a.getEntity() != entity || b.getEntity() != entity || a.value % 4 != 2)
+			throw runtime_error("Bad query component.");
+		a.value += b.value;
+		iterationCount++;
+	}, Exclude<IndexedComponent<2>>());
+
+	if (iterationCount != entityCount / 4 || manager->get<IndexedComponent<0>>(entities[2])->value != 3)
+		throw runtime_error("Bad query iteration.");
+
+	manager->add<IndexedComponent<1>>(entities[1]);
+	if (!query.isMatch(entities[1]))
+		throw runtime_error("Query is not updated after component add.");
+	manager->add<IndexedComponent<2>>(entities[2]);
+	if (query.isMatch(entities[2]))
+		throw runtime_error("Query is not updated after excluded component add.");
+	manager->remove<IndexedComponent<2>>(entities[4]);
+	if (!query.isMatch(entities[4]))
+		throw runtime_error("Query is not updated after excluded component remove.");
+	manager->remove<IndexedComponent<1>>(entities[6]);
+	if (query.isMatch(entities[6]))
+		throw runtime_error("Query is not updated after component remove.");
+	manager->destroy(entities[10]);
+	if (query.isMatch(entities[10]) || query.getCount() != entityCount / 4 - 1)
+		throw runtime_error("Query is not updated after entity destroy.");
+
+	manager->disposeGarbageComponents();
+	manager->disposeEntities();
+	manager->disposeSystemComponents();
+
+	auto duplicate = manager->duplicate(entities[1]);
+	if (!query.isMatch(duplicate))
+		throw runtime_error("Query is not updated after entity duplicate.");
+
+	const auto& entityQueries = query.getEntities();
+	for (uint32_t i = 0; i < query.getCount(); i++)
+	{
+		auto entity = entityQueries[i];
+		if (!manager->has<IndexedComponent<0>>(entity) || !manager->has<IndexedComponent<1>>(entity) ||
+			manager->has<IndexedComponent<2>>(entity) || query.getComponents(i)[0] !=
+			manager->getID(entity, getTypeIndex<IndexedComponent<0>>()))
+		{
+			throw runtime_error("Bad query matching entity.");
+		}
+	}
+
+	uint32_t positionCount = 0;
+	manager->each<PositionComponent, IndexedComponent<2>>([&](ID<Entity> entity,
+		PositionComponent& position, IndexedComponent<2>&)
+	{
+		if (position.x != (float)(*entity - 1))
+			throw runtime_error("Bad archetype query component.");
+		positionCount++;
+	});
+
+	if (positionCount != entityCount / 8)
+		throw runtime_error("Bad archetype query iteration.");
+
+	manager->destroySystem<IndexedSystem<2>>();
+	if (manager->getQueries().size() != 0)
+		throw runtime_error("Query is not destroyed with system.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+struct ParallelItem final
+{
+	uint32_t value = 0;
+};
+
+static void testThreadPool()
+{
+	ThreadPool threadPool(4);
+	if (threadPool.getThreadCount() != 4 || threadPool.isWorkerThread())
+		throw runtime_error("Bad thread pool state.");
+
+	atomic<uint64_t> rangeSum = 0;
+	threadPool.parallelFor(10000, [&](uint32_t begin, uint32_t end)
+	{
+		uint64_t sum = 0;
+		for (uint32_t i = begin; i < end; i++)
+			sum += i;
+		rangeSum += sum;
+	});
+
+	if (rangeSum != 10000ull * 9999ull / 2)
+		throw runtime_error("Bad parallel range sum.");
+
+	LinearPool<ParallelItem, false> pool;
+	for (uint32_t i = 0; i < 1000; i++)
+		pool.get(pool.create())->value = i;
+
+	threadPool.parallelForEach(pool, [](ParallelItem& item) { item.value *= 2; }, 64);
+
+	uint32_t index = 0;
+	for (auto& item : pool)
+	{
+		if (item.value != index++ * 2)
+			throw runtime_error("Bad parallel pool item.");
+	}
+
+	atomic<uint32_t> nestedCount = 0;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		threadPool.addTask([&]()
+		{
+			threadPool.parallelFor(100, [&](uint32_t begin, uint32_t end) { nestedCount += end - begin; }, 10);
+		});
+	}
+	threadPool.wait();
+
+	if (nestedCount != 800)
+		throw runtime_error("Bad nested parallel task count.");
+
+	threadPool.addTask([]() { throw runtime_error("Task error."); });
+	auto isThrown = false;
+	try { threadPool.wait(); }
+	catch (const runtime_error&) { isThrown = true; }
+
+	if (!isThrown)
+		throw runtime_error("Task exception is not rethrown.");
+
+	auto manager = new Manager();
+	manager->registerEvent("Parallel");
+	manager->setThreadPool(&threadPool);
+
+	atomic<uint32_t> writeA = 0, writeB = 0;
+	auto isReadValid = false;
+
+	manager->subscribeToEvent("Parallel", [&]() { writeA++; }, ComponentAccess().write<TestComponent>());
+	manager->subscribeToEvent("Parallel", [&]() { writeB++; }, ComponentAccess().write<PositionComponent>());
+	manager->subscribeToEvent("Parallel", [&]() { isReadValid = writeA == 1 && writeB == 1; },
+		ComponentAccess().read<TestComponent, PositionComponent>());
+	manager->runEvent("Parallel");
+
+	if (!isReadValid)
+		throw runtime_error("Conflicting subscribers are executed in parallel.");
+
+	if (ComponentAccess().read<TestComponent>().isConflicting(ComponentAccess().read<TestComponent>()) ||
+		!ComponentAccess().read<TestComponent>().isConflicting(ComponentAccess().write<TestComponent>()) ||
+		!ComponentAccess().isConflicting(ComponentAccess().read<>()))
+	{
+		throw runtime_error("Bad component access conflict check.");
+	}
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static bool waitForFlag(const atomic<bool>& flag)
+{
+	auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+	while (!flag)
+	{
+		if (chrono::steady_clock::now() > deadline)
+			return false;
+		this_thread::yield();
+	}
+	return true;
+}
+
+static void testSchedule()
+{
+	ThreadPool threadPool(4);
+	auto manager = new Manager();
+	manager->registerEventAfter("Render", "Update");
+	manager->setThreadPool(&threadPool);
+
+	atomic<bool> isPhysicsStarted = false, isAudioStarted = false, isPhysicsDone = false;
+	atomic<bool> isOverlapped = true, isAfterValid = false, isReadValid = false;
+
+	manager->subscribeToEvent("Update", [&]() { isAfterValid = isPhysicsDone.load(); },
+		ComponentAccess().read<>().after<TestSystem>());
+	manager->subscribeToEvent("Update", [&]()
+	{
+		isPhysicsStarted = true;
+		if (!waitForFlag(isAudioStarted))
+			isOverlapped = false;
+		isPhysicsDone = true;
+	}, ComponentAccess().write<TestComponent>().setSystem(getTypeIndex<TestSystem>()));
+	manager->subscribeToEvent("Render", [&]()
+	{
+		isAudioStarted = true;
+		if (!waitForFlag(isPhysicsStarted))
+			isOverlapped = false;
+	}, ComponentAccess().write<PositionComponent>());
+	manager->subscribeToEvent("Render", [&]() { isReadValid = isPhysicsDone.load(); },
+		ComponentAccess().read<TestComponent>());
+
+	manager->runSchedule();
+
+	if (!isOverlapped)
+		throw runtime_error("Independent subscribers are not executed in parallel.");
+	if (!isAfterValid)
+		throw runtime_error("Subscriber is executed before the dependency system.");
+	if (!isReadValid)
+		throw runtime_error("Reader is executed before the writer.");
+
+	const auto& nodes = manager->getScheduleNodes();
+	if (nodes.size() != 4 || manager->getScheduleEdges().size() != 2 || nodes[1].cost <= 0.0)
+		throw runtime_error("Bad schedule graph.");
+
+	auto graph = manager->getScheduleGraph();
+	if (graph.find("n1 -> n3 [label=\"read") == string::npos || graph.find("n1 -> n0 [label=\"after") == string::npos)
+		throw runtime_error("Bad schedule graph dump.");
+
+	manager->setThreadPool(nullptr);
+	isPhysicsStarted = isAudioStarted = isPhysicsDone = false;
+	isAfterValid = isReadValid = false;
+	manager->unsubscribeFromEvent("Render", manager->getEventSubscribers("Render")[0]);
+	manager->runSchedule();
+
+	if (!isAfterValid || !isReadValid || manager->getScheduleNodes().size() != 3)
+		throw runtime_error("Bad sequential schedule order.");
+
+	manager->subscribeToEvent("Update", []() { },
+		ComponentAccess().write<TestComponent>().after<PositionSystem>().setSystem(getTypeIndex<TestSystem>()));
+	manager->subscribeToEvent("Update", []() { },
+		ComponentAccess().write<TestComponent>().setSystem(getTypeIndex<PositionSystem>()));
+
+	auto isCycleFound = false;
+	try { manager->runSchedule(); }
+	catch (const EcsmError&) { isCycleFound = true; }
+
+	if (!isCycleFound)
+		throw runtime_error("Schedule dependency cycle is not detected.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testEventHandles()
+{
+	auto manager = new Manager();
+	auto customEvent = manager->registerEvent("Custom");
+	auto orderedEvent = manager->registerEventBefore("PreUpdate", "Update");
+
+	if (!customEvent || !orderedEvent || customEvent == orderedEvent)
+		throw runtime_error("Bad registered event handle.");
+	if (manager->getEventID("Custom") != customEvent || manager->getEvent(orderedEvent).name != "PreUpdate")
+		throw runtime_error("Bad event handle lookup.");
+
+	uint32_t runCount = 0;
+	manager->subscribeToEvent("Custom", [&]() { runCount++; });
+	for (uint32_t i = 0; i < 10; i++)
+		manager->runEvent(customEvent);
+	manager->runEvent("Custom");
+
+	if (runCount != 11)
+		throw runtime_error("Bad event handle run count.");
+
+	auto isThrown = false;
+	try { manager->registerEventAfter("Orphan", "Missing"); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown || manager->hasEvent("Orphan"))
+		throw runtime_error("Event is registered after the failed order lookup.");
+
+	manager->unregisterEvent("Custom");
+	isThrown = false;
+	try { manager->runEvent(customEvent); }
+	catch (const EcsmError&) { isThrown = true; }
+
+	if (!isThrown || manager->hasEvent("Custom"))
+		throw runtime_error("Unregistered event handle is valid.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+struct DelegateCounter final
+{
+	uint32_t count = 0;
+	void increment() { count++; }
+};
+
+static uint32_t delegateFunctionCount = 0;
+static void incrementDelegateFunction() { delegateFunctionCount++; }
+
+static void testDelegates()
+{
+	auto manager = new Manager();
+	manager->registerEvent("Custom");
+
+	DelegateCounter counterA, counterB;
+	auto delegateA = Delegate::create<&DelegateCounter::increment>(&counterA);
+	auto delegateB = Delegate::create<&DelegateCounter::increment>(&counterB);
+	if (delegateA == delegateB || delegateA != Delegate::create<&DelegateCounter::increment>(&counterA))
+		throw runtime_error("Bad delegate identity.");
+
+	uint32_t functionCount = 0;
+	manager->subscribeToEvent("Custom", delegateA);
+	manager->subscribeToEvent("Custom", delegateB);
+	manager->subscribeToEvent("Custom", Delegate::create<&incrementDelegateFunction>());
+	auto functionDelegate = manager->subscribeToEvent("Custom", [&]() { functionCount++; });
+	manager->runEvent("Custom");
+
+	manager->unsubscribeFromEvent("Custom", delegateB);
+	manager->unsubscribeFromEvent("Custom", functionDelegate);
+	manager->runEvent("Custom");
+
+	if (counterA.count != 2 || counterB.count != 1 || delegateFunctionCount != 2 || functionCount != 1)
+		throw runtime_error("Bad delegate call count.");
+	if (manager->getEventSubscribers("Custom").size() != 2 || manager->tryUnsubscribeFromEvent("Custom", delegateB))
+		throw runtime_error("Bad delegate unsubscribe.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testBatchCreation()
+{
+	LinearPool<DelayedItem> pool;
+	vector<ID<DelayedItem>> items(10);
+	for (uint32_t i = 0; i < 4; i++)
+		items[i] = pool.create();
+	auto freeItem = items[1];
+	pool.destroy(freeItem);
+	pool.dispose();
+	pool.createMany(items.data(), (uint32_t)items.size());
+
+	if (*items[0] != *freeItem || pool.getCount() != 13 || pool.getOccupancy() != 13 || !pool.isLive(items[9]))
+		throw runtime_error("Bad linear pool batch creation.");
+
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+	manager->createSystem<ChunkedSystem>();
+	manager->createSystem<PositionSystem>();
+
+	const uint32_t entityCount = 100;
+	auto entities = manager->createEntities(entityCount);
+	manager->add<TestComponent>(entities);
+	manager->add<ChunkedComponent>(entities.data(), entityCount / 2);
+	manager->add<PositionComponent>(entities.data() + entityCount / 2, entityCount / 2);
+
+	if (manager->getEntities().getCount() != entityCount)
+		throw runtime_error("Bad batch created entity count.");
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		auto entity = entities[i];
+		if (manager->get<TestComponent>(entity)->getEntity() != entity ||
+			manager->has<ChunkedComponent>(entity) != (i < entityCount / 2) ||
+			manager->has<PositionComponent>(entity) == (i < entityCount / 2))
+		{
+			throw runtime_error("Bad batch added component.");
+		}
+	}
+	if (manager->query<TestComponent, ChunkedComponent>().getCount() != entityCount / 2)
+		throw runtime_error("Bad batch added component query.");
+
+	auto isThrown = false;
+	try { manager->add<ChunkedComponent>(entities.data() + entityCount / 2 - 1, 2); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown || manager->has<ChunkedComponent>(entities[entityCount / 2]))
+		throw runtime_error("Batch add did not check existing components.");
+
+	manager->destroy(entities);
+	manager->disposeEntities();
+
+	if (manager->getEntities().getCount() != 0 || manager->query<TestComponent, ChunkedComponent>().getCount() != 0)
+		throw runtime_error("Bad batch destroyed entity count.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+struct NamedComponent final : public Component
+{
+	string name;
+};
+class NamedSystem final : public ComponentSystem<NamedComponent, false>
+{
+	friend class ecsm::Manager;
+};
+
+static void testPrefabs()
+{
+	auto manager = new Manager();
+	createIndexedSystems(manager, std::make_integer_sequence<int, 12>());
+	manager->createSystem<PositionSystem>();
+	manager->createSystem<NamedSystem>();
+	manager->createSystem<DoNotDuplicateSystem>();
+
+	auto templateEntity = manager->createEntity();
+	addIndexedComponents(manager, templateEntity, std::make_integer_sequence<int, 12>());
+	manager->add<PositionComponent>(templateEntity)->x = 2.0f;
+	manager->add<NamedComponent>(templateEntity)->name = "Prefab";
+	auto& query = manager->query<IndexedComponent<0>, PositionComponent>();
+
+	auto prefab = manager->createPrefab(templateEntity);
+	if (prefab.getComponents().size() != 14 || prefab.getEntity() != templateEntity)
+		throw runtime_error("Bad prefab component layout.");
+
+	const uint32_t entityCount = 100;
+	auto instances = manager->instantiate(prefab, entityCount);
+	for (auto instance : instances)
+	{
+		if (!checkIndexedComponents(manager, instance, std::make_integer_sequence<int, 12>()))
+			throw runtime_error("Bad prefab indexed component data.");
+
+		auto positionView = manager->get<PositionComponent>(instance);
+		auto namedView = manager->get<NamedComponent>(instance);
+		if (positionView->x != 2.0f || namedView->name != "Prefab" || namedView->getEntity() != instance ||
+			manager->get<IndexedComponent<11>>(instance)->getEntity() != instance)
+		{
+			throw runtime_error("Bad prefab instance component.");
+		}
+	}
+	if (query.getCount() != entityCount + 1)
+		throw runtime_error("Prefab instances are not added to the query.");
+
+	auto duplicateEntity = manager->duplicate(templateEntity);
+	if (manager->get<NamedComponent>(duplicateEntity)->getEntity() != duplicateEntity)
+		throw runtime_error("Duplicate component has source entity.");
+
+	manager->add<DoNotDuplicateComponent>(templateEntity);
+	auto isThrown = false;
+	try { manager->createPrefab(templateEntity); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown)
+		throw runtime_error("Prefab is created from the do not duplicate entity.");
+	if (!manager->get<IndexedSystem<0>>()->canBulkCopy())
+		throw runtime_error("Not overridden component copy is not bulk.");
+	delete manager;
+
+	manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+
+	int counter = 0;
+	templateEntity = manager->createEntity();
+	auto testView = manager->add<TestComponent>(templateEntity);
+	testView->ID = 7;
+	testView->counter = &counter;
+
+	instances = manager->instantiate(manager->createPrefab(templateEntity), entityCount);
+	if (manager->get<TestSystem>()->canBulkCopy())
+		throw runtime_error("Overridden component copy is bulk.");
+	for (auto instance : instances)
+	{
+		testView = manager->get<TestComponent>(instance);
+		if (testView->ID != 7 || testView->counter || testView->getEntity() != instance)
+			throw runtime_error("Prefab instance is not copied with the overridden copy.");
+	}
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static uint32_t addTenCapacity(uint32_t, uint32_t requiredCapacity) noexcept
+{
+	return requiredCapacity + 10;
+}
+
+static void testPoolCapacity()
+{
+	LinearPool<DelayedItem> pool;
+	pool.reserve(100);
+	auto data = pool.getData();
+
+	vector<ID<DelayedItem>> items(100);
+	pool.createMany(items.data(), (uint32_t)items.size());
+	if (pool.getData() != data || pool.getCapacity() != 100)
+		throw runtime_error("Reserved pool memory has been reallocated.");
+
+	for (uint32_t i = 40; i < 100; i++)
+		pool.destroy(items[i]);
+	pool.destroy(items[10]);
+	pool.dispose();
+	pool.shrinkToFit();
+
+	if (pool.getOccupancy() != 40 || pool.getCapacity() != 40 || pool.getCount() != 39 || !pool.isLive(items[39]))
+		throw runtime_error("Bad pool state after shrink.");
+
+	pool.setGrowthPolicy(addTenCapacity);
+	if (*pool.create() != *items[10] || *pool.create() != *items[40])
+		throw runtime_error("Bad pool item reuse after shrink.");
+	if (pool.getCapacity() != 51)
+		throw runtime_error("Pool growth policy is not used.");
+
+	pool.reserve(64);
+	pool.clear();
+	if (pool.getCapacity() != 64 || pool.getCount() != 0)
+		throw runtime_error("Pool clear did not keep reserved memory.");
+
+	ChunkedPool<DelayedItem, true, 4> chunkedPool;
+	chunkedPool.reserve(10);
+	vector<ID<DelayedItem>> chunkedItems(10);
+	chunkedPool.createMany(chunkedItems.data(), (uint32_t)chunkedItems.size());
+	if (chunkedPool.getChunks().size() != 3)
+		throw runtime_error("Bad chunked pool reserved chunk count.");
+
+	for (uint32_t i = 3; i < 10; i++)
+		chunkedPool.destroy(chunkedItems[i]);
+	chunkedPool.dispose();
+	chunkedPool.shrinkToFit();
+	if (chunkedPool.getChunks().size() != 1 || chunkedPool.getOccupancy() != 3)
+		throw runtime_error("Bad chunked pool state after shrink.");
+
+	auto manager = new Manager();
+	manager->createSystem<ChunkedSystem>();
+	manager->reserveEntities(1000);
+	manager->reserveComponents<ChunkedComponent>(1000);
+
+	if (manager->getEntities().getCapacity() != 1000 ||
+		manager->get<ChunkedSystem>()->getComponents().getCapacity() != 1000)
+	{
+		throw runtime_error("Bad manager reserved capacity.");
+	}
+
+	auto entities = manager->createEntities(10);
+	manager->add<ChunkedComponent>(entities);
+	manager->shrinkToFit();
+
+	if (manager->getEntities().getCapacity() != 10 ||
+		manager->get<ChunkedSystem>()->getComponents().getCapacity() != 12)
+	{
+		throw runtime_error("Bad manager capacity after shrink.");
+	}
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+class CountingMemoryResource final : public std::pmr::memory_resource
+{
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		allocatedSize += bytes;
+		allocationCount++;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		allocatedSize -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+public:
+	size_t allocatedSize = 0;
+	size_t allocationCount = 0;
+};
+
+static void testMemoryResource()
+{
+	CountingMemoryResource memoryResource;
+	auto manager = new Manager(true, &memoryResource);
+	createIndexedSystems(manager, std::make_integer_sequence<int, 12>());
+	manager->createSystem<ChunkedSystem>();
+
+	auto allocationCount = memoryResource.allocationCount;
+	if (allocationCount == 0 || manager->getMemoryResource() != &memoryResource)
+		throw runtime_error("Manager tables are not using memory resource.");
+	if (manager->get<ChunkedSystem>()->getComponents().getMemoryResource() != &memoryResource)
+		throw runtime_error("Component pool is not using memory resource.");
+
+	auto entities = manager->createEntities(10);
+	for (auto entity : entities)
+		addIndexedComponents(manager, entity, std::make_integer_sequence<int, 12>()); // Heap component array.
+	manager->add<ChunkedComponent>(entities);
+
+	if (memoryResource.allocationCount == allocationCount || 
+		!checkIndexedComponents(manager, entities[9], std::make_integer_sequence<int, 12>()))
+	{
+		throw runtime_error("Entities are not using memory resource.");
+	}
+
+	delete manager;
+
+	if (memoryResource.allocatedSize != 0)
+		throw runtime_error("Manager memory is not returned to the memory resource.");
+}
+
+//**********************************************************************************************************************
+static int liveTrackedItems = 0;
+
+struct TrackedItem final
+{
+	std::string data;
+
+	TrackedItem() { liveTrackedItems++; }
+	TrackedItem(const std::string& data) : data(data) { liveTrackedItems++; }
+	TrackedItem(TrackedItem&& other) noexcept : data(std::move(other.data)) { liveTrackedItems++; }
+	TrackedItem& operator=(TrackedItem&&) = delete;
+	~TrackedItem() { liveTrackedItems--; }
+	bool destroy() { return true; }
+};
+
+static void testPoolConstruction()
+{
+	{
+		LinearPool<TrackedItem> pool;
+		pool.reserve(16);
+		if (liveTrackedItems != 0)
+			throw runtime_error("Reserved pool items are constructed.");
+
+		vector<ID<TrackedItem>> items(20);
+		for (uint32_t i = 0; i < 20; i++)
+			items[i] = pool.create(std::to_string(i));
+		if (liveTrackedItems != 20)
+			throw runtime_error("Bad pool constructed item count.");
+
+		pool.destroy(items[3]);
+		pool.dispose();
+		if (liveTrackedItems != 19)
+			throw runtime_error("Disposed pool item is not destructed.");
+
+		pool.create(); // Reallocation with a free item hole.
+		for (uint32_t i = 0; i < 20; i++)
+			pool.create();
+		if (liveTrackedItems != 40 || pool.get(items[19])->data != "19")
+			throw runtime_error("Bad pool items after reallocation.");
+
+		pool.clear();
+		if (liveTrackedItems != 0)
+			throw runtime_error("Cleared pool items are not destructed.");
+		pool.create("a");
+	}
+	if (liveTrackedItems != 0)
+		throw runtime_error("Pool items are not destructed.");
+
+	{
+		ChunkedPool<TrackedItem, true, 4> pool;
+		pool.reserve(8);
+		auto item = pool.create("a");
+		pool.create("b");
+		if (liveTrackedItems != 2)
+			throw runtime_error("Reserved chunked pool items are constructed.");
+
+		pool.destroy(item);
+		pool.dispose();
+		if (liveTrackedItems != 1)
+			throw runtime_error("Disposed chunked pool item is not destructed.");
+		pool.clear();
+		pool.create("c");
+	}
+	if (liveTrackedItems != 0)
+		throw runtime_error("Chunked pool items are not destructed.");
+}
+
+//**********************************************************************************************************************
+static void testPoolRefs()
+{
+	LinearPool<DelayedItem> pool;
+	vector<ID<DelayedItem>> items(2000);
+	pool.createMany(items.data(), (uint32_t)items.size());
+
+	auto heapRef = Ref<DelayedItem>(items[0]);
+	auto heapRefCopy = heapRef;
+	if (heapRef.getRefCount() != 2 || heapRef != items[0] || *pool.get(heapRef) != *pool.get(items[0]))
+		throw runtime_error("Bad item reference state.");
+
+	{
+		auto ref = pool.getRef(items[1500]);
+		auto refCopy = ref;
+		PoolRef<DelayedItem> movedRef = std::move(refCopy);
+		if (ref.getRefCount() != 2 || pool.getRefCount(items[1500]) != 2 || refCopy || ID<DelayedItem>(ref) !=
+			items[1500] || *pool.get(movedRef) != *pool.get(items[1500]))
+		{
+			throw runtime_error("Bad pool item reference state.");
+		}
+
+		pool.create(); // Reallocation does not invalidate counters.
+		ref = pool.getRef(items[1]);
+		if (!movedRef.isLastRef() || pool.getRefCount(items[1]) != 1)
+			throw runtime_error("Bad pool item reference count after reassignment.");
+	}
+	if (pool.getRefCount(items[1500]) != 0 || pool.getRefCount(items[1]) != 0)
+		throw runtime_error("Pool item reference counter is not decremented.");
+
+	auto ref = pool.getRef<false>(items[3]);
+	vector<PoolRef<DelayedItem, false>> refs(10, ref);
+	if (pool.getRefCount(items[3]) != 11 || ref.getRefCount() != 11)
+		throw runtime_error("Bad non-atomic pool item reference count.");
+	refs.clear();
+	if (!ref.isLastRef())
+		throw runtime_error("Bad non-atomic pool item reference count after clear.");
+
+	ChunkedPool<DelayedItem, true, 4> chunkedPool;
+	auto chunkedItem = chunkedPool.create();
+	auto chunkedRef = chunkedPool.getRef(chunkedItem);
+	if (chunkedPool.getRefCount(chunkedItem) != 1 || *chunkedPool.get(chunkedRef) != *chunkedPool.get(chunkedItem))
+		throw runtime_error("Bad chunked pool item reference state.");
+
+	{
+		auto disposedRef = pool.getRef(items[5]);
+		disposedRef = {};
+	}
+	pool.destroy(items[5]);
+	pool.dispose();
+	auto reusedItem = pool.create();
+	if (*reusedItem != *items[5] || pool.getRefCount(reusedItem) != 0 || pool.getRef(reusedItem).getRefCount() != 1)
+		throw runtime_error("Bad reused pool item reference count.");
+
+	auto reusedRef = pool.getRef(reusedItem);
+	if (pool.getRefCount(items[5]) != 0 || pool.getRefCount(reusedItem) != 1)
+		throw runtime_error("Stale pool item shares reused item reference count.");
+	#if defined(NDEBUG) && defined(ECSM_CHECK_GENERATIONS)
+	if (pool.getRef(items[5]) || pool.getRefCount(reusedItem) != 1)
+		throw runtime_error("Stale pool item reference is not null in release build.");
+	#endif
+}
+
+//**********************************************************************************************************************
+static void testStaleIDs()
+{
+	LinearPool<DelayedItem> pool;
+	auto item = pool.create();
+	auto otherItem = pool.create();
+	auto view = pool.get(otherItem);
+	pool.destroy(item);
+
+	if (!pool.isValid(item) || !pool.tryGet(item) || pool.isLive(item))
+		throw runtime_error("Bad destroyed pool item state.");
+
+	pool.dispose();
+	view->delayCount = 1; // Unrelated item destroy does not invalidate views.
+	auto newItem = pool.create();
+
+	if (*newItem != *item || newItem.getGeneration() == item.getGeneration() || newItem == item)
+		throw runtime_error("Bad reused pool item generation.");
+	if (pool.isValid(item) || pool.tryGet(item) || pool.isLive(item) || !pool.isValid(newItem))
+		throw runtime_error("Stale pool item is not detected.");
+	#if defined(NDEBUG) && defined(ECSM_CHECK_GENERATIONS)
+	if (pool.get(item) || !pool.get(newItem))
+		throw runtime_error("Stale pool item view is not null in release build.");
+	#endif
+
+	pool.destroy(item); // Stale identifier is ignored.
+	if (!pool.isLive(newItem) || pool.getID(*pool.get(newItem)) != newItem)
+		throw runtime_error("Bad pool item state after stale destroy.");
+
+	pool.clear();
+	if (*pool.create() != *newItem || pool.isValid(newItem))
+		throw runtime_error("Stale pool item is not detected after clear.");
+
+	ChunkedPool<DelayedItem, true, 4> chunkedPool;
+	auto chunkedItem = chunkedPool.create();
+	chunkedPool.destroy(chunkedItem);
+	chunkedPool.dispose();
+	if (chunkedPool.isValid(chunkedItem) || !chunkedPool.isValid(chunkedPool.create()))
+		throw runtime_error("Stale chunked pool item is not detected.");
+
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+	auto entity = manager->createEntity();
+	manager->destroy(entity);
+	manager->disposeEntities();
+	auto newEntity = manager->createEntity();
+
+	auto isThrown = false;
+	try { manager->add<TestComponent>(entity); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown || manager->isValid(entity) || !manager->isValid(newEntity) || manager->has<TestComponent>(newEntity))
+		throw runtime_error("Stale entity is not detected.");
+
+	// Stale entity component access is checked in release build too. (Slot is reused by the new entity)
+	manager->add<TestComponent>(newEntity);
+	auto testSystem = manager->get<TestSystem>();
+	if (manager->has<TestComponent>(entity) || manager->tryGet<TestComponent>(entity) ||
+		manager->tryGetID<TestComponent>(entity) || manager->getComponentCount(entity) != 0 ||
+		testSystem->hasComponent(entity) || testSystem->tryGetComponent(entity))
+	{
+		throw runtime_error("Stale entity component is accessible.");
+	}
+
+	isThrown = false;
+	try { manager->get<TestComponent>(entity); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown || !manager->has<TestComponent>(newEntity))
+		throw runtime_error("Stale entity component get is not detected.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testCommandBuffers()
+{
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+
+	auto sourceEntity = manager->createEntity();
+	auto sourceView = manager->add<TestComponent>(sourceEntity);
+	sourceView->ID = 1337;
+	auto removedEntity = manager->createEntity();
+	manager->add<TestComponent>(removedEntity);
+	auto destroyedEntity = manager->createEntity();
+
+	const uint32_t entityCount = 1000;
+	ThreadPool threadPool(4);
+	threadPool.parallelFor(entityCount, [manager](uint32_t begin, uint32_t end)
+	{
+		auto& commandBuffer = manager->getCommandBuffer();
+		for (uint32_t i = begin; i < end; i++)
+		{
+			commandBuffer.setSortKey(i);
+			auto entity = commandBuffer.createEntity();
+			commandBuffer.add<TestComponent>(entity, [i](TestComponent& component) { component.ID = (int)i; });
+		}
+	}, 10);
+
+	auto& commandBuffer = manager->getCommandBuffer();
+	commandBuffer.setSortKey(entityCount);
+	auto copyEntity = commandBuffer.createEntity();
+	commandBuffer.add<TestComponent>(copyEntity);
+	commandBuffer.copy<TestComponent>(sourceEntity, copyEntity);
+	commandBuffer.remove<TestComponent>(removedEntity);
+	commandBuffer.destroy(destroyedEntity);
+
+	if (manager->getEntities().getCount() != 3 || commandBuffer.getCommandCount() < 5)
+		throw runtime_error("Command buffer changed manager before execution.");
+
+	manager->executeCommands();
+
+	const auto& entities = manager->getEntities();
+	if (entities.getCount() != entityCount + 4 || !commandBuffer.isEmpty() || 
+		manager->has<TestComponent>(removedEntity) || entities.isLive(destroyedEntity))
+	{
+		throw runtime_error("Bad manager state after command execution.");
+	}
+
+	for (uint32_t i = 0; i <= entityCount; i++)
+	{
+		auto entity = entities.getID(entities.getData() + 3 + i); // Entities are created in sort key order.
+		auto componentView = manager->tryGet<TestComponent>(entity);
+		if (!componentView || componentView->ID != (i < entityCount ? (int)i : 1337))
+			throw runtime_error("Bad deferred entity component data.");
+	}
+
+	commandBuffer.add<TestComponent>(sourceEntity); // Already added.
+	auto isThrown = false;
+	try { manager->executeCommands(); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown || !commandBuffer.isEmpty())
+		throw runtime_error("Bad command buffer state after failed execution.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testReadPhase()
+{
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+
+	const uint32_t entityCount = 1000;
+	auto entities = manager->createEntities(entityCount);
+	manager->add<TestComponent>(entities);
+	for (uint32_t i = 0; i < entityCount; i++)
+		manager->get<TestComponent>(entities[i])->ID = (int)i;
+
+	atomic<int64_t> idSum = 0;
+	{
+		Manager::ReadScope readScope(manager);
+		ThreadPool threadPool(4);
+		threadPool.parallelFor(entityCount, [manager, &entities, &idSum](uint32_t begin, uint32_t end)
+		{
+			const Manager* readManager = manager;
+			for (uint32_t i = begin; i < end; i++)
+			{
+				if (readManager->has<TestComponent>(entities[i]))
+					idSum += readManager->get<TestComponent>(entities[i])->ID;
+			}
+		}, 10);
+
+		if (manager->getReaderCount() != 1)
+			throw runtime_error("Bad manager reader count.");
+
+		auto isThrown = false;
+		try { manager->createEntity(); }
+		catch (const EcsmError&) { isThrown = true; }
+		if (!isThrown)
+			throw runtime_error("Manager change inside read phase is not detected.");
+
+		isThrown = false;
+		try { manager->query<TestComponent>(); }
+		catch (const EcsmError&) { isThrown = true; }
+		if (!isThrown)
+			throw runtime_error("Query creation inside read phase is not detected.");
+
+		#ifndef NDEBUG
+		ChangeState changeState;
+		changeState = true;
+		auto isOtherThread = false;
+		std::thread([&]() { isOtherThread = changeState.isOtherThread(); }).join();
+		if (!isOtherThread || changeState.isOtherThread() || !changeState)
+			throw runtime_error("Bad other thread change state.");
+		#endif
+	}
+
+	if (idSum != (int64_t)entityCount * (entityCount - 1) / 2 || manager->getReaderCount() != 0)
+		throw runtime_error("Bad concurrent component read result.");
+
+	manager->prepareQuery<TestComponent>();
+	atomic<uint32_t> queryCount = 0;
+	{
+		Manager::ReadScope readScope(manager);
+		ThreadPool threadPool(4);
+		threadPool.parallelFor(4, [manager, &queryCount](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+				manager->each<TestComponent>([&queryCount](ID<Entity>, TestComponent&) { queryCount++; });
+		}, 1);
+	}
+	if (queryCount != entityCount * 4)
+		throw runtime_error("Bad prepared query iteration inside read phase.");
+	manager->createEntity();
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testProfiler()
+{
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+
+	Profiler profiler;
+	manager->setProfiler(&profiler);
+	manager->initialize();
+	manager->update();
+
+	auto updateStats = profiler.getStats("Update");
+	if (!updateStats || updateStats->count != 1 || !profiler.getStats("Update #0") ||
+		!profiler.getStats("Frame") || !profiler.getStats("Dispose Entities"))
+	{
+		throw runtime_error("Manager update samples are not recorded.");
+	}
+	if (updateStats->minTime > updateStats->maxTime || updateStats->getAverageTime() != updateStats->totalTime)
+		throw runtime_error("Bad profiler sample stats.");
+
+	auto hasEntityCounter = false;
+	for (const auto& counter : profiler.getCounters())
+		hasEntityCounter |= counter.name == "Entities";
+	if (!hasEntityCounter || profiler.getGrowthCount() != 0)
+		throw runtime_error("Entity pool counter is not recorded.");
+
+	manager->createEntities(1000);
+	manager->update();
+
+	if (profiler.getGrowthCount() == 0 || profiler.getStats("Update")->count != 2)
+		throw runtime_error("Entity pool growth is not detected.");
+
+	auto trace = profiler.getChromeTrace();
+	if (trace.find("\"traceEvents\"") == string::npos || trace.find("\"ph\":\"X\"") == string::npos ||
+		trace.find("\"ph\":\"C\"") == string::npos || trace.find("\"Entities Growth\"") == string::npos)
+	{
+		throw runtime_error("Bad profiler Chrome trace.");
+	}
+
+	auto sampleCount = profiler.getSamples().size();
+	manager->setProfiler(nullptr);
+	manager->update();
+	if (profiler.getSamples().size() != sampleCount)
+		throw runtime_error("Detached profiler still records samples.");
+
+	profiler.clear();
+	if (!profiler.getSamples().empty() || profiler.getStats("Update"))
+		throw runtime_error("Profiler is not cleared.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testSnapshot()
+{
+	LinearPool<TestComponent> linearPool;
+	vector<ID<TestComponent>> items(100);
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		items[i] = linearPool.create();
+		linearPool.get(items[i])->ID = (int)i;
+	}
+	for (uint32_t i = 0; i < 100; i += 3)
+		linearPool.destroy(items[i]);
+	linearPool.dispose();
+
+	SnapshotWriter poolWriter;
+	linearPool.writeSnapshot(poolWriter);
+	ChunkedPool<TestComponent, true, 16> chunkedPool;
+	SnapshotReader poolReader(poolWriter.getData().data(), poolWriter.getData().size());
+	chunkedPool.readSnapshot(poolReader);
+
+	if (!poolReader.isEnd() || chunkedPool.getLiveCount() != linearPool.getLiveCount() ||
+		chunkedPool.getOccupancy() != linearPool.getOccupancy())
+	{
+		throw runtime_error("Bad pool snapshot item count.");
+	}
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		auto isLive = i % 3 != 0;
+		if (chunkedPool.isLive(ID<TestComponent>(items[i])) != isLive ||
+			(isLive && chunkedPool.get(items[i])->ID != (int)i))
+		{
+			throw runtime_error("Bad pool snapshot item.");
+		}
+	}
+	if (*chunkedPool.create() != *linearPool.create())
+		throw runtime_error("Bad pool snapshot free item.");
+
+	linearPool.setTrackingChanges(true);
+	linearPool.markChanged(items[1]);
+	auto isPoolThrown = false;
+	SnapshotReader truncatedPoolReader(poolWriter.getData().data(), poolWriter.getData().size() / 2);
+	try { linearPool.readSnapshot(truncatedPoolReader); }
+	catch (const EcsmError&) { isPoolThrown = true; }
+	if (!isPoolThrown || linearPool.getCount() != 0 || linearPool.getChangeCount() != 0)
+		throw runtime_error("Bad pool state after truncated snapshot read.");
+
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+	manager->initialize();
+
+	auto entities = manager->createEntities(1000);
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		if (i % 2 == 0)
+			manager->add<TestComponent>(entities[i])->someData = (float)i;
+	}
+	manager->destroy(entities[10]);
+	manager->destroy(entities[11]);
+
+	auto isThrown = false;
+	SnapshotWriter writer;
+	try { manager->writeSnapshot(writer); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown)
+		throw runtime_error("Snapshot with pending garbage is not detected.");
+
+	manager->update();
+	writer.clear();
+	manager->writeSnapshot(writer);
+
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		if (i != 10 && i != 11)
+			manager->destroy(entities[i]);
+	}
+	manager->createEntities(10);
+	manager->update();
+	auto& query = manager->query<TestComponent>();
+
+	const auto& data = writer.getData();
+	SnapshotReader reader(data.data(), data.size());
+	manager->readSnapshot(reader);
+
+	if (!reader.isEnd() || manager->getEntities().getCount() != 998 || query.getCount() != 499)
+		throw runtime_error("Bad manager snapshot entity count.");
+	for (uint32_t i = 0; i < 1000; i++)
+	{
+		if (i == 10 || i == 11)
+		{
+			if (manager->getEntities().isLive(entities[i]))
+				throw runtime_error("Destroyed entity is restored from the snapshot.");
+			continue;
+		}
+
+		auto hasComponent = manager->has<TestComponent>(entities[i]);
+		if (hasComponent != (i % 2 == 0) || (hasComponent &&
+			manager->get<TestComponent>(entities[i])->someData != (float)i))
+		{
+			throw runtime_error("Bad manager snapshot entity component.");
+		}
+	}
+
+	manager->remove<TestComponent>(entities[0]);
+	manager->destroy(entities[2]);
+	manager->update();
+	if (query.getCount() != 497 || manager->has<TestComponent>(entities[0]))
+		throw runtime_error("Bad manager state after snapshot read.");
+
+	isThrown = false;
+	SnapshotReader truncatedReader(data.data(), data.size() / 2);
+	try { manager->readSnapshot(truncatedReader); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown)
+		throw runtime_error("Truncated snapshot is not detected.");
+
+	reader = SnapshotReader(data.data(), data.size());
+	manager->readSnapshot(reader);
+	if (query.getCount() != 499)
+		throw runtime_error("Bad manager snapshot read after failure.");
+
+	manager->setTrackingChanges(true);
+	manager->add<TestComponent>(entities[1]);
+	manager->remove<TestComponent>(entities[4]);
+	if (manager->getAddedComponents().empty() || !manager->hasPendingGarbage())
+		throw runtime_error("Bad manager pending state before snapshot read.");
+
+	reader = SnapshotReader(data.data(), data.size());
+	manager->readSnapshot(reader);
+	if (!manager->getAddedComponents().empty() || !manager->getRemovedComponents().empty() ||
+		manager->hasPendingGarbage() || !manager->has<TestComponent>(entities[4]))
+	{
+		throw runtime_error("Replaced world pending state is kept after snapshot read.");
+	}
+	manager->update();
+	if (!manager->has<TestComponent>(entities[4]) || manager->has<TestComponent>(entities[1]))
+		throw runtime_error("Replaced world garbage is disposed after snapshot read.");
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testChangeTracking()
+{
+	LinearPool<TestComponent> pool;
+	pool.setTrackingChanges(true);
+	vector<ID<TestComponent>> items(10);
+	for (uint32_t i = 0; i < 10; i++)
+		items[i] = pool.create();
+
+	pool.setChangeVersion(2);
+	pool.markChanged(items[3]);
+	pool.markChanged(items[3]);
+	pool.markChanged(items[5]);
+	pool.destroy(items[5]);
+
+	vector<ID<TestComponent>> changedItems;
+	pool.eachChanged(1, [&](ID<TestComponent> instance, TestComponent&) { changedItems.push_back(instance); });
+	if (changedItems.size() != 1 || changedItems[0] != items[3] || pool.getChangeVersion(items[3]) != 2)
+		throw runtime_error("Bad pool changed items.");
+
+	changedItems.clear();
+	pool.eachChanged(0, [&](ID<TestComponent> instance, TestComponent&) { changedItems.push_back(instance); });
+	if (changedItems.size() != 9)
+		throw runtime_error("Bad pool changed item count.");
+
+	pool.clearChanges(1);
+	if (pool.getChangeCount() != 2)
+		throw runtime_error("Bad pool change count after clear.");
+
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+	manager->initialize();
+	manager->get<TestSystem>()->setTrackingChanges(true);
+	manager->setTrackingChanges(true);
+
+	auto entities = manager->createEntities(10);
+	manager->add<TestComponent>(entities);
+	if (manager->getAddedComponents().size() != 10 || manager->getAddedComponents()[0].second != entities[0])
+		throw runtime_error("Added components are not recorded.");
+
+	auto frameIndex = manager->getFrameIndex();
+	manager->update();
+	if (manager->getFrameIndex() != frameIndex + 1)
+		throw runtime_error("Bad manager frame index.");
+
+	manager->markChanged<TestComponent>(entities[1]);
+	manager->copy<TestComponent>(entities[1], entities[2]);
+
+	vector<ID<Entity>> changedEntities;
+	manager->getChangedEntities<TestComponent>(frameIndex, changedEntities);
+	if (changedEntities.size() != 2 || changedEntities[0] != entities[1] || changedEntities[1] != entities[2])
+		throw runtime_error("Bad changed component entities.");
+
+	changedEntities.clear();
+	manager->getChangedEntities<TestComponent>(0, changedEntities);
+	if (changedEntities.size() != 10)
+		throw runtime_error("Created components are not marked as changed.");
+
+	manager->clearComponentChanges();
+	manager->remove<TestComponent>(entities[3]);
+	manager->destroy(entities[4]);
+	if (manager->getRemovedComponents().size() != 1 || manager->getRemovedComponents()[0].second != entities[4])
+		throw runtime_error("Destroyed entity components are not recorded.");
+
+	manager->update();
+	if (manager->getRemovedComponents().size() != 2 || manager->getRemovedComponents()[1].second != entities[3])
+		throw runtime_error("Removed components are not recorded.");
+
+	manager->setTrackingChanges(false);
+	manager->destroy(entities[5]);
+	if (!manager->getRemovedComponents().empty())
+		throw runtime_error("Components are recorded with disabled tracking.");
+
+	delete manager;
+}
+
+class WorldSystem final : public ComponentSystem<TestComponent, false>, public Singleton<WorldSystem>
+{
+	WorldSystem() : Singleton(false)
+	{
+		ECSM_SUBSCRIBE_TO_EVENT("Update", WorldSystem::update);
+	}
+
+	void update()
+	{
+		if (Manager::Instance::get() != getManager() || WorldSystem::Instance::get() != this)
+			isContextValid = false;
+
+		for (auto& component : components)
+		{
+			if (!hasComponent(component.getEntity()))
+				isContextValid = false;
+			component.ID++;
+		}
+		updateCounter++;
+	}
+
+	friend class ecsm::Manager;
+public:
+	int updateCounter = 0;
+	bool isContextValid = true;
+
+	bool isDataValid(int value) const
+	{
+		for (const auto& component : components)
+		{
+			if (component.ID != value)
+				return false;
+		}
+		return true;
+	}
+};
+
+static void testMultipleWorlds()
+{
+	const uint32_t worldCount = 4, updateCount = 100;
+	vector<unique_ptr<Manager>> worlds;
+
+	for (uint32_t i = 0; i < worldCount; i++)
+	{
+		auto world = new Manager(false);
+		worlds.emplace_back(world);
+		world->createSystem<WorldSystem>();
+		world->initialize();
+
+		auto entities = world->createEntities(i + 1);
+		world->add<TestComponent>(entities);
+	}
+
+	if (Manager::Instance::tryGet() || Manager::getThreadCurrent())
+		throw runtime_error("Manager instance is set after world creation.");
+
+	vector<thread> threads;
+	for (uint32_t i = 0; i < worldCount; i++)
+	{
+		threads.emplace_back([world = worlds[i].get()]()
+		{
+			for (uint32_t j = 0; j < updateCount; j++)
+				world->update();
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	for (uint32_t i = 0; i < worldCount; i++)
+	{
+		auto system = worlds[i]->get<WorldSystem>();
+		if (!system->isContextValid)
+			throw runtime_error("Bad world system manager context.");
+		if (system->updateCounter != (int)updateCount)
+			throw runtime_error("Bad world system update count.");
+		if (system->getComponentCount() != i + 1)
+			throw runtime_error("Bad world component count.");
+		if (!system->isDataValid((int)updateCount))
+			throw runtime_error("Bad world component data.");
+	}
+
+	Manager::setThreadCurrent(worlds[0].get());
+	if (Manager::Instance::get() != worlds[0].get() || WorldSystem::Instance::get() != worlds[0]->get<WorldSystem>())
+		throw runtime_error("Bad thread current manager instance.");
+	Manager::setThreadCurrent(nullptr);
+
+	worlds.clear();
+	if (Manager::Instance::has())
+		throw runtime_error("Manager instance is set after world destruction.");
+}
+
+static void testStaticTypeIDs()
+{
+	auto typeID = getStaticTypeID<IndexedComponent<0>>();
+	if (typeID != getStaticTypeID<IndexedComponent<0>>() || typeID == getStaticTypeID<IndexedComponent<1>>())
+		throw runtime_error("Bad static type identifiers.");
+	if (typeID >= getStaticTypeCount() || typeID != allocateStaticTypeID(getTypeIndex<IndexedComponent<0>>()))
+		throw runtime_error("Static type identifier is not allocated by the library.");
+	if (getTypeIndex<const NamedComponent>() != getTypeIndex<NamedComponent>() ||
+		getTypeIndex<NamedComponent>() == getTypeIndex<PositionComponent>())
+	{
+		throw runtime_error("Bad type indices.");
+	}
+	if (typeToString<NamedComponent>().find("NamedComponent") == string::npos)
+		throw runtime_error("Bad type string.");
+
+	auto manager = new Manager();
+	createIndexedSystems(manager, std::make_integer_sequence<int, 4>());
+	manager->createSystem<PositionSystem>();
+	manager->createSystem<NamedSystem>();
+	manager->initialize();
+
+	auto system = manager->get<NamedSystem>();
+	if (system->getComponentStaticTypeID() != getStaticTypeID<NamedComponent>())
+		throw runtime_error("Bad system component static type identifier.");
+
+	auto entity = manager->createEntity();
+	manager->add<IndexedComponent<2>>(entity)->value = 3;
+	manager->add(entity, getTypeIndex<PositionComponent>());
+	manager->add<NamedComponent>(entity)->name = "Static";
+
+	if (!manager->has<IndexedComponent<2>>(entity) || manager->has<IndexedComponent<1>>(entity) ||
+		!manager->has(entity, getTypeIndex<NamedComponent>()) || !manager->has<PositionComponent>(entity))
+	{
+		throw runtime_error("Bad static type component check.");
+	}
+	if (manager->get<IndexedComponent<2>>(entity)->value != 3 ||
+		manager->getID<NamedComponent>(entity) != ID<NamedComponent>(
+		manager->getID(entity, getTypeIndex<NamedComponent>())))
+	{
+		throw runtime_error("Bad static type component access.");
+	}
+
+	manager->remove<NamedComponent>(entity);
+	if (!manager->isGarbage<NamedComponent>(entity) || manager->tryGet<NamedComponent>(entity))
+		throw runtime_error("Bad static type garbage component.");
+	manager->update();
+
+	manager->destroySystem<NamedSystem>();
+	if (manager->tryGetID<NamedComponent>(entity) || manager->has<NamedComponent>(entity))
+		throw runtime_error("Destroyed system component is found.");
+
+	auto isThrown = false;
+	try { manager->add<NamedComponent>(entity); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown)
+		throw runtime_error("Destroyed system component is added.");
+
+	delete manager;
+}
+
+static void testSystemLookup()
+{
+	auto manager = new Manager();
+	manager->createSystem<WorldSystem>();
+	manager->createSystem<NamedSystem>();
+
+	auto system = manager->get<WorldSystem>();
+	if (system != manager->get(getTypeIndex<WorldSystem>()) ||
+		system != manager->findSystem(getStaticTypeID<WorldSystem>()) || !manager->has<WorldSystem>())
+	{
+		throw runtime_error("Bad cached system lookup.");
+	}
+	if (WorldSystem::Instance::get() != system || !WorldSystem::Instance::has())
+		throw runtime_error("Bad cached system singleton.");
+	if (manager->tryGet<PositionSystem>() || manager->has<PositionSystem>())
+		throw runtime_error("Not created system is found.");
+
+	manager->destroySystem<WorldSystem>();
+	if (manager->tryGet<WorldSystem>() || WorldSystem::Instance::tryGet() || WorldSystem::Instance::has())
+		throw runtime_error("Destroyed system is found.");
+
+	auto isThrown = false;
+	try { manager->get<WorldSystem>(); }
+	catch (const EcsmError&) { isThrown = true; }
+	if (!isThrown)
+		throw runtime_error("Destroyed system is returned.");
+
+	if (!manager->tryDestroySystem<NamedSystem>() || manager->tryDestroySystem<NamedSystem>() ||
+		manager->has<NamedSystem>())
+	{
+		throw runtime_error("Bad system try destroy.");
+	}
+
+	manager->createSystem<WorldSystem>();
+	if (manager->get<WorldSystem>() != WorldSystem::Instance::get())
+		throw runtime_error("Bad recreated system lookup.");
+
+	delete manager;
+}
+
+struct ParticleComponent final : public Component { };
+
+class ParticleSystem final : public SoaComponentSystem<ParticleComponent, float, float, uint32_t>
+{
+	friend class ecsm::Manager;
+};
+
+static void testSoaComponents()
+{
+	auto manager = new Manager();
+	manager->createSystem<ParticleSystem>();
+	manager->initialize();
+
+	auto system = manager->get<ParticleSystem>();
+	auto& components = system->getComponents();
+	auto entities = manager->createEntities(100);
+	manager->add<ParticleComponent>(entities);
+
+	if (components.getCount() != 100 || manager->get<ParticleComponent>(entities[7])->getEntity() != entities[7])
+		throw runtime_error("Bad SoA component count or entity.");
+	if ((uintptr_t)components.getField<0>() % SoaStorage<ParticleComponent, float>::alignment != 0 ||
+		(uintptr_t)components.getField<2>() % SoaStorage<ParticleComponent, float>::alignment != 0)
+	{
+		throw runtime_error("Bad SoA field array alignment.");
+	}
+
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		system->getField<0>(entities[i]) = (float)i;
+		system->getField<2>(entities[i]) = i;
+	}
+	components.eachBatch([](uint32_t count, float* x, float* y, uint32_t*)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			y[i] = x[i] * 2.0f;
+	});
+	components.each([](float& x, float& y, uint32_t& index)
+	{
+		x += y;
+		index++;
+	});
+
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		if (system->getField<0>(entities[i]) != i * 3.0f || system->getField<2>(entities[i]) != i + 1)
+			throw runtime_error("Bad SoA component fields.");
+	}
+
+	manager->remove<ParticleComponent>(entities[10]);
+	manager->destroy(entities[20]);
+	if (!manager->isGarbage<ParticleComponent>(entities[10]) || components.getCount() != 100)
+		throw runtime_error("SoA component is disposed before update.");
+	if (system->hasComponent(entities[10]) || !system->hasComponent(entities[11]))
+		throw runtime_error("Bad SoA system component garbage state.");
+	manager->update();
+
+	if (components.getCount() != 98 || system->hasComponent(entities[10]) || system->hasComponent(entities[20]))
+		throw runtime_error("Bad SoA component dispose.");
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		if (i == 10 || i == 20)
+			continue;
+		if (system->getField<2>(entities[i]) != i + 1 || system->getField<1>(entities[i]) != i * 2.0f)
+			throw runtime_error("Bad SoA component fields after dispose.");
+	}
+
+	auto duplicate = manager->duplicate(entities[5]);
+	if (system->getField<0>(duplicate) != 15.0f || system->getField<2>(duplicate) != 6)
+		throw runtime_error("Bad SoA component duplicate.");
+
+	SnapshotWriter writer;
+	manager->writeSnapshot(writer);
+	system->getField<0>(duplicate) = -1.0f;
+	manager->remove<ParticleComponent>(entities[0]);
+	manager->update();
+
+	const auto& data = writer.getData();
+	SnapshotReader reader(data.data(), data.size());
+	manager->readSnapshot(reader);
+	system = manager->get<ParticleSystem>();
+	if (system->getComponents().getCount() != 99 || system->getField<0>(duplicate) != 15.0f ||
+		!system->hasComponent(entities[0]) || system->getField<2>(entities[0]) != 1)
+	{
+		throw runtime_error("Bad SoA component snapshot.");
+	}
+
+	delete manager;
+}
+
+//**********************************************************************************************************************
+static void testDisposeBudget()
+{
+	auto manager = new Manager();
+	manager->registerEventAfter("PostUpdate", "Update");
+	manager->createSystem<TestSystem>();
+	manager->initialize();
+
+	const uint32_t entityCount = 10;
+	int counter = entityCount;
+	auto entities = manager->createEntities(entityCount);
+	for (auto entity : entities)
+		manager->add<TestComponent>(entity)->counter = &counter;
+
+	manager->update();
+	if (manager->hasPendingGarbage())
+		throw runtime_error("Bad pending garbage state without removal.");
+
+	for (uint32_t i = 0; i < entityCount / 2; i++)
+	{
+		manager->remove<TestComponent>(entities[i]);
+		manager->destroy(entities[i + entityCount / 2]);
+	}
+
+	manager->setDisposeBudget(3);
+	manager->update();
+
+	if (!manager->hasPendingGarbage() || manager->getGarbageComponents().size() != 2 || counter != entityCount)
+		throw runtime_error("Bad garbage state after budgeted update.");
+	if (manager->isGarbage<TestComponent>(entities[2]) || !manager->isGarbage<TestComponent>(entities[3]) ||
+		!manager->isValid(entities[entityCount - 1]) || manager->getEntities().getCount() != entityCount)
+	{
+		throw runtime_error("Bad not yet disposed garbage state.");
+	}
+
+	manager->update();
+	if (!manager->getGarbageComponents().empty() || counter != entityCount - 1)
+		throw runtime_error("Bad system component state after budgeted update.");
+
+	uint32_t updateCount = 2;
+	while (manager->hasPendingGarbage())
+	{
+		manager->update();
+		updateCount++;
+	}
+
+	if (updateCount < 5 || counter != 0 || manager->get<TestSystem>()->getComponentCount() != 0)
+		throw runtime_error("Bad garbage state after budgeted dispose.");
+	if (manager->isValid(entities[entityCount - 1]) || manager->getEntities().getCount() != entityCount / 2)
+		throw runtime_error("Bad entity state after budgeted dispose.");
+
+	manager->createSystem<ParticleSystem>();
+	manager->createSystem<VelocitySystem>();
+	auto entity = manager->createEntity();
+	manager->add<TestComponent>(entity)->counter = &counter;
+	manager->add<ParticleComponent>(entity);
+	manager->add<VelocityComponent>(entity);
+	manager->remove<TestComponent>(entity);
+	manager->remove<ParticleComponent>(entity);
+	manager->remove<VelocityComponent>(entity);
+
+	manager->setDisposeBudget(1);
+	manager->update();
+	if (manager->getGarbageComponents().size() != 2 || !manager->isGarbage<VelocityComponent>(entity))
+		throw runtime_error("Bad garbage state before component re-add.");
+
+	manager->add<TestComponent>(entity);
+	manager->add<ParticleComponent>(entity);
+	manager->add<VelocityComponent>(entity);
+	if (!manager->getGarbageComponents().empty() || manager->isGarbage<VelocityComponent>(entity) ||
+		!manager->has<TestComponent>(entity) || !manager->has<ParticleComponent>(entity) ||
+		!manager->has<VelocityComponent>(entity))
+	{
+		throw runtime_error("Bad component state after budgeted re-add.");
+	}
+
+	while (manager->hasPendingGarbage())
+		manager->update();
+	if (counter != -1 || manager->get<ParticleSystem>()->getComponents().getCount() != 1 ||
+		!manager->getArchetypes().has(entity, manager->get<VelocitySystem>()->getStorageType()))
+	{
+		throw runtime_error("Bad system component state after budgeted re-add.");
+	}
+
+	manager->destroy(entity);
+	if (!manager->disposeGarbage(0, 1000000000) || manager->hasPendingGarbage())
+		throw runtime_error("Bad time budgeted garbage dispose.");
+
+	delete manager;
+}
+
 //**********************************************************************************************************************
 int main()
 {
@@ -288,5 +2284,33 @@ int main()
 	testEntityAllocation();
 	testComponentCopy();
 	testDisposeFlow();
-	// TODO: test Ref<> and other manager functions
+	testEntityComponents();
+	testPoolDispose();
+	testPoolIteration();
+	testPoolFreePolicy();
+	testChunkedPool();
+	testArchetypeStorage();
+	testQueries();
+	testThreadPool();
+	testSchedule();
+	testEventHandles();
+	testDelegates();
+	testBatchCreation();
+	testPrefabs();
+	testPoolCapacity();
+	testMemoryResource();
+	testPoolConstruction();
+	testPoolRefs();
+	testStaleIDs();
+	testCommandBuffers();
+	testReadPhase();
+	testProfiler();
+	testSnapshot();
+	testChangeTracking();
+	testMultipleWorlds();
+	testStaticTypeIDs();
+	testSystemLookup();
+	testSoaComponents();
+	testDisposeBudget();
+	// TODO: test other manager functions
 }
\ No newline at end of file